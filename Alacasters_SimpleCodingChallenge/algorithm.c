@@ -0,0 +1,897 @@
+#include "algorithm.h"
+#include "cstring.h"
+#include "customerror.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ALG_INSERTION_LIMIT 16
+
+// State for the generic paths.  Elements are elemSize bytes, scratch holds one element.
+typedef struct alg_context
+{
+	char* base;
+	size_t elemSize;
+	element_compare compare;
+	void* user;
+	const container* cont;
+	bool bitwise;
+	char* scratch;
+}alg_context;
+
+// Sort key for cstring elements, index breaks ties so any sort of keys is stable
+typedef struct alg_key
+{
+	const char* data;
+	size_t length, index;
+}alg_key;
+
+// Private forward declarations
+bool alg_context_construct( alg_context* ctx, container* cont, element_compare compare, void* user );
+void alg_context_destroy( alg_context* ctx );
+char* alg_at( const alg_context* ctx, const size_t idx );
+int alg_cmp( const alg_context* ctx, const size_t a, const size_t b );
+void alg_move( const alg_context* ctx, char* src, char* dst, const size_t count );
+void alg_swap( const alg_context* ctx, const size_t a, const size_t b );
+void alg_insertion_sort( const alg_context* ctx, const size_t first, const size_t last );
+void alg_sift_down( const alg_context* ctx, const size_t first, size_t root, const size_t count );
+void alg_heap_sort( const alg_context* ctx, const size_t first, const size_t last );
+size_t alg_partition_pivot( const alg_context* ctx, const size_t first, const size_t last );
+void alg_introsort( const alg_context* ctx, size_t first, size_t last, size_t depth );
+void alg_merge_sort( const alg_context* ctx, const size_t first, const size_t last, char* buffer );
+size_t alg_depth_limit( size_t count );
+bool alg_typed( const container* cont, element_compare compare, element_compare expected, const size_t elemSize );
+bool alg_sort_cstring( container* cont );
+
+
+// Typed paths.  ALG_DEFINE_SORT generates an introsort for T* ranges with LESS( a, b ) inlined,
+// ALG_DEFINE_TYPED adds a merge sort, introselect and bounds.
+#define ALG_DEFINE_SORT( suffix, T, LESS ) \
+static void alg_insertion_##suffix( T* first, T* last ) \
+{ \
+	for( T* it = first + 1; it < last; ++it ) \
+	{ \
+		const T value = *it; \
+		T* hole = it; \
+		for( ; hole > first && LESS( &value, hole - 1 ); --hole ) \
+		{ \
+			*hole = *( hole - 1 ); \
+		} \
+		*hole = value; \
+	} \
+} \
+static void alg_sift_##suffix( T* first, size_t root, const size_t count ) \
+{ \
+	const T value = first[ root ]; \
+	for( size_t child = 2 * root + 1; child < count; child = 2 * root + 1 ) \
+	{ \
+		if( child + 1 < count && LESS( &first[ child ], &first[ child + 1 ] ) ) \
+		{ \
+			++child; \
+		} \
+		if( LESS( &value, &first[ child ] ) == false ) \
+		{ \
+			break; \
+		} \
+		first[ root ] = first[ child ]; \
+		root = child; \
+	} \
+	first[ root ] = value; \
+} \
+static void alg_heap_##suffix( T* first, T* last ) \
+{ \
+	const size_t count = ( size_t )( last - first ); \
+	for( size_t i = count / 2; i-- > 0; ) \
+	{ \
+		alg_sift_##suffix( first, i, count ); \
+	} \
+	for( size_t end = count - 1; end > 0; --end ) \
+	{ \
+		const T top = first[ 0 ]; \
+		first[ 0 ] = first[ end ]; \
+		first[ end ] = top; \
+		alg_sift_##suffix( first, 0, end ); \
+	} \
+} \
+static T* alg_pivot_##suffix( T* first, T* last ) \
+{ \
+	/* Median of three ends up at first, last - 1 then bounds the left scan */ \
+	T* mid = first + ( last - first ) / 2; \
+	T* back = last - 1; \
+	T temp; \
+	if( LESS( mid, first ) ) { temp = *mid; *mid = *first; *first = temp; } \
+	if( LESS( back, mid ) ) { temp = *back; *back = *mid; *mid = temp; } \
+	if( LESS( mid, first ) ) { temp = *mid; *mid = *first; *first = temp; } \
+	temp = *mid; *mid = *first; *first = temp; \
+\
+	T* i = first; \
+	T* j = last; \
+	for( ;; ) \
+	{ \
+		do { ++i; } while( LESS( i, first ) ); \
+		do { --j; } while( LESS( first, j ) ); \
+		if( i >= j ) \
+		{ \
+			break; \
+		} \
+		temp = *i; *i = *j; *j = temp; \
+	} \
+	temp = *j; *j = *first; *first = temp; \
+	return j; \
+} \
+static void alg_introsort_##suffix( T* first, T* last, size_t depth ) \
+{ \
+	while( last - first > ALG_INSERTION_LIMIT ) \
+	{ \
+		if( depth == 0 ) \
+		{ \
+			alg_heap_##suffix( first, last ); \
+			return; \
+		} \
+		--depth; \
+\
+		/* Recurse into the smaller side to bound the stack */ \
+		T* cut = alg_pivot_##suffix( first, last ); \
+		if( cut - first < last - cut ) \
+		{ \
+			alg_introsort_##suffix( first, cut, depth ); \
+			first = cut + 1; \
+		} \
+		else \
+		{ \
+			alg_introsort_##suffix( cut + 1, last, depth ); \
+			last = cut; \
+		} \
+	} \
+	alg_insertion_##suffix( first, last ); \
+}
+
+#define ALG_DEFINE_TYPED( suffix, T, LESS ) \
+ALG_DEFINE_SORT( suffix, T, LESS ) \
+static void alg_merge_##suffix( T* first, T* last, T* buffer ) \
+{ \
+	if( last - first <= ALG_INSERTION_LIMIT ) \
+	{ \
+		alg_insertion_##suffix( first, last ); \
+		return; \
+	} \
+\
+	T* mid = first + ( last - first ) / 2; \
+	alg_merge_##suffix( first, mid, buffer ); \
+	alg_merge_##suffix( mid, last, buffer ); \
+	if( LESS( mid, mid - 1 ) == false ) \
+	{ \
+		return; \
+	} \
+\
+	const size_t left = ( size_t )( mid - first ); \
+	memcpy( buffer, first, left * sizeof( T ) ); \
+	T* in = buffer; \
+	T* inEnd = buffer + left; \
+	T* out = first; \
+	while( in < inEnd && mid < last ) \
+	{ \
+		*out++ = LESS( mid, in ) ? *mid++ : *in++; \
+	} \
+	memcpy( out, in, ( size_t )( inEnd - in ) * sizeof( T ) ); \
+} \
+static void alg_select_##suffix( T* first, T* last, T* nth, size_t depth ) \
+{ \
+	while( last - first > ALG_INSERTION_LIMIT ) \
+	{ \
+		if( depth == 0 ) \
+		{ \
+			alg_heap_##suffix( first, last ); \
+			return; \
+		} \
+		--depth; \
+\
+		T* cut = alg_pivot_##suffix( first, last ); \
+		if( cut == nth ) \
+		{ \
+			return; \
+		} \
+		if( nth < cut ) \
+		{ \
+			last = cut; \
+		} \
+		else \
+		{ \
+			first = cut + 1; \
+		} \
+	} \
+	alg_insertion_##suffix( first, last ); \
+} \
+static size_t alg_lower_##suffix( const T* first, const size_t count, const T* value ) \
+{ \
+	/* Branch free halving, the compare result only selects the next base */ \
+	if( count == 0 ) \
+	{ \
+		return 0; \
+	} \
+	const T* base = first; \
+	for( size_t n = count; n > 1; ) \
+	{ \
+		const size_t half = n / 2; \
+		base = LESS( &base[ half ], value ) ? base + half : base; \
+		n -= half; \
+	} \
+	return ( size_t )( base - first ) + ( LESS( base, value ) ? 1 : 0 ); \
+} \
+static size_t alg_upper_##suffix( const T* first, const size_t count, const T* value ) \
+{ \
+	if( count == 0 ) \
+	{ \
+		return 0; \
+	} \
+	const T* base = first; \
+	for( size_t n = count; n > 1; ) \
+	{ \
+		const size_t half = n / 2; \
+		base = LESS( value, &base[ half ] ) ? base : base + half; \
+		n -= half; \
+	} \
+	return ( size_t )( base - first ) + ( LESS( value, base ) ? 0 : 1 ); \
+}
+
+#define ALG_LESS( a, b ) ( *( a ) < *( b ) )
+// NaN orders after every number so the ordering stays strict and weak
+#define ALG_LESS_DOUBLE( a, b ) ( *( a ) < *( b ) || ( *( b ) != *( b ) && *( a ) == *( a ) ) )
+#define ALG_LESS_KEY( a, b ) alg_key_less( a, b )
+
+static __inline bool alg_key_less( const alg_key* a, const alg_key* b )
+{
+	const size_t common = a->length < b->length ? a->length : b->length;
+	const int order = memcmp( a->data, b->data, common );
+	if( order != 0 )
+	{
+		return order < 0;
+	}
+	if( a->length != b->length )
+	{
+		return a->length < b->length;
+	}
+	return a->index < b->index;
+}
+
+ALG_DEFINE_TYPED( i32, int32_t, ALG_LESS )
+ALG_DEFINE_TYPED( i64, int64_t, ALG_LESS )
+ALG_DEFINE_TYPED( u64, uint64_t, ALG_LESS )
+ALG_DEFINE_TYPED( f64, double, ALG_LESS_DOUBLE )
+// Keys only ever need sorting, see alg_sort_cstring
+ALG_DEFINE_SORT( key, alg_key, ALG_LESS_KEY )
+
+// Expands to a return from the calling function when cont holds T elements compared by expected
+#define ALG_DISPATCH( cont, compare, expected, T, call ) \
+	if( alg_typed( cont, compare, expected, sizeof( T ) ) ) \
+	{ \
+		T* first = ( T* )cont_ptr_begin( cont ); \
+		T* last = ( T* )cont_ptr_end( cont ); \
+		( void )first; \
+		( void )last; \
+		call; \
+		err_set_ok(); \
+		return true; \
+	}
+
+
+// Public definitions
+int alg_compare_int32( const void* a, const void* b, void* user )
+{
+	( void )user;
+	const int32_t x = *( const int32_t* )a, y = *( const int32_t* )b;
+	return ( x > y ) - ( x < y );
+}
+int alg_compare_int64( const void* a, const void* b, void* user )
+{
+	( void )user;
+	const int64_t x = *( const int64_t* )a, y = *( const int64_t* )b;
+	return ( x > y ) - ( x < y );
+}
+int alg_compare_uint64( const void* a, const void* b, void* user )
+{
+	( void )user;
+	const uint64_t x = *( const uint64_t* )a, y = *( const uint64_t* )b;
+	return ( x > y ) - ( x < y );
+}
+int alg_compare_double( const void* a, const void* b, void* user )
+{
+	( void )user;
+	const double* x = ( const double* )a;
+	const double* y = ( const double* )b;
+	return ALG_LESS_DOUBLE( y, x ) - ALG_LESS_DOUBLE( x, y );
+}
+int alg_compare_cstring( const void* a, const void* b, void* user )
+{
+	( void )user;
+	const cstring* x = ( const cstring* )a;
+	const cstring* y = ( const cstring* )b;
+	const size_t xLength = x->size( x ), yLength = y->size( y );
+
+	const int order = memcmp( x->str( x ), y->str( y ), xLength < yLength ? xLength : yLength );
+	if( order != 0 )
+	{
+		return order;
+	}
+	return ( xLength > yLength ) - ( xLength < yLength );
+}
+
+_Bool alg_sort( container* cont, element_compare compare, void* user )
+{
+	if( cont == nullptr || compare == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	const size_t size = cont->size( cont );
+	const size_t depth = alg_depth_limit( size );
+	ALG_DISPATCH( cont, compare, alg_compare_int32, int32_t, alg_introsort_i32( first, last, depth ) )
+	ALG_DISPATCH( cont, compare, alg_compare_int64, int64_t, alg_introsort_i64( first, last, depth ) )
+	ALG_DISPATCH( cont, compare, alg_compare_uint64, uint64_t, alg_introsort_u64( first, last, depth ) )
+	ALG_DISPATCH( cont, compare, alg_compare_double, double, alg_introsort_f64( first, last, depth ) )
+	if( compare == alg_compare_cstring && cont_elem_size( cont ) == sizeof( cstring ) )
+	{
+		return alg_sort_cstring( cont );
+	}
+
+	alg_context ctx;
+	if( alg_context_construct( &ctx, cont, compare, user ) == false )
+	{
+		return false;
+	}
+
+	alg_introsort( &ctx, 0, size, depth );
+	alg_context_destroy( &ctx );
+
+	err_set_ok();
+	return true;
+}
+_Bool alg_stable_sort( container* cont, element_compare compare, void* user )
+{
+	if( cont == nullptr || compare == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	// Keys carry their index, the cstring path is stable as it is
+	if( compare == alg_compare_cstring && cont_elem_size( cont ) == sizeof( cstring ) )
+	{
+		return alg_sort_cstring( cont );
+	}
+
+	const size_t size = cont->size( cont );
+	char* buffer = ( char* )malloc( ( size / 2 + 1 ) * cont_elem_size( cont ) );
+	if( buffer == nullptr )
+	{
+		err_set_result( Result_Bad_Alloc );
+		return false;
+	}
+
+	bool typed = true;
+	if( alg_typed( cont, compare, alg_compare_int32, sizeof( int32_t ) ) )
+	{
+		alg_merge_i32( ( int32_t* )cont_ptr_begin( cont ), ( int32_t* )cont_ptr_end( cont ), ( int32_t* )buffer );
+	}
+	else if( alg_typed( cont, compare, alg_compare_int64, sizeof( int64_t ) ) )
+	{
+		alg_merge_i64( ( int64_t* )cont_ptr_begin( cont ), ( int64_t* )cont_ptr_end( cont ), ( int64_t* )buffer );
+	}
+	else if( alg_typed( cont, compare, alg_compare_uint64, sizeof( uint64_t ) ) )
+	{
+		alg_merge_u64( ( uint64_t* )cont_ptr_begin( cont ), ( uint64_t* )cont_ptr_end( cont ), ( uint64_t* )buffer );
+	}
+	else if( alg_typed( cont, compare, alg_compare_double, sizeof( double ) ) )
+	{
+		alg_merge_f64( ( double* )cont_ptr_begin( cont ), ( double* )cont_ptr_end( cont ), ( double* )buffer );
+	}
+	else
+	{
+		typed = false;
+	}
+
+	bool result = true;
+	if( typed == false )
+	{
+		alg_context ctx;
+		result = alg_context_construct( &ctx, cont, compare, user );
+		if( result )
+		{
+			alg_merge_sort( &ctx, 0, size, buffer );
+			alg_context_destroy( &ctx );
+		}
+	}
+
+	free( buffer );
+	if( result )
+	{
+		err_set_ok();
+	}
+	return result;
+}
+_Bool alg_nth_element( container* cont, const size_t nth, element_compare compare, void* user )
+{
+	if( cont == nullptr || compare == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	const size_t size = cont->size( cont );
+	if( nth >= size )
+	{
+		err_set_result( Result_Index_Out_Of_Range );
+		return false;
+	}
+
+	const size_t depth = alg_depth_limit( size );
+	ALG_DISPATCH( cont, compare, alg_compare_int32, int32_t, alg_select_i32( first, last, first + nth, depth ) )
+	ALG_DISPATCH( cont, compare, alg_compare_int64, int64_t, alg_select_i64( first, last, first + nth, depth ) )
+	ALG_DISPATCH( cont, compare, alg_compare_uint64, uint64_t, alg_select_u64( first, last, first + nth, depth ) )
+	ALG_DISPATCH( cont, compare, alg_compare_double, double, alg_select_f64( first, last, first + nth, depth ) )
+
+	alg_context ctx;
+	if( alg_context_construct( &ctx, cont, compare, user ) == false )
+	{
+		return false;
+	}
+
+	size_t first = 0, last = size;
+	size_t remaining = depth;
+	while( last - first > ALG_INSERTION_LIMIT )
+	{
+		if( remaining == 0 )
+		{
+			alg_heap_sort( &ctx, first, last );
+			break;
+		}
+		--remaining;
+
+		const size_t cut = alg_partition_pivot( &ctx, first, last );
+		if( cut == nth )
+		{
+			break;
+		}
+		if( nth < cut )
+		{
+			last = cut;
+		}
+		else
+		{
+			first = cut + 1;
+		}
+	}
+	if( last - first <= ALG_INSERTION_LIMIT )
+	{
+		alg_insertion_sort( &ctx, first, last );
+	}
+	alg_context_destroy( &ctx );
+
+	err_set_ok();
+	return true;
+}
+size_t alg_partition( container* cont, element_predicate predicate, void* user )
+{
+	if( cont == nullptr || predicate == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return 0;
+	}
+
+	alg_context ctx;
+	if( alg_context_construct( &ctx, cont, nullptr, nullptr ) == false )
+	{
+		return 0;
+	}
+
+	// Swap the first non matching element from the front with the last matching one from the back
+	size_t i = 0, j = cont->size( cont );
+	for( ;; )
+	{
+		while( i < j && predicate( alg_at( &ctx, i ), user ) )
+		{
+			++i;
+		}
+		while( i < j && predicate( alg_at( &ctx, j - 1 ), user ) == false )
+		{
+			--j;
+		}
+		if( i >= j )
+		{
+			break;
+		}
+
+		alg_swap( &ctx, i, j - 1 );
+		++i;
+		--j;
+	}
+	alg_context_destroy( &ctx );
+
+	err_set_ok();
+	return i;
+}
+size_t alg_lower_bound( const container* cont, const void* value, element_compare compare, void* user )
+{
+	if( cont == nullptr || value == nullptr || compare == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return 0;
+	}
+
+	err_set_ok();
+
+	const size_t size = cont->size( cont );
+	const char* base = ( const char* )cont_ptr_begin( cont );
+	if( alg_typed( cont, compare, alg_compare_int32, sizeof( int32_t ) ) )
+	{
+		return alg_lower_i32( ( const int32_t* )base, size, ( const int32_t* )value );
+	}
+	if( alg_typed( cont, compare, alg_compare_int64, sizeof( int64_t ) ) )
+	{
+		return alg_lower_i64( ( const int64_t* )base, size, ( const int64_t* )value );
+	}
+	if( alg_typed( cont, compare, alg_compare_uint64, sizeof( uint64_t ) ) )
+	{
+		return alg_lower_u64( ( const uint64_t* )base, size, ( const uint64_t* )value );
+	}
+	if( alg_typed( cont, compare, alg_compare_double, sizeof( double ) ) )
+	{
+		return alg_lower_f64( ( const double* )base, size, ( const double* )value );
+	}
+
+	const size_t elemSize = cont_elem_size( cont );
+	size_t first = 0, count = size;
+	while( count > 0 )
+	{
+		const size_t half = count / 2;
+		if( compare( &base[ ( first + half ) * elemSize ], value, user ) < 0 )
+		{
+			first += half + 1;
+			count -= half + 1;
+		}
+		else
+		{
+			count = half;
+		}
+	}
+	return first;
+}
+size_t alg_upper_bound( const container* cont, const void* value, element_compare compare, void* user )
+{
+	if( cont == nullptr || value == nullptr || compare == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return 0;
+	}
+
+	err_set_ok();
+
+	const size_t size = cont->size( cont );
+	const char* base = ( const char* )cont_ptr_begin( cont );
+	if( alg_typed( cont, compare, alg_compare_int32, sizeof( int32_t ) ) )
+	{
+		return alg_upper_i32( ( const int32_t* )base, size, ( const int32_t* )value );
+	}
+	if( alg_typed( cont, compare, alg_compare_int64, sizeof( int64_t ) ) )
+	{
+		return alg_upper_i64( ( const int64_t* )base, size, ( const int64_t* )value );
+	}
+	if( alg_typed( cont, compare, alg_compare_uint64, sizeof( uint64_t ) ) )
+	{
+		return alg_upper_u64( ( const uint64_t* )base, size, ( const uint64_t* )value );
+	}
+	if( alg_typed( cont, compare, alg_compare_double, sizeof( double ) ) )
+	{
+		return alg_upper_f64( ( const double* )base, size, ( const double* )value );
+	}
+
+	const size_t elemSize = cont_elem_size( cont );
+	size_t first = 0, count = size;
+	while( count > 0 )
+	{
+		const size_t half = count / 2;
+		if( compare( value, &base[ ( first + half ) * elemSize ], user ) >= 0 )
+		{
+			first += half + 1;
+			count -= half + 1;
+		}
+		else
+		{
+			count = half;
+		}
+	}
+	return first;
+}
+size_t alg_unique( container* cont, element_compare compare, void* user )
+{
+	if( cont == nullptr || compare == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return 0;
+	}
+
+	const size_t size = cont->size( cont );
+	if( size < 2 )
+	{
+		err_set_ok();
+		return size;
+	}
+
+	alg_context ctx;
+	if( alg_context_construct( &ctx, cont, compare, user ) == false )
+	{
+		return size;
+	}
+
+	// Duplicates are swapped towards the back and erased together, so the container destroys them
+	size_t kept = 0;
+	for( size_t i = 1; i < size; ++i )
+	{
+		if( alg_cmp( &ctx, kept, i ) != 0 )
+		{
+			++kept;
+			alg_swap( &ctx, kept, i );
+		}
+	}
+	alg_context_destroy( &ctx );
+
+	cont->erase_range( cont, kept + 1, size );
+	return kept + 1;
+}
+
+
+// Private definitions
+bool alg_context_construct( alg_context* ctx, container* cont, element_compare compare, void* user )
+{
+	ctx->base = ( char* )cont_ptr_begin( cont );
+	ctx->elemSize = cont_elem_size( cont );
+	ctx->compare = compare;
+	ctx->user = user;
+	ctx->cont = cont;
+	ctx->bitwise = cont_bitwise_relocatable( cont );
+	ctx->scratch = ( char* )malloc( ctx->elemSize );
+	if( ctx->scratch == nullptr )
+	{
+		err_set_result( Result_Bad_Alloc );
+		return false;
+	}
+
+	return true;
+}
+void alg_context_destroy( alg_context* ctx )
+{
+	free( ctx->scratch );
+	ctx->scratch = nullptr;
+}
+char* alg_at( const alg_context* ctx, const size_t idx )
+{
+	return &ctx->base[ idx * ctx->elemSize ];
+}
+int alg_cmp( const alg_context* ctx, const size_t a, const size_t b )
+{
+	return ctx->compare( alg_at( ctx, a ), alg_at( ctx, b ), ctx->user );
+}
+void alg_move( const alg_context* ctx, char* src, char* dst, const size_t count )
+{
+	if( ctx->bitwise )
+	{
+		memmove( dst, src, count * ctx->elemSize );
+	}
+	else
+	{
+		cont_relocate( ctx->cont, src, dst, count );
+	}
+}
+void alg_swap( const alg_context* ctx, const size_t a, const size_t b )
+{
+	if( a == b )
+	{
+		return;
+	}
+
+	alg_move( ctx, alg_at( ctx, a ), ctx->scratch, 1 );
+	alg_move( ctx, alg_at( ctx, b ), alg_at( ctx, a ), 1 );
+	alg_move( ctx, ctx->scratch, alg_at( ctx, b ), 1 );
+}
+void alg_insertion_sort( const alg_context* ctx, const size_t first, const size_t last )
+{
+	for( size_t i = first + 1; i < last; ++i )
+	{
+		if( alg_cmp( ctx, i, i - 1 ) >= 0 )
+		{
+			continue;
+		}
+
+		// Lift the element out and shift the larger ones up one place
+		alg_move( ctx, alg_at( ctx, i ), ctx->scratch, 1 );
+		size_t hole = i;
+		do
+		{
+			alg_move( ctx, alg_at( ctx, hole - 1 ), alg_at( ctx, hole ), 1 );
+			--hole;
+		} while( hole > first && ctx->compare( ctx->scratch, alg_at( ctx, hole - 1 ), ctx->user ) < 0 );
+		alg_move( ctx, ctx->scratch, alg_at( ctx, hole ), 1 );
+	}
+}
+void alg_sift_down( const alg_context* ctx, const size_t first, size_t root, const size_t count )
+{
+	for( size_t child = 2 * root + 1; child < count; child = 2 * root + 1 )
+	{
+		if( child + 1 < count && alg_cmp( ctx, first + child, first + child + 1 ) < 0 )
+		{
+			++child;
+		}
+		if( alg_cmp( ctx, first + root, first + child ) >= 0 )
+		{
+			break;
+		}
+
+		alg_swap( ctx, first + root, first + child );
+		root = child;
+	}
+}
+void alg_heap_sort( const alg_context* ctx, const size_t first, const size_t last )
+{
+	const size_t count = last - first;
+	for( size_t i = count / 2; i-- > 0; )
+	{
+		alg_sift_down( ctx, first, i, count );
+	}
+	for( size_t end = count - 1; end > 0; --end )
+	{
+		alg_swap( ctx, first, first + end );
+		alg_sift_down( ctx, first, 0, end );
+	}
+}
+size_t alg_partition_pivot( const alg_context* ctx, const size_t first, const size_t last )
+{
+	// Median of three ends up at first, last - 1 then bounds the left scan
+	const size_t mid = first + ( last - first ) / 2;
+	if( alg_cmp( ctx, mid, first ) < 0 )
+	{
+		alg_swap( ctx, mid, first );
+	}
+	if( alg_cmp( ctx, last - 1, mid ) < 0 )
+	{
+		alg_swap( ctx, last - 1, mid );
+	}
+	if( alg_cmp( ctx, mid, first ) < 0 )
+	{
+		alg_swap( ctx, mid, first );
+	}
+	alg_swap( ctx, mid, first );
+
+	size_t i = first, j = last;
+	for( ;; )
+	{
+		do
+		{
+			++i;
+		} while( alg_cmp( ctx, i, first ) < 0 );
+		do
+		{
+			--j;
+		} while( alg_cmp( ctx, first, j ) < 0 );
+		if( i >= j )
+		{
+			break;
+		}
+		alg_swap( ctx, i, j );
+	}
+	alg_swap( ctx, first, j );
+	return j;
+}
+void alg_introsort( const alg_context* ctx, size_t first, size_t last, size_t depth )
+{
+	while( last - first > ALG_INSERTION_LIMIT )
+	{
+		if( depth == 0 )
+		{
+			alg_heap_sort( ctx, first, last );
+			return;
+		}
+		--depth;
+
+		// Recurse into the smaller side to bound the stack
+		const size_t cut = alg_partition_pivot( ctx, first, last );
+		if( cut - first < last - cut )
+		{
+			alg_introsort( ctx, first, cut, depth );
+			first = cut + 1;
+		}
+		else
+		{
+			alg_introsort( ctx, cut + 1, last, depth );
+			last = cut;
+		}
+	}
+	alg_insertion_sort( ctx, first, last );
+}
+void alg_merge_sort( const alg_context* ctx, const size_t first, const size_t last, char* buffer )
+{
+	if( last - first <= ALG_INSERTION_LIMIT )
+	{
+		alg_insertion_sort( ctx, first, last );
+		return;
+	}
+
+	const size_t mid = first + ( last - first ) / 2;
+	alg_merge_sort( ctx, first, mid, buffer );
+	alg_merge_sort( ctx, mid, last, buffer );
+	if( alg_cmp( ctx, mid - 1, mid ) <= 0 )
+	{
+		return;
+	}
+
+	// Move the left run out, then merge back into the front.  The output never overtakes the right run.
+	const size_t left = mid - first;
+	alg_move( ctx, alg_at( ctx, first ), buffer, left );
+
+	size_t in = 0, right = mid, out = first;
+	while( in < left && right < last )
+	{
+		char* from = &buffer[ in * ctx->elemSize ];
+		if( ctx->compare( alg_at( ctx, right ), from, ctx->user ) < 0 )
+		{
+			from = alg_at( ctx, right++ );
+		}
+		else
+		{
+			++in;
+		}
+		alg_move( ctx, from, alg_at( ctx, out++ ), 1 );
+	}
+	alg_move( ctx, &buffer[ in * ctx->elemSize ], alg_at( ctx, out ), left - in );
+}
+size_t alg_depth_limit( size_t count )
+{
+	size_t depth = 0;
+	for( ; count > 1; count >>= 1 )
+	{
+		depth += 2;
+	}
+	return depth;
+}
+bool alg_typed( const container* cont, element_compare compare, element_compare expected, const size_t elemSize )
+{
+	return compare == expected && cont_elem_size( cont ) == elemSize && cont_bitwise_relocatable( cont );
+}
+bool alg_sort_cstring( container* cont )
+{
+	const size_t size = cont->size( cont );
+	const size_t elemSize = cont_elem_size( cont );
+	char* base = ( char* )cont_ptr_begin( cont );
+
+	// Sort ( data, length, index ) keys with memcmp inlined, then move the headers once into sorted order
+	alg_key* keys = ( alg_key* )malloc( size * sizeof( alg_key ) + 1 );
+	char* sorted = ( char* )malloc( size * elemSize + 1 );
+	if( keys == nullptr || sorted == nullptr )
+	{
+		free( keys );
+		free( sorted );
+		err_set_result( Result_Bad_Alloc );
+		return false;
+	}
+
+	for( size_t i = 0; i < size; ++i )
+	{
+		const cstring* str = ( const cstring* )&base[ i * elemSize ];
+		keys[ i ].data = str->str( str );
+		keys[ i ].length = str->size( str );
+		keys[ i ].index = i;
+	}
+	alg_introsort_key( keys, keys + size, alg_depth_limit( size ) );
+
+	for( size_t i = 0; i < size; ++i )
+	{
+		cont_relocate( cont, &base[ keys[ i ].index * elemSize ], &sorted[ i * elemSize ], 1 );
+	}
+	cont_relocate( cont, sorted, base, size );
+
+	free( keys );
+	free( sorted );
+
+	err_set_ok();
+	return true;
+}
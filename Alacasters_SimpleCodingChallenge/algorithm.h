@@ -0,0 +1,37 @@
+#pragma once
+
+#include "defines.h"
+#include "utility.h"
+#include <stddef.h>
+
+// Returns less than zero, zero or greater than zero as a orders before, equal to or after b
+typedef int( *element_compare )( const void* a, const void* b, void* user );
+
+// Comparators with specialized paths.  Passing one of these to the algorithms below selects a
+// loop with the comparison inlined when the element size matches, any other comparator is called per compare.
+// alg_compare_cstring orders cstring elements bytewise, shorter first on a common prefix.
+int alg_compare_int32( const void* a, const void* b, void* user );
+int alg_compare_int64( const void* a, const void* b, void* user );
+int alg_compare_uint64( const void* a, const void* b, void* user );
+int alg_compare_double( const void* a, const void* b, void* user );
+int alg_compare_cstring( const void* a, const void* b, void* user );
+
+// Elements are only ever moved, through the container's relocate hook, never copied.
+// alg_sort is an introsort, alg_stable_sort a merge sort that keeps equal elements in order.
+_Bool alg_sort( container* cont, element_compare compare, void* user );
+_Bool alg_stable_sort( container* cont, element_compare compare, void* user );
+
+// Moves the element that belongs at nth into place, nothing before it orders after it
+// and nothing after it orders before it.
+_Bool alg_nth_element( container* cont, const size_t nth, element_compare compare, void* user );
+
+// Moves the elements matching predicate to the front and returns how many matched, not stable
+size_t alg_partition( container* cont, element_predicate predicate, void* user );
+
+// The container must be sorted by compare.  Returns the index of the first element not before value,
+// or after value for upper_bound, which is size when there is none.
+size_t alg_lower_bound( const container* cont, const void* value, element_compare compare, void* user );
+size_t alg_upper_bound( const container* cont, const void* value, element_compare compare, void* user );
+
+// Removes every element that compares equal to the element before it and returns the new size
+size_t alg_unique( container* cont, element_compare compare, void* user );
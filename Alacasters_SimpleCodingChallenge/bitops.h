@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdint.h>
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+
+// Bit scanning helpers shared by the mask based scanners.
+// bit_ctz64 is undefined for a value of 0, callers check first.
+
+static __inline unsigned bit_ctz64( uint64_t value )
+{
+#if defined( _MSC_VER ) && defined( _M_X64 )
+	unsigned long idx = 0;
+	_BitScanForward64( &idx, value );
+	return ( unsigned )idx;
+#elif defined( _MSC_VER )
+	unsigned long idx = 0;
+	if( _BitScanForward( &idx, ( unsigned long )value ) )
+	{
+		return ( unsigned )idx;
+	}
+	_BitScanForward( &idx, ( unsigned long )( value >> 32 ) );
+	return ( unsigned )idx + 32;
+#else
+	return ( unsigned )__builtin_ctzll( value );
+#endif
+}
+
+static __inline unsigned bit_popcount64( uint64_t value )
+{
+#if defined( _MSC_VER )
+	value = value - ( ( value >> 1 ) & 0x5555555555555555ull );
+	value = ( value & 0x3333333333333333ull ) + ( ( value >> 2 ) & 0x3333333333333333ull );
+	value = ( value + ( value >> 4 ) ) & 0x0F0F0F0F0F0F0F0Full;
+	return ( unsigned )( ( value * 0x0101010101010101ull ) >> 56 );
+#else
+	return ( unsigned )__builtin_popcountll( value );
+#endif
+}
+
+// Clears the lowest set bit
+static __inline uint64_t bit_clear_lowest( uint64_t value )
+{
+	return value & ( value - 1 );
+}
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define CSAPI_HAVE_SSE2 1
+#endif
+#if defined( __AVX2__ )
+#define CSAPI_HAVE_AVX2 1
+#endif
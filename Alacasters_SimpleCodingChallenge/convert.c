@@ -0,0 +1,326 @@
+#include "convert.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CV_MAX_FALLBACK_CHARS 512
+
+static const char g_digit_pairs[ 201 ] =
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+// Every power of ten up to 1e22 is exact in a double
+static const double g_exact_pow10[ 23 ] =
+{
+	1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+	1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Private forward declarations
+_Bool cv_is_digit( const char c );
+_Bool cv_parse_magnitude( const char* data, const size_t length, const uint64_t limit, uint64_t* value, size_t* used );
+_Bool cv_parse_double_fallback( const char* data, const size_t length, double* value );
+
+
+// Public definitions
+_Bool cv_parse_uint64( const char* data, const size_t length, uint64_t* value, size_t* used )
+{
+	size_t pos = 0;
+	if( length > 0 && data[ 0 ] == '+' )
+	{
+		pos = 1;
+	}
+
+	size_t digits = 0;
+	if( cv_parse_magnitude( data + pos, length - pos, UINT64_MAX, value, &digits ) == false )
+	{
+		return false;
+	}
+
+	*used = pos + digits;
+	return true;
+}
+_Bool cv_parse_int64( const char* data, const size_t length, int64_t* value, size_t* used )
+{
+	size_t pos = 0;
+	_Bool negative = false;
+	if( length > 0 && ( data[ 0 ] == '+' || data[ 0 ] == '-' ) )
+	{
+		negative = data[ 0 ] == '-';
+		pos = 1;
+	}
+
+	uint64_t magnitude = 0;
+	size_t digits = 0;
+	const uint64_t limit = negative ? ( uint64_t )INT64_MAX + 1 : ( uint64_t )INT64_MAX;
+	if( cv_parse_magnitude( data + pos, length - pos, limit, &magnitude, &digits ) == false )
+	{
+		return false;
+	}
+
+	*value = negative ? ( int64_t )( 0 - magnitude ) : ( int64_t )magnitude;
+	*used = pos + digits;
+	return true;
+}
+_Bool cv_parse_double( const char* data, const size_t length, double* value, size_t* used )
+{
+	size_t pos = 0;
+	_Bool negative = false;
+	if( length > 0 && ( data[ 0 ] == '+' || data[ 0 ] == '-' ) )
+	{
+		negative = data[ 0 ] == '-';
+		pos = 1;
+	}
+
+	// inf and nan are rare, let the C library deal with them
+	if( pos < length && ( data[ pos ] == 'i' || data[ pos ] == 'I' || data[ pos ] == 'n' || data[ pos ] == 'N' ) )
+	{
+		char text[ 16 ] = { 0 };
+		const size_t count = length < sizeof( text ) - 1 ? length : sizeof( text ) - 1;
+		char* end = nullptr;
+
+		memcpy( text, data, count );
+		*value = strtod( text, &end );
+		*used = ( size_t )( end - text );
+		return *used > pos;
+	}
+
+	uint64_t mantissa = 0;
+	int significant = 0;
+	int exponent = 0;
+	_Bool anyDigits = false;
+	_Bool truncated = false;
+
+	for( ; pos < length && cv_is_digit( data[ pos ] ); ++pos )
+	{
+		const unsigned digit = ( unsigned )( data[ pos ] - '0' );
+		anyDigits = true;
+		if( significant < 19 )
+		{
+			mantissa = mantissa * 10 + digit;
+			significant += ( mantissa != 0 );
+		}
+		else
+		{
+			++exponent;
+			truncated = truncated || digit != 0;
+		}
+	}
+	if( pos < length && data[ pos ] == '.' )
+	{
+		for( ++pos; pos < length && cv_is_digit( data[ pos ] ); ++pos )
+		{
+			const unsigned digit = ( unsigned )( data[ pos ] - '0' );
+			anyDigits = true;
+			if( significant < 19 )
+			{
+				mantissa = mantissa * 10 + digit;
+				significant += ( mantissa != 0 );
+				--exponent;
+			}
+			else
+			{
+				truncated = truncated || digit != 0;
+			}
+		}
+	}
+	if( anyDigits == false )
+	{
+		return false;
+	}
+
+	// Only take the exponent when at least one digit follows the 'e'
+	if( pos < length && ( data[ pos ] == 'e' || data[ pos ] == 'E' ) )
+	{
+		size_t expPos = pos + 1;
+		_Bool expNegative = false;
+		if( expPos < length && ( data[ expPos ] == '+' || data[ expPos ] == '-' ) )
+		{
+			expNegative = data[ expPos ] == '-';
+			++expPos;
+		}
+		if( expPos < length && cv_is_digit( data[ expPos ] ) )
+		{
+			int explicitExp = 0;
+			for( ; expPos < length && cv_is_digit( data[ expPos ] ); ++expPos )
+			{
+				if( explicitExp < 100000 )
+				{
+					explicitExp = explicitExp * 10 + ( data[ expPos ] - '0' );
+				}
+			}
+			exponent += expNegative ? -explicitExp : explicitExp;
+			pos = expPos;
+		}
+	}
+
+	*used = pos;
+
+	// Exact when both the mantissa and the power of ten are representable
+	if( truncated == false && mantissa <= ( 1ull << 53 ) && exponent >= -22 && exponent <= 22 )
+	{
+		double result = ( double )mantissa;
+		result = exponent < 0 ? result / g_exact_pow10[ -exponent ] : result * g_exact_pow10[ exponent ];
+		*value = negative ? -result : result;
+		return true;
+	}
+
+	return cv_parse_double_fallback( data, pos, value );
+}
+_Bool cv_parse_bool( const char* data, const size_t length, _Bool* value, size_t* used )
+{
+	if( length >= 4 && memcmp( data, "true", 4 ) == 0 )
+	{
+		*value = true;
+		*used = 4;
+		return true;
+	}
+	if( length >= 5 && memcmp( data, "false", 5 ) == 0 )
+	{
+		*value = false;
+		*used = 5;
+		return true;
+	}
+	if( length >= 1 && ( data[ 0 ] == '0' || data[ 0 ] == '1' ) )
+	{
+		*value = data[ 0 ] == '1';
+		*used = 1;
+		return true;
+	}
+
+	return false;
+}
+
+size_t cv_format_uint64( char* out, const uint64_t value )
+{
+	size_t digits = 1;
+	for( uint64_t rest = value; rest >= 10; rest /= 10 )
+	{
+		++digits;
+	}
+
+	// Fill from the back two digits at a time
+	uint64_t rest = value;
+	char* iter = out + digits;
+	while( rest >= 100 )
+	{
+		const size_t pair = ( size_t )( rest % 100 ) * 2;
+		rest /= 100;
+		*--iter = g_digit_pairs[ pair + 1 ];
+		*--iter = g_digit_pairs[ pair ];
+	}
+	if( rest >= 10 )
+	{
+		*--iter = g_digit_pairs[ rest * 2 + 1 ];
+		*--iter = g_digit_pairs[ rest * 2 ];
+	}
+	else
+	{
+		*--iter = ( char )( '0' + rest );
+	}
+
+	return digits;
+}
+size_t cv_format_int64( char* out, const int64_t value )
+{
+	if( value < 0 )
+	{
+		*out = '-';
+		return 1 + cv_format_uint64( out + 1, 0 - ( uint64_t )value );
+	}
+
+	return cv_format_uint64( out, ( uint64_t )value );
+}
+size_t cv_format_double( char* out, const double value )
+{
+	char text[ 32 ];
+
+	// Use the shorter form whenever it reads back as the same value
+	int count = snprintf( text, sizeof( text ), "%.15g", value );
+	if( isfinite( value ) && strtod( text, nullptr ) != value )
+	{
+		count = snprintf( text, sizeof( text ), "%.17g", value );
+	}
+
+	memcpy( out, text, ( size_t )count );
+	return ( size_t )count;
+}
+size_t cv_format_bool( char* out, const _Bool value )
+{
+	if( value )
+	{
+		memcpy( out, "true", 4 );
+		return 4;
+	}
+
+	memcpy( out, "false", 5 );
+	return 5;
+}
+
+
+// Private definitions
+_Bool cv_is_digit( const char c )
+{
+	return ( unsigned )( c - '0' ) < 10;
+}
+_Bool cv_parse_magnitude( const char* data, const size_t length, const uint64_t limit, uint64_t* value, size_t* used )
+{
+	uint64_t result = 0;
+	size_t pos = 0;
+
+	for( ; pos < length && cv_is_digit( data[ pos ] ); ++pos )
+	{
+		const unsigned digit = ( unsigned )( data[ pos ] - '0' );
+		if( result > ( limit - digit ) / 10 )
+		{
+			return false;
+		}
+		result = result * 10 + digit;
+	}
+	if( pos == 0 )
+	{
+		return false;
+	}
+
+	*value = result;
+	*used = pos;
+	return true;
+}
+_Bool cv_parse_double_fallback( const char* data, const size_t length, double* value )
+{
+	// strtod needs a terminated copy, kept on the stack unless the digits run past it
+	char buffer[ CV_MAX_FALLBACK_CHARS ];
+	char* text = length < sizeof( buffer ) ? buffer : ( char* )malloc( length + 1 );
+	if( text == nullptr )
+	{
+		return false;
+	}
+
+	memcpy( text, data, length );
+	text[ length ] = '\0';
+
+	errno = 0;
+	const double result = strtod( text, nullptr );
+	const _Bool overflowed = errno == ERANGE && ( result == HUGE_VAL || result == -HUGE_VAL );
+	if( text != buffer )
+	{
+		free( text );
+	}
+	if( overflowed )
+	{
+		return false;
+	}
+
+	*value = result;
+	return true;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "defines.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Longest text the formatters produce, not counting a null terminator
+#define CV_MAX_INT_CHARS 20
+#define CV_MAX_DOUBLE_CHARS 24
+#define CV_MAX_BOOL_CHARS 5
+
+// Parsers read the longest valid prefix of data, which does not need to be null terminated.
+// used receives the number of characters consumed.  They fail on empty input, on a missing
+// number and on values out of range for the target type.
+_Bool cv_parse_uint64( const char* data, const size_t length, uint64_t* value, size_t* used );
+_Bool cv_parse_int64( const char* data, const size_t length, int64_t* value, size_t* used );
+_Bool cv_parse_double( const char* data, const size_t length, double* value, size_t* used );
+_Bool cv_parse_bool( const char* data, const size_t length, _Bool* value, size_t* used );
+
+// Formatters write without a null terminator and return the number of characters written.
+// out must hold at least the matching CV_MAX_*_CHARS.
+size_t cv_format_uint64( char* out, const uint64_t value );
+size_t cv_format_int64( char* out, const int64_t value );
+size_t cv_format_double( char* out, const double value );
+size_t cv_format_bool( char* out, const _Bool value );
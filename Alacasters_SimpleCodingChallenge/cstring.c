@@ -1,18 +1,12 @@
 #include "cstring.h"
 #include "defines.h"
 #include "memory.h"
+#include "profile.h"
 #include "utility.h"
 #include <stdlib.h>
 #include <assert.h>
 #include <errno.h>
 
-struct _cstring
-{
-	size_t length, capacity;
-	int isConstructed;
-	char* buffer;
-};
-
 // Private forward declarations
 _Bool cs_get( const cstring* this, const size_t idx, char* c );
 _Bool cs_empty( const cstring* this );
@@ -37,6 +31,7 @@ _Bool cs_insert_cstring( cstring* this, size_t offset, const cstring* other );
 
 void cs_destroy( _cstring* this );
 _Bool cs_grow_to( cstring* this, const size_t size );
+size_t cs_memory_usage( const cstring* this );
 
 _Bool cs_isInitialized( const cstring* this );
 
@@ -55,7 +50,7 @@ _Bool cs_default_construct( cstring* this )
 		return false;
 	}
 
-	_cstring* _string = ( _cstring* )malloc( sizeof( _cstring ) );
+	_cstring* _string = ( _cstring* )mem_alloc( MEM_CSTRING, sizeof( _cstring ) );
 	if( _string == nullptr )
 	{
 		err_set_result( Result_Bad_Alloc );
@@ -63,10 +58,10 @@ _Bool cs_default_construct( cstring* this )
 	}
 
 	const size_t capacity = 1;
-	_string->buffer = ( char* )malloc( capacity );
+	_string->buffer = ( char* )mem_alloc( MEM_CSTRING, capacity );
 	if( _string->buffer == nullptr )
 	{
-		free( _string );
+		mem_free( MEM_CSTRING, _string );
 		err_set_result( Result_Bad_Alloc );
 		return false;
 	}
@@ -81,6 +76,7 @@ _Bool cs_default_construct( cstring* this )
 	self.empty = cs_empty;
 	self.size = cs_length;
 	self.str = cs_data;
+	self.memory_usage = cs_memory_usage;
 
 	self.copy = cs_copy;
 	self.find = cs_find;
@@ -101,7 +97,7 @@ _Bool cs_default_construct( cstring* this )
 	self._string = _string;
 
 	*this = self;
-	err_set_result( Result_Ok );
+	err_set_ok();
 
 	return true;
 }
@@ -154,9 +150,37 @@ _Bool cs_string_construct( cstring* this, const char* str )
 
 	return true;
 }
+_Bool cs_buffer_construct( cstring* this, const char* data, const size_t length )
+{
+	if( data == nullptr && length > 0 )
+	{
+		err_set_result( Result_Bad_Pointer );
+		return false;
+	}
+
+	if( cs_default_construct( this ) == false )
+	{
+		return false;
+	}
+	if( cs_reserve( this, length + 1 ) == false )
+	{
+		cs_destroy_cstring( this );
+		err_set_result( Result_Bad_Alloc );
+		return false;
+	}
+
+	if( length > 0 )
+	{
+		memcpy( this->_string->buffer, data, length );
+	}
+	this->_string->buffer[ length ] = 0;
+	this->_string->length = length;
+
+	return true;
+}
 _Bool cs_destroy_cstring( cstring* this )
 {
-	err_set_result( Result_Ok );
+	err_set_ok();
 
 	if( this == nullptr )
 	{
@@ -170,6 +194,7 @@ _Bool cs_destroy_cstring( cstring* this )
 	}
 
 	cs_destroy( this->_string );
+	mem_free( MEM_CSTRING, this->_string );
 
 	this->at_get = nullptr;
 	this->at_set = nullptr;
@@ -188,12 +213,46 @@ _Bool cs_destroy_cstring( cstring* this )
 	this->_string = nullptr;
 	this->size = nullptr;
 	this->str = nullptr;
+	this->memory_usage = nullptr;
 	this->substr = nullptr;
 
-	err_set_result( Result_Ok );
+	err_set_ok();
 	return true;
 }
 
+_Bool cs_append_buffer( cstring* this, const char* data, const size_t length )
+{
+	if( this == nullptr || cs_isInitialized( this ) == false )
+	{
+		err_set_result( Result_Not_Initialized );
+		return false;
+	}
+	if( data == nullptr && length > 0 )
+	{
+		err_set_result( Result_Bad_Pointer );
+		return false;
+	}
+
+	const size_t required = cs_length( this ) + length + 1;
+	if( required > this->_string->capacity )
+	{
+		const size_t grown = ( ( this->_string->capacity * 3 ) / 2 ) + 3;
+		if( cs_grow_to( this, required > grown ? required : grown ) == false )
+		{
+			return false;
+		}
+	}
+
+	if( length > 0 )
+	{
+		memcpy( &this->_string->buffer[ cs_length( this ) ], data, length );
+	}
+	this->_string->length += length;
+	this->_string->buffer[ this->_string->length ] = 0;
+
+	err_set_ok();
+	return true;
+}
 
 // Private definitions
 _Bool cs_get( const cstring* this, const size_t idx, char* c )
@@ -204,7 +263,7 @@ _Bool cs_get( const cstring* this, const size_t idx, char* c )
 		return false;
 	}
 
-	err_set_result( Result_Ok );
+	err_set_ok();
 
 	*c = this->_string->buffer[ idx ];
 
@@ -229,6 +288,7 @@ _Bool cs_copy( const cstring* this, cstring* other )
 	{
 		return false;
 	}
+	mem_count_copy( MEM_CSTRING );
 	for( size_t i = 0; i < cs_length( this ); ++i )
 	{
 		char c = 0;
@@ -244,20 +304,42 @@ _Bool cs_copy( const cstring* this, cstring* other )
 	
 	return true;
 }
+_Bool cs_element_construct( container_func_params params )
+{
+	cstring* this = ( cstring* )params.this;
+	memset( this, 0, sizeof( cstring ) );
+
+	return cs_default_construct( this );
+}
+_Bool cs_element_copy( container_func_params params )
+{
+	cstring* other = ( cstring* )params.other;
+	memset( other, 0, sizeof( cstring ) );
+
+	return cs_copy( ( const cstring* )params.this, other );
+}
+void cs_element_destroy( container_func_params params )
+{
+	cs_destroy_cstring( ( cstring* )params.this );
+}
 _Bool cs_find( const cstring* this, size_t offset, const char c, size_t* foundAt )
 {
-	for( size_t i = offset; i < cs_length( this ); ++i )
+	prof_begin( PROF_CS_FIND );
+
+	bool found = false;
+	for( size_t i = offset; i < cs_length( this ) && found == false; ++i )
 	{
 		char _c = 0;
 		cs_get( this, i, &_c );
 		if( _c == c )
 		{
 			*foundAt = i;
-			return true;
+			found = true;
 		}
 	}
 
-	return false;
+	prof_end( PROF_CS_FIND );
+	return found;
 }
 _Bool cs_substr( const cstring* this, size_t offset, size_t length, cstring* subString )
 {
@@ -363,7 +445,7 @@ _Bool cs_insert( cstring* this, size_t offset, const char c )
 	if( offset == cs_length( this ) )
 	{
 		cs_push_back( this, c );
-		err_set_result( Result_Ok );
+		err_set_ok();
 		return true;
 	}
 
@@ -479,7 +561,7 @@ _Bool cs_insert_cstring( cstring* this, size_t offset, const cstring* other )
 			}
 		}
 
-		err_set_result( Result_Ok );
+		err_set_ok();
 		return true;
 	}
 
@@ -515,20 +597,21 @@ _Bool cs_insert_cstring( cstring* this, size_t offset, const cstring* other )
 	}
 
 	// destroy this 
-	SafeDelete( &this->_string->buffer );
-	SafeDelete( &this->_string );
+	mem_free( MEM_CSTRING, this->_string->buffer );
+	mem_free( MEM_CSTRING, this->_string );
 
 	// Assign temp to this, don't destroy temp
 	*this = temp;
 
-	err_set_result( Result_Ok );
+	err_set_ok();
 	return true;
 
 }
 
 void cs_destroy( _cstring* this )
 {
-	SafeDelete( &this->buffer );
+	mem_free( MEM_CSTRING, this->buffer );
+	this->buffer = nullptr;
 	this->length = 0;
 	this->capacity = 0;
 }
@@ -536,16 +619,17 @@ _Bool cs_grow_to( cstring* this, const size_t size )
 {
 	if( this->_string->capacity >= size )
 	{
-		err_set_result( Result_Ok );
+		err_set_ok();
 		return true;
 	}
 
-	char* buffer = ( char* )malloc( size );
+	char* buffer = ( char* )mem_alloc( MEM_CSTRING, size );
 	if( buffer == nullptr )
 	{
 		err_set_result( Result_Bad_Alloc );
 		return false;
 	}
+	mem_count_grow( MEM_CSTRING );
 
 	memset( buffer, 0, size );
 	if( cs_length( this ) > 0 )
@@ -553,13 +637,17 @@ _Bool cs_grow_to( cstring* this, const size_t size )
 		memcpy( buffer, this->_string->buffer, cs_length( this ) );
 	}
 
-	SafeDelete( &this->_string->buffer );
+	mem_free( MEM_CSTRING, this->_string->buffer );
 	this->_string->buffer = buffer;
 	this->_string->capacity = size;
 
-	err_set_result( Result_Ok );
+	err_set_ok();
 	return true;
 }
+size_t cs_memory_usage( const cstring* this )
+{
+	return sizeof( _cstring ) + this->_string->capacity;
+}
 
 _Bool cs_isInitialized( const cstring* this )
 {
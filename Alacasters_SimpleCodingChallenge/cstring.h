@@ -1,6 +1,7 @@
 #pragma once
 
 #include "customerror.h"
+#include "utility.h"
 #include <ctype.h>
 #include <string.h>
 #include <stdlib.h>
@@ -9,6 +10,21 @@
 typedef struct _cstring _cstring;
 typedef struct cstring cstring;
 
+// Private to cstring.c, the layout is only visible for the unchecked accessors in fastpath.h
+struct _cstring
+{
+	size_t length, capacity;
+	int isConstructed;
+	char* buffer;
+};
+
+// Non-owning view into a character buffer, not null terminated
+typedef struct string_slice
+{
+	const char* data;
+	size_t length;
+}string_slice;
+
 typedef struct cstring
 {
 	// getters
@@ -16,6 +32,8 @@ typedef struct cstring
 	_Bool( *empty )( const cstring* this );
 	size_t( *size )( const cstring* this );
 	const char*( *str )( const cstring* this );
+	// Heap bytes owned by this string, bookkeeping included
+	size_t( *memory_usage )( const cstring* this );
 
 	// utilities
 	_Bool( *copy )( const cstring* this, cstring* other );
@@ -34,7 +52,7 @@ typedef struct cstring
 	_Bool( *at_set )( cstring* this, size_t idx, const char c );
 	_Bool( *insert )( cstring* this, size_t offset, const char c );
 	_Bool( *insert_string )( cstring* this, size_t offset, const char* str );
-	_Bool( *insert_cstring )( cstring* this, size_t offset, cstring* other );
+	_Bool( *insert_cstring )( cstring* this, size_t offset, const cstring* other );
 
 	_cstring* _string;
 }cstring;
@@ -43,5 +61,12 @@ _Bool cs_default_construct( cstring* this );
 _Bool cs_reserve_construct( cstring* this, const size_t size );
 _Bool cs_size_construct( cstring* this, const size_t size, const char fillWith );
 _Bool cs_string_construct( cstring* this, const char* str );
+_Bool cs_buffer_construct( cstring* this, const char* data, const size_t length );
 _Bool cs_destroy_cstring( cstring* this );
+_Bool cs_append_buffer( cstring* this, const char* data, const size_t length );
 _Bool cs_copy( const cstring* this, cstring* other );
+
+// Element hooks for storing cstrings in a container, the element storage does not need to be initialized
+_Bool cs_element_construct( container_func_params params );
+_Bool cs_element_copy( container_func_params params );
+void cs_element_destroy( container_func_params params );
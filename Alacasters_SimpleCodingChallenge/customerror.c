@@ -1,6 +1,7 @@
 #include "customerror.h"
+#include "sync.h"
 
-ResultCode g_result;
+static SYNC_THREAD_LOCAL ResultCode g_result;
 
 ResultCode err_get_result()
 {
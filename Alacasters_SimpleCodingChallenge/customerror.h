@@ -8,10 +8,24 @@ typedef enum ResultCode
 	Result_Not_Initialized,
 	Result_Index_Out_Of_Range,
 	Result_Null_Parameter,
-	Result_Invalid_Parameter
+	Result_Invalid_Parameter,
+	Result_Buffer_Full,
+	Result_Would_Block,
+	Result_Io_Error
 } ResultCode;
 
 
+// The result code is kept per thread, each thread sees the result of its own last call.
 ResultCode err_get_result();
 void err_set_result( ResultCode result );
 
+// Library functions report success through err_set_ok.  Defining CSAPI_FAST_ERRORS compiles it out,
+// successful calls then leave the result code alone and it is only meaningful after a call returned false.
+// Reads that return false at the end of their data still set Result_Ok in both modes: getchar, extract, getline
+// and next_line on a stringstream, the typed reads when only delimiters are left, and in_next_line.
+#if defined( CSAPI_FAST_ERRORS )
+#define err_set_ok() ( ( void )0 )
+#else
+#define err_set_ok() err_set_result( Result_Ok )
+#endif
+
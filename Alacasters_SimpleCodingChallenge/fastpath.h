@@ -0,0 +1,65 @@
+#pragma once
+
+#include "cstring.h"
+#include "defines.h"
+#include "stringstream.h"
+#include "utility.h"
+#include <assert.h>
+#include <stddef.h>
+
+// Unchecked accessors for loops that have already validated their indices.  They read the objects
+// directly instead of calling through the member pointers and never write the result code, so in
+// release builds they compile to plain loads and stores.  Preconditions are only checked by assert.
+// Pointers returned here are invalidated by any call that changes the object's size or capacity.
+
+static __inline size_t cs_len_fast( const cstring* this )
+{
+	assert( this != nullptr && this->_string != nullptr );
+	return this->_string->length;
+}
+// Null terminated, length bytes long
+static __inline const char* cs_data_fast( const cstring* this )
+{
+	assert( this != nullptr && this->_string != nullptr );
+	return this->_string->buffer;
+}
+// Writable, for filling a string that was resized first.  The byte at length must be left '\0'.
+static __inline char* cs_buffer_fast( cstring* this )
+{
+	assert( this != nullptr && this->_string != nullptr );
+	return this->_string->buffer;
+}
+static __inline char cs_at_fast( const cstring* this, const size_t idx )
+{
+	assert( this != nullptr && this->_string != nullptr && idx < this->_string->length );
+	return this->_string->buffer[ idx ];
+}
+static __inline void cs_set_fast( cstring* this, const size_t idx, const char c )
+{
+	assert( this != nullptr && this->_string != nullptr && idx < this->_string->length );
+	this->_string->buffer[ idx ] = c;
+}
+
+static __inline size_t cont_size_fast( const container* this )
+{
+	assert( this != nullptr && this->pdata != nullptr );
+	return this->pdata->size;
+}
+// The element itself rather than a copy of it
+static __inline void* cont_at_fast( const container* this, const size_t idx )
+{
+	assert( this != nullptr && this->pdata != nullptr && idx < this->pdata->size );
+	return &this->pdata->pBuffer[ idx * this->pdata->elemSize ];
+}
+
+// The next unread byte without consuming it.  The stream must not be at its end and must not be an
+// SPSC stream, whose read position belongs to the consumer thread.
+static __inline char ss_peek_fast( const stringstream* this )
+{
+	assert( this != nullptr && this->stream != nullptr );
+	const _sstream* stream = this->stream;
+	assert( stream->mode != SS_MODE_SPSC && stream->readPos < stream->str_size );
+
+	const size_t offset = stream->readPos - stream->base;
+	return stream->buffer[ stream->mode == SS_MODE_RING ? offset & ( stream->alloc_size - 1 ) : offset ];
+}
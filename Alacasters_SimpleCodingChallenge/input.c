@@ -0,0 +1,425 @@
+#include "input.h"
+#include "customerror.h"
+#include "memory.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( _WIN32 )
+#include <fcntl.h>
+#include <io.h>
+#include <limits.h>
+#include <stdio.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+struct _input_source
+{
+	int fd;
+	bool ownsFd;
+	// data is the whole file while mapped, the block buffer otherwise.  data[ pos, size ) is not handed out yet.
+	bool mapped;
+	char* data;
+	size_t pos;
+	size_t size;
+	size_t capacity;
+	// Set once the descriptor has nothing more to give, failure is Result_Ok unless it ended in an error
+	bool drained;
+	ResultCode failure;
+};
+
+// Private forward declarations
+bool in_construct( input_source* this, const int fd, const bool ownsFd );
+bool in_read_all( input_source* this, cstring* output );
+bool in_read_into( input_source* this, stringstream stream );
+bool in_next_line( input_source* this, string_slice* line, const line_terminator term );
+bool in_eof( const input_source* this );
+
+bool in_isInitialized( const input_source* this );
+bool in_map( _input_source* source );
+bool in_fill( _input_source* source );
+bool in_find_line( const char* data, const size_t length, const size_t from, const line_terminator term, size_t* lineEnd, size_t* next );
+ptrdiff_t in_read_fd( const int fd, char* buffer, const size_t length );
+void in_close_fd( const int fd );
+
+
+// Public definitions
+bool in_stdin_construct( input_source* this )
+{
+#if defined( _WIN32 )
+	const int fd = _fileno( stdin );
+#else
+	const int fd = STDIN_FILENO;
+#endif
+	return in_construct( this, fd, false );
+}
+bool in_file_construct( input_source* this, const char* path )
+{
+	if( path == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+#if defined( _WIN32 )
+	const int fd = _open( path, _O_RDONLY | _O_BINARY );
+#else
+	const int fd = open( path, O_RDONLY | O_CLOEXEC );
+#endif
+	if( fd < 0 )
+	{
+		err_set_result( Result_Io_Error );
+		return false;
+	}
+
+	if( in_construct( this, fd, true ) == false )
+	{
+		in_close_fd( fd );
+		return false;
+	}
+	return true;
+}
+bool in_destroy( input_source* this )
+{
+	if( this == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+	if( this->pdata == nullptr )
+	{
+		err_set_result( Result_Not_Initialized );
+		return false;
+	}
+
+	_input_source* source = this->pdata;
+#if !defined( _WIN32 )
+	if( source->mapped )
+	{
+		munmap( source->data, source->size );
+		source->data = nullptr;
+	}
+#endif
+	free( source->data );
+	if( source->ownsFd )
+	{
+		in_close_fd( source->fd );
+	}
+	SafeDelete( ( void** )&this->pdata );
+
+	input_source self = { 0 };
+	*this = self;
+
+	err_set_ok();
+	return true;
+}
+
+
+// Private definitions
+bool in_construct( input_source* this, const int fd, const bool ownsFd )
+{
+	_input_source* pdata = nullptr;
+	bool result = true;
+	ResultCode rescode = Result_Ok;
+
+	if( this == nullptr )
+	{
+		rescode = Result_Null_Parameter;
+		result = false;
+	}
+	if( result )
+	{
+		pdata = ( _input_source* )malloc( sizeof( _input_source ) );
+		if( pdata == nullptr )
+		{
+			rescode = Result_Bad_Alloc;
+			result = false;
+		}
+	}
+	if( result )
+	{
+		memset( pdata, 0, sizeof( _input_source ) );
+		pdata->fd = fd;
+		pdata->ownsFd = ownsFd;
+		pdata->failure = Result_Ok;
+
+		// Anything that can not be mapped is read in blocks
+		if( in_map( pdata ) == false )
+		{
+			pdata->data = ( char* )malloc( IN_BLOCK_SIZE );
+			pdata->capacity = IN_BLOCK_SIZE;
+			if( pdata->data == nullptr )
+			{
+				rescode = Result_Bad_Alloc;
+				SafeDelete( ( void** )&pdata );
+				result = false;
+			}
+		}
+	}
+	if( result )
+	{
+		input_source self = { 0 };
+		self.read_all = in_read_all;
+		self.read_into = in_read_into;
+		self.next_line = in_next_line;
+		self.eof = in_eof;
+		self.pdata = pdata;
+
+		*this = self;
+	}
+
+	err_set_result( rescode );
+	return result;
+}
+bool in_read_all( input_source* this, cstring* output )
+{
+	if( in_isInitialized( this ) == false )
+	{
+		err_set_result( Result_Not_Initialized );
+		return false;
+	}
+	if( output == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	_input_source* source = this->pdata;
+	bool result = cs_buffer_construct( output, &source->data[ source->pos ], source->size - source->pos );
+	source->pos = source->size;
+
+	while( result && in_fill( source ) )
+	{
+		result = cs_append_buffer( output, &source->data[ source->pos ], source->size - source->pos );
+		source->pos = source->size;
+	}
+	if( result && source->failure != Result_Ok )
+	{
+		err_set_result( source->failure );
+		result = false;
+	}
+
+	return result;
+}
+bool in_read_into( input_source* this, stringstream stream )
+{
+	if( in_isInitialized( this ) == false )
+	{
+		err_set_result( Result_Not_Initialized );
+		return false;
+	}
+
+	_input_source* source = this->pdata;
+	bool result = true;
+
+	do
+	{
+		result = stream.write( stream, &source->data[ source->pos ], source->size - source->pos );
+		if( result )
+		{
+			source->pos = source->size;
+		}
+	}
+	while( result && in_fill( source ) );
+
+	if( result && source->failure != Result_Ok )
+	{
+		err_set_result( source->failure );
+		result = false;
+	}
+
+	return result;
+}
+bool in_next_line( input_source* this, string_slice* line, const line_terminator term )
+{
+	if( in_isInitialized( this ) == false )
+	{
+		err_set_result( Result_Not_Initialized );
+		return false;
+	}
+	if( line == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	_input_source* source = this->pdata;
+	size_t lineEnd = 0, next = 0;
+	// Unread bytes already searched for a terminator, a refill keeps them and only the new block is searched
+	size_t searched = 0;
+
+	line->data = nullptr;
+	line->length = 0;
+
+	while( in_find_line( &source->data[ source->pos ], source->size - source->pos, searched, term, &lineEnd, &next ) == false )
+	{
+		searched = source->size - source->pos;
+		if( in_fill( source ) == false )
+		{
+			if( source->failure != Result_Ok )
+			{
+				err_set_result( source->failure );
+				return false;
+			}
+			if( searched == 0 )
+			{
+				// Out of lines is not a failure, even when err_set_ok is compiled out
+				err_set_result( Result_Ok );
+				return false;
+			}
+
+			// Final record without a terminator
+			lineEnd = searched;
+			next = searched;
+			break;
+		}
+	}
+
+	line->data = &source->data[ source->pos ];
+	line->length = lineEnd;
+	source->pos += next;
+
+	err_set_ok();
+	return true;
+}
+bool in_eof( const input_source* this )
+{
+	if( in_isInitialized( this ) == false )
+	{
+		return true;
+	}
+
+	return this->pdata->drained && this->pdata->pos == this->pdata->size;
+}
+bool in_isInitialized( const input_source* this )
+{
+	return this != nullptr && this->pdata != nullptr;
+}
+bool in_map( _input_source* source )
+{
+#if defined( _WIN32 )
+	( void )source;
+	return false;
+#else
+	struct stat info;
+	if( fstat( source->fd, &info ) != 0 || S_ISREG( info.st_mode ) == 0 || info.st_size <= 0 ||
+		( uint64_t )info.st_size > ( uint64_t )SIZE_MAX )
+	{
+		return false;
+	}
+
+	// A descriptor that was partly read already, stdin redirected from a file for one, continues where it is
+	const off_t offset = lseek( source->fd, 0, SEEK_CUR );
+	if( offset < 0 || offset >= info.st_size )
+	{
+		return false;
+	}
+
+	const size_t length = ( size_t )info.st_size;
+	void* view = mmap( nullptr, length, PROT_READ, MAP_PRIVATE, source->fd, 0 );
+	if( view == MAP_FAILED )
+	{
+		return false;
+	}
+#if defined( MADV_SEQUENTIAL )
+	madvise( view, length, MADV_SEQUENTIAL );
+#endif
+
+	source->mapped = true;
+	source->data = ( char* )view;
+	source->pos = ( size_t )offset;
+	source->size = length;
+	source->drained = true;
+	return true;
+#endif
+}
+bool in_fill( _input_source* source )
+{
+	if( source->drained )
+	{
+		return false;
+	}
+
+	// Unread bytes move to the front, the buffer only grows when a single record fills all of it
+	if( source->pos > 0 )
+	{
+		memmove( source->data, &source->data[ source->pos ], source->size - source->pos );
+		source->size -= source->pos;
+		source->pos = 0;
+	}
+	if( source->size == source->capacity )
+	{
+		char* buffer = ( char* )realloc( source->data, source->capacity * 2 );
+		if( buffer == nullptr )
+		{
+			source->drained = true;
+			source->failure = Result_Bad_Alloc;
+			return false;
+		}
+		source->data = buffer;
+		source->capacity *= 2;
+	}
+
+	const ptrdiff_t count = in_read_fd( source->fd, &source->data[ source->size ], source->capacity - source->size );
+	if( count <= 0 )
+	{
+		source->drained = true;
+		source->failure = count < 0 ? Result_Io_Error : Result_Ok;
+		return false;
+	}
+
+	source->size += ( size_t )count;
+	return true;
+}
+bool in_find_line( const char* data, const size_t length, const size_t from, const line_terminator term, size_t* lineEnd, size_t* next )
+{
+	for( size_t pos = from; pos < length; )
+	{
+		const char* found = ( const char* )memchr( &data[ pos ], term.delim, length - pos );
+		if( found == nullptr )
+		{
+			break;
+		}
+
+		// The '\r' before delim is still in the buffer even when delim arrived in a later block
+		const size_t at = ( size_t )( found - data );
+		if( term.crlf == false || ( at > 0 && data[ at - 1 ] == '\r' ) )
+		{
+			*lineEnd = term.crlf ? at - 1 : at;
+			*next = at + 1;
+			return true;
+		}
+
+		pos = at + 1;
+	}
+
+	return false;
+}
+ptrdiff_t in_read_fd( const int fd, char* buffer, const size_t length )
+{
+#if defined( _WIN32 )
+	return _read( fd, buffer, ( unsigned int )( length < INT_MAX ? length : INT_MAX ) );
+#else
+	ssize_t count = 0;
+	do
+	{
+		count = read( fd, buffer, length );
+	}
+	while( count < 0 && errno == EINTR );
+
+	return ( ptrdiff_t )count;
+#endif
+}
+void in_close_fd( const int fd )
+{
+#if defined( _WIN32 )
+	_close( fd );
+#else
+	close( fd );
+#endif
+}
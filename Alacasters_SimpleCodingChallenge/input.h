@@ -0,0 +1,41 @@
+#pragma once
+
+#include "cstring.h"
+#include "defines.h"
+#include "stringstream.h"
+#include <stddef.h>
+
+// Bulk reader for stdin and files.  Regular files are memory mapped where the platform supports it and
+// read without copying, everything else, pipes, terminals and stdin included, is read in blocks of
+// IN_BLOCK_SIZE bytes or more.  A source reads its descriptor directly, so stdin must not also be read
+// through stdio once a source was constructed on it.
+//
+// Whole input reads copy straight from the mapping or block into the destination.  next_line hands out
+// records one at a time as slices into the mapping or block buffer, so input larger than memory streams
+// through a buffer that only grows to hold the longest record.
+typedef struct _input_source _input_source;
+typedef struct input_source input_source;
+
+#define IN_BLOCK_SIZE 65536
+
+struct input_source
+{
+	// Replaces output with everything not read yet
+	_Bool( *read_all )( input_source* this, cstring* output );
+	// Appends everything not read yet to stream, a ring stream fails with Result_Buffer_Full when it fills up
+	_Bool( *read_into )( input_source* this, stringstream stream );
+	// The next record without its terminator, see line_terminator.  A final record without a terminator
+	// is returned as well.  The slice is valid until the next call on the source.
+	// Returns false with Result_Ok at the end of the input and with Result_Io_Error when a read fails.
+	_Bool( *next_line )( input_source* this, string_slice* line, const line_terminator term );
+	// true once the end of the input was seen and every byte before it was handed out
+	_Bool( *eof )( const input_source* this );
+
+	_input_source* pdata;
+};
+
+_Bool in_stdin_construct( input_source* this );
+// Fails with Result_Io_Error when path can not be opened
+_Bool in_file_construct( input_source* this, const char* path );
+// Closes the file but leaves stdin open
+_Bool in_destroy( input_source* this );
@@ -5,31 +5,64 @@
 #include "cstring.h"
 #include "customerror.h"
 #include "defines.h"
+#include "fastpath.h"
+#include "input.h"
 #include "memory.h"
+#include "profile.h"
 #include "stringstream.h"
+#include "threadpool.h"
+#include "tokenizer.h"
 #include "utility.h"
+#include "wordgrid.h"
 
 #define MAX_LEN 255
+// Messages encoded per round of batch mode, output is written after every round
+#define BATCH_MESSAGES 65536
+
+// Profiling regions of the codec stages, see profile.h
+#define PROF_TRANSFORM PROF_USER_0
+#define PROF_ENCODE PROF_USER_1
+#define PROF_DECODE PROF_USER_2
 
 // Input
 bool GetUserInput( cstring input );
 
-// String utilities
-bool WordCounter( const cstring input, size_t* numWords );
-bool MaxWordLength( const cstring input, size_t* wordLength );
+// Word analysis, one scan of the input finds every word along with the count and longest length
+typedef struct word_analysis
+{
+	container* words;
+	size_t maxLength;
+	bool failed;
+}word_analysis;
+
+_Bool AnalyzeVisitor( token_span span, void* user );
+bool AnalyzeWords( const cstring input, container* words, size_t* numWords, size_t* maxWordLength );
 
 // Message codec
 bool Encode( const cstring input, cstring output, const size_t numColumns, const size_t numRows );
-bool Transform( const cstring input, cstring output, const size_t numColumns, const size_t numRows );
-void Decode( const cstring input, cstring output );
+// Lays word i of words down column i of the numColumns by numRows grid in output
+bool Transform( const cstring input, const container* words, cstring output, const size_t numColumns, const size_t numRows );
+// Transform followed by Encode without building the grid
+bool EncodeWords( const cstring input, const container* words, cstring output, const size_t numRows );
+// Appends the message input, an encoded message, decodes to.  See wg_decode for which message that is.
+bool Decode( const cstring input, cstring output );
 
 bool PrintTransformed( const cstring input, const size_t numColumns, const size_t numRows );
 
-bool WordEncrypter()
+// Decrypts one line of stdin
+bool WordDecrypter( void );
+
+// Batch mode, one message per line of the input
+bool SplitLines( const cstring* input, container* lines );
+bool BatchEncrypter( const char* path );
+
+// Encrypts one line of stdin, showGrid also prints the grid the message is read from
+bool WordEncrypter( const bool showGrid )
 {	
 	cstring input = { 0 };
 	cstring transformed = { 0 };
 	cstring output = { 0 };
+	container words = { 0 };
 	size_t numColumns = 0;
 	size_t numRows = 0;
 
@@ -41,32 +74,83 @@ bool WordEncrypter()
 	}
 	if( result == true )
 	{
-		result = WordCounter( input, &numColumns );
+		result = cont_default_construct( &words, sizeof( token_span ), nullptr, nullptr, nullptr, nullptr );
 	}
 	if( result == true )
 	{
-		result = MaxWordLength( input, &numRows );
+		result = AnalyzeWords( input, &words, &numColumns, &numRows );
 	}
 	if( result == true )
+	{
+		result = cs_reserve_construct( &output, ( numColumns + 1 ) * numRows );
+	}
+	if( result == true && showGrid == true )
 	{
 		result = cs_default_construct( &transformed );
+		if( result == true )
+		{
+			prof_begin( PROF_TRANSFORM );
+			result = Transform( input, &words, transformed, numColumns, numRows );
+			prof_end( PROF_TRANSFORM );
+		}
+		if( result == true )
+		{
+			prof_begin( PROF_ENCODE );
+			result = Encode( transformed, output, numColumns, numRows );
+			prof_end( PROF_ENCODE );
+		}
+		if( result == true )
+		{
+			printf( "%c", '\n' );
+			result = PrintTransformed( transformed, numColumns, numRows );
+		}
+	}
+	else if( result == true )
+	{
+		// Nothing looks at the grid, so the words are encoded straight from the input
+		prof_begin( PROF_ENCODE );
+		result = EncodeWords( input, &words, output, numRows );
+		prof_end( PROF_ENCODE );
 	}
 	if( result == true )
 	{
-		result = Transform( input, transformed, numColumns, numRows );
+		printf( "%c", '\n' );
+		printf( "%s", output.str( &output ) );
+	}
+
+	cs_destroy_cstring( &output );
+	if( transformed._string != nullptr )
+	{
+		cs_destroy_cstring( &transformed );
+	}
+	if( words.pdata != nullptr )
+	{
+		cont_destroy( &words );
 	}
+	cs_destroy_cstring( &input );
+
+	return result;
+}
+
+bool WordDecrypter( void )
+{
+	cstring input = { 0 };
+	cstring output = { 0 };
+
+	bool result = cs_default_construct( &input );
 	if( result == true )
 	{
-		result = cs_reserve_construct( &output, numColumns * numRows );
+		result = GetUserInput( input );
 	}
 	if( result == true )
 	{
-		result = Encode( transformed, output, numColumns, numRows );
+		result = cs_reserve_construct( &output, cs_len_fast( &input ) + 1 );
 	}
 	if( result == true )
 	{
-		printf( "%c", '\n' );
-		result = PrintTransformed( transformed, numColumns, numRows );
+		prof_begin( PROF_DECODE );
+		result = Decode( input, output );
+		prof_end( PROF_DECODE );
 	}
 	if( result == true )
 	{
@@ -74,14 +158,103 @@ bool WordEncrypter()
 		printf( "%s", output.str( &output ) );
 	}
 
-	cs_destroy_cstring( &output );
-	cs_destroy_cstring( &transformed );
+	if( output._string != nullptr )
+	{
+		cs_destroy_cstring( &output );
+	}
 	cs_destroy_cstring( &input );
 
 	return result;
 }
 
+// Encrypts every line of path, or of stdin when path is null, on one worker per hardware thread.
+// The encoded messages go to stdout one per line in input order, an empty line stays empty.
+bool BatchEncrypter( const char* path )
+{
+	input_source source = { 0 };
+	threadpool pool = { 0 };
+	cstring input = { 0 };
+	cstring output = { 0 };
+	container lines = { 0 };
 
+	bool result = path != nullptr ? in_file_construct( &source, path ) : in_stdin_construct( &source );
+
+	// The messages are slices of the whole input, so they stay valid while the workers read them
+	if( result == true )
+	{
+		result = source.read_all( &source, &input );
+	}
+	if( result == true )
+	{
+		result = cont_default_construct( &lines, sizeof( string_slice ), nullptr, nullptr, nullptr, nullptr );
+	}
+	if( result == true )
+	{
+		result = SplitLines( &input, &lines );
+	}
+	if( result == true )
+	{
+		result = tp_construct( &pool, 0 );
+	}
+
+	const string_slice* messages = result == true ? ( const string_slice* )cont_ptr_begin( &lines ) : nullptr;
+	const size_t numMessages = result == true ? cont_size_fast( &lines ) : 0;
+	for( size_t first = 0; first < numMessages && result == true; first += BATCH_MESSAGES )
+	{
+		const size_t count = numMessages - first < BATCH_MESSAGES ? numMessages - first : BATCH_MESSAGES;
+
+		prof_begin( PROF_ENCODE );
+		result = wg_encode_batch( &pool, &messages[ first ], count, 0, &output );
+		prof_end( PROF_ENCODE );
+
+		if( result == true )
+		{
+			fwrite( cs_data_fast( &output ), 1, cs_len_fast( &output ), stdout );
+		}
+	}
+
+	if( pool.pdata != nullptr )
+	{
+		tp_destroy( &pool );
+	}
+	if( lines.pdata != nullptr )
+	{
+		cont_destroy( &lines );
+	}
+	if( output._string != nullptr )
+	{
+		cs_destroy_cstring( &output );
+	}
+	if( input._string != nullptr )
+	{
+		cs_destroy_cstring( &input );
+	}
+	if( source.pdata != nullptr )
+	{
+		in_destroy( &source );
+	}
+
+	return result;
+}
+bool SplitLines( const cstring* input, container* lines )
+{
+	const char* data = cs_data_fast( input );
+	const size_t length = cs_len_fast( input );
+	bool result = true;
+
+	for( size_t pos = 0; pos < length && result == true; )
+	{
+		const char* found = ( const char* )memchr( &data[ pos ], '\n', length - pos );
+		const size_t end = found != nullptr ? ( size_t )( found - data ) : length;
+
+		// A '\r' left by CRLF input is whitespace to the tokenizer, so it needs no special handling
+		string_slice line = { &data[ pos ], end - pos };
+		result = lines->push_back( lines, &line );
+		pos = end + 1;
+	}
+
+	return result;
+}
 
 void func()
 {
@@ -95,9 +268,10 @@ void func()
 		&cont_a, 
 		numElements,
 		sizeof( cstring ), 
-		cs_default_construct,
-		cs_copy, 
-		cs_destroy_cstring );
+		cs_element_construct,
+		cs_element_copy,
+		cs_element_destroy,
+		nullptr );
 	if( result )
 	{
 		for( size_t i = 0; i < numElements && result == true; ++i )
@@ -105,20 +279,14 @@ void func()
 			if( i != 6 )
 			{
 				char num[ 2 ];
-				_ultoa( i, num, 10 );
-				cstring temp = { 0 };
+				snprintf( num, sizeof( num ), "%u", ( unsigned )i );
 
-				result = cs_default_construct( &temp );
+				cstring* slot = ( cstring* )cont_a.emplace_back( &cont_a );
+				result = slot != nullptr;
 				if( result )
 				{
-					result = temp.push_back( &temp, num[ 0 ] );
+					result = slot->push_back( slot, num[ 0 ] );
 				}
-				if( result )
-				{
-					result = cont_a.push_back( &cont_a, &temp );
-				}
-
-				cs_destroy_cstring( &temp );
 			}
 		}
 	}
@@ -153,185 +321,132 @@ void func()
 	cont_destroy( &cont_a );
 }
 
-int main()
+int main( int argc, char** argv )
 {
-	func();
-	return 0;
-}
-
-bool GetUserInput( cstring input )
-{
-	char c = 0;
-	while( ( c = getchar() ) != '\n' )
-	{
-		if( input.push_back( &input, c ) == false )
-		{
-			return false;
-		}
-	}
-	
-	return true;
-}
+	prof_set_region_name( PROF_TRANSFORM, "Transform" );
+	prof_set_region_name( PROF_ENCODE, "Encode" );
+	prof_set_region_name( PROF_DECODE, "Decode" );
 
-bool WordCounter( const cstring input, size_t* numWords )
-{
-	size_t wordCount = 0;
-	*numWords = -1;
-
-	stringstream ss = { 0 };
-	if( ss_construct( &ss ) == false )
-	{
-		return false;
-	}
-
-	if( ss.insert_cstring( ss, input ) == false )
+	// --batch [file] encrypts every line of file or of stdin, --decode decrypts one line of stdin
+	if( argc > 1 && ( strcmp( argv[ 1 ], "--batch" ) == 0 || strcmp( argv[ 1 ], "--decode" ) == 0 ) )
 	{
-		ss_destroy( &ss );
-		return false;
-	}
-
-	while( ss.eof( ss ) == false )
-	{
-		cstring temp = { 0 };
-		if( ss.extract( ss, &temp ) == false )
+		bool result = false;
+		if( strcmp( argv[ 1 ], "--batch" ) == 0 )
 		{
-			ss_destroy( &ss );
-			return false;
+			result = BatchEncrypter( argc > 2 ? argv[ 2 ] : nullptr );
 		}
-
-		if( temp.empty( &temp ) == false )
+		else
 		{
-			++wordCount;
+			result = WordDecrypter();
 		}
 
-		cs_destroy_cstring( &temp );
+		// stdout carries the messages, the report must not end up in them
+		prof_report_thread( stderr );
+		return result == true ? 0 : 1;
 	}
 
-	*numWords = wordCount;
+	func();
 
-	ss_destroy( &ss );
-	err_set_result( Result_Ok );
-	return true;
+	// Prints nothing unless built with CSAPI_PROFILE
+	prof_report_thread( stderr );
+	return 0;
 }
 
-bool MaxWordLength( const cstring input, size_t* wordLength )
+bool GetUserInput( cstring input )
 {
-	err_set_result( Result_Ok );
+	input_source source = { 0 };
+	string_slice line = { 0 };
+	const line_terminator term = { '\n', false };
 
-	size_t curWordLen = 0,maxWordLen = 0;
-	*wordLength = -1;
-	stringstream ss = { 0 };
-
-	bool result = ss_construct( &ss );
+	bool result = in_stdin_construct( &source );
 	if( result )
 	{
-		result = ss.insert_cstring( ss, input );
+		// The message is the first line, empty input leaves it empty
+		result = source.next_line( &source, &line, term ) || err_get_result() == Result_Ok;
 	}
 	if( result )
 	{
-		do
-		{
-			cstring temp = { 0 };
-			result = ss.extract( ss, &temp );
-
-			if( result == false && err_get_result() == Result_Ok )
-			{
-				if( ( curWordLen = temp.size( &temp ) ) > 0 )
-				{
-					maxWordLen = curWordLen > maxWordLen ? curWordLen : maxWordLen;
-				}
-			}
-
-			cs_destroy_cstring( &temp );
-		} while( ss.eof( ss ) == false );
+		result = cs_append_buffer( &input, line.data, line.length );
+	}
+	if( source.pdata != nullptr )
+	{
+		in_destroy( &source );
 	}
-	
-	ss_destroy( &ss );
 
-	*wordLength = maxWordLen;
-	return true;
+	return result;
 }
 
-bool Transform( const cstring input, cstring output, const size_t numColumns, const size_t numRows )
+_Bool AnalyzeVisitor( token_span span, void* user )
 {
-	err_set_result( Result_Ok );
+	word_analysis* analysis = ( word_analysis* )user;
+	analysis->maxLength = span.length > analysis->maxLength ? span.length : analysis->maxLength;
 
-	size_t wordCounter = 0;
-	stringstream ss = { 0 };
-	cstring temp = { 0 };
+	analysis->failed = analysis->words->push_back( analysis->words, &span ) == false;
+	return analysis->failed == false;
+}
 
-	bool result = ss_construct( &ss );
+bool AnalyzeWords( const cstring input, container* words, size_t* numWords, size_t* maxWordLength )
+{
+	delimiter_class delims;
+	dc_whitespace( &delims );
 
-	if( result )
-	{
-		result = ss.insert_cstring( ss, input );
-	}
-	if( result )
+	word_analysis analysis = { 0 };
+	analysis.words = words;
+
+	words->clear( words );
+	tok_for_each( &delims, cs_data_fast( &input ), cs_len_fast( &input ), AnalyzeVisitor, &analysis );
+	if( analysis.failed )
 	{
-		result = ss.extract( ss, &temp );
+		return false;
 	}
-	if( result )
+
+	*numWords = words->size( words );
+	*maxWordLength = analysis.maxLength;
+	err_set_result( Result_Ok );
+	return true;
+}
+
+bool Transform( const cstring input, const container* words, cstring output, const size_t numColumns, const size_t numRows )
+{
+	bool result = true;
+	if( output.size( &output ) < numColumns * numRows )
 	{
-		if( output.size( &output ) < numColumns * numRows )
-		{
-			result = output.resize( &output, numColumns * numRows );
-		}
+		result = output.resize( &output, numColumns * numRows );
 	}
 	if( result )
 	{
-		while( result )
-		{
-			const size_t str_len = temp.size( &temp );
+		// Words are at most numRows long and output was sized to fit the whole grid
+		const token_span* spans = ( const token_span* )cont_ptr_begin( words );
+		wg_transform( cs_data_fast( &input ), cs_len_fast( &input ), spans, numColumns, numRows, cs_buffer_fast( &output ) );
 
-			for( size_t i = 0; i < str_len; ++i )
-			{
-				char c = 0;
-				temp.at_get( &temp, i, &c );
-
-				const size_t idx = wordCounter + ( i * numColumns );
-				output.at_set( &output, idx, c );
-			}
-
-			++wordCounter;
-
-			cs_destroy_cstring( &temp );
-			result = ss.extract( ss, &temp );
-		}
+		err_set_result( Result_Ok );
 	}
 
-	cs_destroy_cstring( &temp );
-	ss_destroy( &ss );
-
 	return result;
 }
 
 bool Encode( const cstring input, cstring output, const size_t numColumns, const size_t numRows )
 {	
-	bool result = true;
-	err_set_result( Result_Ok );
+	bool result = input.size( &input ) >= numColumns * numRows;
+	err_set_result( result ? Result_Ok : Result_Index_Out_Of_Range );
 
-	for( size_t j = 0, idx = 0; j < numRows; ++j, ++idx )
+	if( result )
 	{
-		const size_t rowOffset = j * numColumns;
-		for( size_t i = 0; i < numColumns; ++i )
-		{
-			char c = 0;
-			if( result )
-			{
-				result = input.at_get( &input, i + rowOffset, &c ) && result;
-			}
-			if( result && c != '\0' )
-			{
-				result = output.push_back( &output, c );
-			}
-		}
-		if( result )
-		{
-			result = output.push_back( &output, ' ' );
-		}
+		result = wg_encode_grid( cs_data_fast( &input ), numColumns, numRows, &output );
 	}
 
-	return true;
+	return result;
+}
+
+bool EncodeWords( const cstring input, const container* words, cstring output, const size_t numRows )
+{
+	const token_span* spans = ( const token_span* )cont_ptr_begin( words );
+	return wg_encode( cs_data_fast( &input ), cs_len_fast( &input ), spans, cont_size_fast( words ), numRows, &output );
+}
+
+bool Decode( const cstring input, cstring output )
+{
+	return wg_decode( cs_data_fast( &input ), cs_len_fast( &input ), &output );
 }
 
 bool PrintTransformed( const cstring input, const size_t numColumns, const size_t numRows )
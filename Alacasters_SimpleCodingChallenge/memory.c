@@ -1,4 +1,6 @@
 #include "memory.h"
+#include "customerror.h"
+#include "sync.h"
 #include <stdlib.h>
 
 void** AllocateArray2D( size_t ArrayCount, size_t ElementSize )
@@ -31,3 +33,139 @@ void SafeDeleteArray( void ** ptr, size_t count )
 	}
 }
 
+
+
+#if defined( CSAPI_MEMORY_STATS )
+// Counters shared by every thread, one cache line per subsystem
+typedef struct mem_counters
+{
+	volatile size_t allocations, frees, bytes_live, bytes_peak, grows, copies;
+	char pad[ SYNC_CACHE_LINE - 6 * sizeof( size_t ) ];
+}mem_counters;
+
+// Keeps the block after the header 16 byte aligned like malloc's
+#define MEM_HEADER_SIZE 16
+
+_Static_assert( sizeof( mem_counters ) == SYNC_CACHE_LINE, "mem_counters must fill one cache line" );
+
+// Aligned too, otherwise each subsystem's counters straddle two lines
+static _Alignas( SYNC_CACHE_LINE ) mem_counters g_counters[ MEM_SUBSYSTEM_COUNT ];
+
+// Private forward declarations
+void mem_add_live( mem_counters* counters, const size_t bytes );
+
+void* mem_alloc( const mem_subsystem subsystem, const size_t size )
+{
+	char* block = ( char* )malloc( MEM_HEADER_SIZE + size );
+	if( block == NULL )
+	{
+		return NULL;
+	}
+
+	*( size_t* )block = size;
+	sync_fetch_add_size( &g_counters[ subsystem ].allocations, 1 );
+	mem_add_live( &g_counters[ subsystem ], size );
+	return block + MEM_HEADER_SIZE;
+}
+void* mem_realloc( const mem_subsystem subsystem, void* ptr, const size_t size )
+{
+	if( ptr == NULL )
+	{
+		return mem_alloc( subsystem, size );
+	}
+
+	char* old = ( char* )ptr - MEM_HEADER_SIZE;
+	const size_t oldSize = *( size_t* )old;
+	char* block = ( char* )realloc( old, MEM_HEADER_SIZE + size );
+	if( block == NULL )
+	{
+		return NULL;
+	}
+
+	// Counted as a free of the old block and an allocation of the new one
+	*( size_t* )block = size;
+	sync_fetch_add_size( &g_counters[ subsystem ].allocations, 1 );
+	sync_fetch_add_size( &g_counters[ subsystem ].frees, 1 );
+	sync_fetch_add_size( &g_counters[ subsystem ].bytes_live, ( size_t )0 - oldSize );
+	mem_add_live( &g_counters[ subsystem ], size );
+	return block + MEM_HEADER_SIZE;
+}
+void mem_free( const mem_subsystem subsystem, void* ptr )
+{
+	if( ptr == NULL )
+	{
+		return;
+	}
+
+	char* block = ( char* )ptr - MEM_HEADER_SIZE;
+	sync_fetch_add_size( &g_counters[ subsystem ].frees, 1 );
+	sync_fetch_add_size( &g_counters[ subsystem ].bytes_live, ( size_t )0 - *( size_t* )block );
+	free( block );
+}
+void mem_count_grow( const mem_subsystem subsystem )
+{
+	sync_fetch_add_size( &g_counters[ subsystem ].grows, 1 );
+}
+void mem_count_copy( const mem_subsystem subsystem )
+{
+	sync_fetch_add_size( &g_counters[ subsystem ].copies, 1 );
+}
+void mem_add_live( mem_counters* counters, const size_t bytes )
+{
+	const size_t live = sync_fetch_add_size( &counters->bytes_live, bytes ) + bytes;
+	for( size_t peak = sync_load_acquire( &counters->bytes_peak ); live > peak; peak = sync_load_acquire( &counters->bytes_peak ) )
+	{
+		if( sync_compare_exchange_size( &counters->bytes_peak, peak, live ) )
+		{
+			break;
+		}
+	}
+}
+#endif
+
+_Bool mem_get_stats( const mem_subsystem subsystem, memory_stats* stats )
+{
+	if( stats == NULL || subsystem > MEM_SUBSYSTEM_COUNT )
+	{
+		err_set_result( stats == NULL ? Result_Null_Parameter : Result_Invalid_Parameter );
+		return false;
+	}
+
+	memory_stats out = { 0 };
+#if defined( CSAPI_MEMORY_STATS )
+	// The total peak is the sum of the subsystem peaks, an upper bound on the peak of the sum
+	const size_t first = subsystem == MEM_SUBSYSTEM_COUNT ? 0 : ( size_t )subsystem;
+	const size_t last = subsystem == MEM_SUBSYSTEM_COUNT ? MEM_SUBSYSTEM_COUNT : ( size_t )subsystem + 1;
+	for( size_t i = first; i < last; ++i )
+	{
+		out.allocations += sync_load_acquire( &g_counters[ i ].allocations );
+		out.frees += sync_load_acquire( &g_counters[ i ].frees );
+		out.bytes_live += sync_load_acquire( &g_counters[ i ].bytes_live );
+		out.bytes_peak += sync_load_acquire( &g_counters[ i ].bytes_peak );
+		out.grows += sync_load_acquire( &g_counters[ i ].grows );
+		out.copies += sync_load_acquire( &g_counters[ i ].copies );
+	}
+	*stats = out;
+
+	err_set_ok();
+	return true;
+#else
+	*stats = out;
+
+	err_set_result( Result_Not_Initialized );
+	return false;
+#endif
+}
+void mem_reset_stats( void )
+{
+#if defined( CSAPI_MEMORY_STATS )
+	for( size_t i = 0; i < MEM_SUBSYSTEM_COUNT; ++i )
+	{
+		sync_store_release( &g_counters[ i ].allocations, 0 );
+		sync_store_release( &g_counters[ i ].frees, 0 );
+		sync_store_release( &g_counters[ i ].grows, 0 );
+		sync_store_release( &g_counters[ i ].copies, 0 );
+		sync_store_release( &g_counters[ i ].bytes_peak, sync_load_acquire( &g_counters[ i ].bytes_live ) );
+	}
+#endif
+}
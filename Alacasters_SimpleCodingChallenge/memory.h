@@ -1,9 +1,73 @@
 #pragma once
 
+#include "defines.h"
 #include <ctype.h>
+#include <stddef.h>
+#include <stdlib.h>
 
 // Memory
 void** AllocateArray2D( size_t ArrayCount, size_t ElementSize );
 void SafeDelete( void** ptr );
 void SafeDeleteArray( void** ptr, size_t count );
 
+
+// Allocation accounting.  cstring, stringstream, container and hashmap allocate through mem_alloc,
+// mem_realloc and mem_free, which are plain malloc, realloc and free unless CSAPI_MEMORY_STATS is defined.
+// With it defined every block carries a 16 byte size header and the counters below are kept per subsystem.
+// Blocks must be released through mem_free with the subsystem that allocated them.
+typedef enum mem_subsystem
+{
+	MEM_CSTRING,
+	MEM_STRINGSTREAM,
+	MEM_CONTAINER,
+	MEM_HASHMAP,
+	MEM_SUBSYSTEM_COUNT
+}mem_subsystem;
+
+typedef struct memory_stats
+{
+	size_t allocations;	// blocks handed out by mem_alloc and mem_realloc
+	size_t frees;
+	size_t bytes_live;	// requested bytes not yet freed, headers excluded
+	size_t bytes_peak;	// peak of bytes_live since the last reset
+	size_t grows;		// buffers enlarged to fit more data
+	size_t copies;		// whole object deep copies
+}memory_stats;
+
+#if defined( CSAPI_MEMORY_STATS )
+void* mem_alloc( const mem_subsystem subsystem, const size_t size );
+void* mem_realloc( const mem_subsystem subsystem, void* ptr, const size_t size );
+void mem_free( const mem_subsystem subsystem, void* ptr );
+void mem_count_grow( const mem_subsystem subsystem );
+void mem_count_copy( const mem_subsystem subsystem );
+#else
+static __inline void* mem_alloc( const mem_subsystem subsystem, const size_t size )
+{
+	( void )subsystem;
+	return malloc( size );
+}
+static __inline void* mem_realloc( const mem_subsystem subsystem, void* ptr, const size_t size )
+{
+	( void )subsystem;
+	return realloc( ptr, size );
+}
+static __inline void mem_free( const mem_subsystem subsystem, void* ptr )
+{
+	( void )subsystem;
+	free( ptr );
+}
+static __inline void mem_count_grow( const mem_subsystem subsystem )
+{
+	( void )subsystem;
+}
+static __inline void mem_count_copy( const mem_subsystem subsystem )
+{
+	( void )subsystem;
+}
+#endif
+
+// Passing MEM_SUBSYSTEM_COUNT sums every subsystem.  Without CSAPI_MEMORY_STATS the stats are zero
+// and the call fails with Result_Not_Initialized.
+_Bool mem_get_stats( const mem_subsystem subsystem, memory_stats* stats );
+// Zeroes the event counters and restarts bytes_peak from bytes_live, live bytes are kept
+void mem_reset_stats( void );
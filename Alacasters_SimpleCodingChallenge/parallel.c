@@ -0,0 +1,224 @@
+#include "parallel.h"
+#include "customerror.h"
+#include "sync.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Everything a span job needs, shared read only between the threads apart from the marked fields
+typedef struct par_job
+{
+	const char* src;
+	char* dst;
+	size_t elemSize, dstElemSize;
+	void* user;
+
+	span_visitor visitor;
+	element_transform transform;
+	span_reduce reduce;
+	element_predicate predicate;
+
+	// One slot per thread on its own cache lines, stride bytes apart from a line aligned start
+	char* partials;
+	size_t stride;
+
+	volatile uint32_t stopped;
+}par_job;
+
+// Private forward declarations
+size_t par_grain( const threadpool* pool, const size_t count, const size_t elemSize, const size_t grain );
+size_t par_stride( const size_t size );
+void par_for_each_job( const size_t first, const size_t last, const size_t worker, void* user );
+void par_transform_job( const size_t first, const size_t last, const size_t worker, void* user );
+void par_reduce_job( const size_t first, const size_t last, const size_t worker, void* user );
+void par_count_job( const size_t first, const size_t last, const size_t worker, void* user );
+
+
+// Public definitions
+bool par_for_each( threadpool* pool, const container* cont, const size_t grain, span_visitor visitor, void* user )
+{
+	if( pool == nullptr || cont == nullptr || visitor == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	const size_t size = cont->size( cont );
+	par_job job = { 0 };
+	job.src = ( const char* )cont_ptr_begin( cont );
+	job.elemSize = cont_elem_size( cont );
+	job.visitor = visitor;
+	job.user = user;
+
+	if( pool->run( pool, size, par_grain( pool, size, job.elemSize, grain ), par_for_each_job, &job ) == false )
+	{
+		return false;
+	}
+	return sync_load_u32( &job.stopped ) == 0;
+}
+bool par_transform( threadpool* pool, const container* src, container* dst, const size_t grain, element_transform transform, void* user )
+{
+	if( pool == nullptr || src == nullptr || dst == nullptr || transform == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	const size_t size = src->size( src );
+	if( dst != src && dst->resize( dst, size ) == false )
+	{
+		return false;
+	}
+
+	par_job job = { 0 };
+	job.src = ( const char* )cont_ptr_begin( src );
+	job.dst = ( char* )cont_ptr_begin( dst );
+	job.elemSize = cont_elem_size( src );
+	job.dstElemSize = cont_elem_size( dst );
+	job.transform = transform;
+	job.user = user;
+
+	return pool->run( pool, size, par_grain( pool, size, job.elemSize, grain ), par_transform_job, &job );
+}
+bool par_reduce( threadpool* pool, const container* cont, const size_t grain, void* result, const size_t resultSize, span_reduce reduce, reduce_combine combine, void* user )
+{
+	if( pool == nullptr || cont == nullptr || result == nullptr || reduce == nullptr || combine == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	const size_t threads = pool->thread_count( pool );
+	par_job job = { 0 };
+	job.src = ( const char* )cont_ptr_begin( cont );
+	job.elemSize = cont_elem_size( cont );
+	job.reduce = reduce;
+	job.user = user;
+	job.stride = par_stride( resultSize );
+	job.partials = ( char* )sync_calloc_lines( threads, job.stride );
+	if( job.partials == nullptr )
+	{
+		err_set_result( Result_Bad_Alloc );
+		return false;
+	}
+
+	for( size_t i = 0; i < threads; ++i )
+	{
+		memcpy( &job.partials[ i * job.stride ], result, resultSize );
+	}
+
+	const size_t size = cont->size( cont );
+	const bool ran = pool->run( pool, size, par_grain( pool, size, job.elemSize, grain ), par_reduce_job, &job );
+	if( ran )
+	{
+		memcpy( result, job.partials, resultSize );
+		for( size_t i = 1; i < threads; ++i )
+		{
+			combine( result, &job.partials[ i * job.stride ], user );
+		}
+	}
+
+	sync_free_lines( job.partials );
+	return ran;
+}
+size_t par_count_if( threadpool* pool, const container* cont, const size_t grain, element_predicate predicate, void* user )
+{
+	if( pool == nullptr || cont == nullptr || predicate == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return 0;
+	}
+
+	const size_t threads = pool->thread_count( pool );
+	par_job job = { 0 };
+	job.src = ( const char* )cont_ptr_begin( cont );
+	job.elemSize = cont_elem_size( cont );
+	job.predicate = predicate;
+	job.user = user;
+	job.stride = par_stride( sizeof( size_t ) );
+	job.partials = ( char* )sync_calloc_lines( threads, job.stride );
+	if( job.partials == nullptr )
+	{
+		err_set_result( Result_Bad_Alloc );
+		return 0;
+	}
+
+	size_t count = 0;
+	const size_t size = cont->size( cont );
+	if( pool->run( pool, size, par_grain( pool, size, job.elemSize, grain ), par_count_job, &job ) )
+	{
+		for( size_t i = 0; i < threads; ++i )
+		{
+			count += *( const size_t* )&job.partials[ i * job.stride ];
+		}
+	}
+
+	sync_free_lines( job.partials );
+	return count;
+}
+
+
+// Private definitions
+size_t par_grain( const threadpool* pool, const size_t count, const size_t elemSize, const size_t grain )
+{
+	if( grain != 0 )
+	{
+		return grain;
+	}
+
+	// A multiple of SYNC_CACHE_LINE elements is a multiple of SYNC_CACHE_LINE bytes for any element size
+	const size_t minimum = ( PAR_MIN_SPAN_BYTES + elemSize - 1 ) / ( elemSize != 0 ? elemSize : 1 );
+	const size_t split = count / ( pool->thread_count( pool ) * PAR_SPANS_PER_THREAD );
+	const size_t chosen = split > minimum ? split : minimum;
+	return ( chosen + SYNC_CACHE_LINE - 1 ) / SYNC_CACHE_LINE * SYNC_CACHE_LINE;
+}
+size_t par_stride( const size_t size )
+{
+	return ( size + SYNC_CACHE_LINE - 1 ) / SYNC_CACHE_LINE * SYNC_CACHE_LINE;
+}
+void par_for_each_job( const size_t first, const size_t last, const size_t worker, void* user )
+{
+	( void )worker;
+	par_job* job = ( par_job* )user;
+	if( sync_load_u32( &job->stopped ) != 0 )
+	{
+		return;
+	}
+
+	if( job->visitor( ( void* )&job->src[ first * job->elemSize ], last - first, job->elemSize, job->user ) == false )
+	{
+		sync_store_u32( &job->stopped, 1 );
+	}
+}
+void par_transform_job( const size_t first, const size_t last, const size_t worker, void* user )
+{
+	( void )worker;
+	const par_job* job = ( const par_job* )user;
+	const char* src = &job->src[ first * job->elemSize ];
+	char* dst = &job->dst[ first * job->dstElemSize ];
+
+	for( size_t i = first; i < last; ++i )
+	{
+		job->transform( src, dst, job->user );
+		src += job->elemSize;
+		dst += job->dstElemSize;
+	}
+}
+void par_reduce_job( const size_t first, const size_t last, const size_t worker, void* user )
+{
+	const par_job* job = ( const par_job* )user;
+	job->reduce( &job->src[ first * job->elemSize ], last - first, job->elemSize, &job->partials[ worker * job->stride ], job->user );
+}
+void par_count_job( const size_t first, const size_t last, const size_t worker, void* user )
+{
+	const par_job* job = ( const par_job* )user;
+	const char* elem = &job->src[ first * job->elemSize ];
+
+	// Count into a local so the shared slot is written once per span
+	size_t count = 0;
+	for( size_t i = first; i < last; ++i, elem += job->elemSize )
+	{
+		count += job->predicate( elem, job->user ) ? 1 : 0;
+	}
+	*( size_t* )&job->partials[ worker * job->stride ] += count;
+}
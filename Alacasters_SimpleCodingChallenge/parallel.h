@@ -0,0 +1,38 @@
+#pragma once
+
+#include "defines.h"
+#include "threadpool.h"
+#include "utility.h"
+#include <stddef.h>
+
+// Container operations split across a threadpool.  The elements are cut into contiguous spans of
+// grain elements which run concurrently, so callbacks must be safe to call from several threads at once
+// and only touch the elements they are handed.  A grain of 0 picks spans of at least PAR_MIN_SPAN_BYTES,
+// rounded to whole cache lines, with several spans per thread for stealing.
+// Inputs of one span or less run serially on the calling thread.
+#define PAR_MIN_SPAN_BYTES 16384
+#define PAR_SPANS_PER_THREAD 8
+
+// Writes the element at dst from the element at src
+typedef void( *element_transform )( const void* src, void* dst, void* user );
+// Folds count elements starting at first into accum
+typedef void( *span_reduce )( const void* first, const size_t count, const size_t elemSize, void* accum, void* user );
+// Folds the partial result other into accum
+typedef void( *reduce_combine )( void* accum, const void* other, void* user );
+
+// Like cont_for_each, spans are visited in no particular order.  A visitor returning false stops
+// spans that have not started yet and makes the call return false.
+bool par_for_each( threadpool* pool, const container* cont, const size_t grain, span_visitor visitor, void* user );
+
+// Resizes dst to the size of src and calls transform for every pair of elements.
+// src and dst may be the same container to transform in place.
+bool par_transform( threadpool* pool, const container* src, container* dst, const size_t grain, element_transform transform, void* user );
+
+// result holds the identity on entry and the reduction on return.  Every thread folds its spans into its own
+// copy of the identity, then the copies are combined.  Threads steal spans from each other, so a copy can
+// hold spans from anywhere in the container in any order: result must be plain data and both reduce and
+// combine commutative and associative.  Floating point sums may differ in the last bits between runs.
+bool par_reduce( threadpool* pool, const container* cont, const size_t grain, void* result, const size_t resultSize, span_reduce reduce, reduce_combine combine, void* user );
+
+// Returns how many elements match predicate
+size_t par_count_if( threadpool* pool, const container* cont, const size_t grain, element_predicate predicate, void* user );
@@ -0,0 +1,323 @@
+#include "profile.h"
+#include "customerror.h"
+#include "sync.h"
+#include <string.h>
+
+#if defined( CSAPI_PROFILE )
+#if defined( _WIN32 )
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#elif defined( __linux__ )
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+// A sample is the time followed by one value per hardware event, in prof_counters order
+typedef enum prof_sample_slot
+{
+	PROF_SAMPLE_TIME,
+	PROF_SAMPLE_CYCLES,
+	PROF_SAMPLE_INSTRUCTIONS,
+	PROF_SAMPLE_CACHE_MISSES,
+	PROF_SAMPLE_BRANCH_MISSES,
+	PROF_SAMPLE_COUNT
+}prof_sample_slot;
+
+#define PROF_EVENT_COUNT ( PROF_SAMPLE_COUNT - 1 )
+
+static const char* g_names[ PROF_REGION_COUNT ] =
+{
+	"cs_find",
+	"ss_extract",
+	"cont_reserve",
+	"user_0",
+	"user_1",
+	"user_2",
+	"user_3",
+	"user_4",
+	"user_5",
+	"user_6",
+	"user_7"
+};
+
+
+#if defined( CSAPI_PROFILE )
+typedef struct prof_thread
+{
+	// opened is set once the events were tried, hardware when they are counting
+	bool opened;
+	bool hardware;
+	// Every event is in the group of fds[ 0 ], one read of it returns them all
+	int fds[ PROF_EVENT_COUNT ];
+	uint64_t start[ PROF_REGION_COUNT ][ PROF_SAMPLE_COUNT ];
+	prof_counters totals[ PROF_REGION_COUNT ];
+}prof_thread;
+
+static SYNC_THREAD_LOCAL prof_thread g_thread;
+
+// Private forward declarations
+void prof_open( prof_thread* thread );
+void prof_close_events( prof_thread* thread, const size_t count );
+void prof_sample( const prof_thread* thread, uint64_t* sample );
+uint64_t prof_delta( const uint64_t start, const uint64_t end );
+uint64_t prof_now_ns( void );
+
+
+// Public definitions
+void prof_begin( const prof_region region )
+{
+	prof_thread* thread = &g_thread;
+	if( thread->opened == false )
+	{
+		prof_open( thread );
+	}
+
+	prof_sample( thread, thread->start[ region ] );
+}
+void prof_end( const prof_region region )
+{
+	prof_thread* thread = &g_thread;
+	uint64_t end[ PROF_SAMPLE_COUNT ];
+	prof_sample( thread, end );
+
+	const uint64_t* start = thread->start[ region ];
+	prof_counters* totals = &thread->totals[ region ];
+	++totals->calls;
+	totals->nanoseconds += prof_delta( start[ PROF_SAMPLE_TIME ], end[ PROF_SAMPLE_TIME ] );
+	totals->cycles += prof_delta( start[ PROF_SAMPLE_CYCLES ], end[ PROF_SAMPLE_CYCLES ] );
+	totals->instructions += prof_delta( start[ PROF_SAMPLE_INSTRUCTIONS ], end[ PROF_SAMPLE_INSTRUCTIONS ] );
+	totals->cache_misses += prof_delta( start[ PROF_SAMPLE_CACHE_MISSES ], end[ PROF_SAMPLE_CACHE_MISSES ] );
+	totals->branch_misses += prof_delta( start[ PROF_SAMPLE_BRANCH_MISSES ], end[ PROF_SAMPLE_BRANCH_MISSES ] );
+}
+_Bool prof_get_thread_stats( const prof_region region, prof_counters* counters )
+{
+	if( counters == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+	if( region >= PROF_REGION_COUNT )
+	{
+		err_set_result( Result_Invalid_Parameter );
+		return false;
+	}
+
+	*counters = g_thread.totals[ region ];
+	err_set_ok();
+	return true;
+}
+_Bool prof_thread_has_hardware( void )
+{
+	return g_thread.hardware;
+}
+void prof_reset_thread( void )
+{
+	memset( g_thread.totals, 0, sizeof( g_thread.totals ) );
+}
+void prof_close_thread( void )
+{
+	if( g_thread.hardware )
+	{
+		prof_close_events( &g_thread, PROF_EVENT_COUNT );
+	}
+	g_thread.opened = false;
+	g_thread.hardware = false;
+}
+#else
+_Bool prof_get_thread_stats( const prof_region region, prof_counters* counters )
+{
+	( void )region;
+	if( counters == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	memset( counters, 0, sizeof( prof_counters ) );
+	err_set_result( Result_Not_Initialized );
+	return false;
+}
+_Bool prof_thread_has_hardware( void )
+{
+	return false;
+}
+void prof_reset_thread( void )
+{
+}
+void prof_close_thread( void )
+{
+}
+#endif
+_Bool prof_set_region_name( const prof_region region, const char* name )
+{
+	if( name == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+	if( region >= PROF_REGION_COUNT )
+	{
+		err_set_result( Result_Invalid_Parameter );
+		return false;
+	}
+
+	g_names[ region ] = name;
+	err_set_ok();
+	return true;
+}
+const char* prof_region_name( const prof_region region )
+{
+	return region < PROF_REGION_COUNT ? g_names[ region ] : nullptr;
+}
+void prof_report_thread( FILE* out )
+{
+	if( out == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return;
+	}
+
+	bool header = false;
+	for( int region = 0; region < PROF_REGION_COUNT; ++region )
+	{
+		prof_counters counters = { 0 };
+		prof_get_thread_stats( ( prof_region )region, &counters );
+		if( counters.calls == 0 )
+		{
+			continue;
+		}
+
+		if( header == false )
+		{
+			fprintf( out, "%-14s %10s %14s %14s %14s %12s %12s %6s\n",
+				"region", "calls", "ns", "cycles", "instructions", "cache-miss", "branch-miss", "ipc" );
+			header = true;
+		}
+
+		const double ipc = counters.cycles != 0 ? ( double )counters.instructions / ( double )counters.cycles : 0.0;
+		fprintf( out, "%-14s %10llu %14llu %14llu %14llu %12llu %12llu %6.2f\n",
+			g_names[ region ],
+			( unsigned long long )counters.calls,
+			( unsigned long long )counters.nanoseconds,
+			( unsigned long long )counters.cycles,
+			( unsigned long long )counters.instructions,
+			( unsigned long long )counters.cache_misses,
+			( unsigned long long )counters.branch_misses,
+			ipc );
+	}
+	if( header && prof_thread_has_hardware() == false )
+	{
+		fprintf( out, "hardware counters unavailable, only calls and ns were counted\n" );
+	}
+	err_set_ok();
+}
+
+
+#if defined( CSAPI_PROFILE )
+// Private definitions
+void prof_open( prof_thread* thread )
+{
+	thread->opened = true;
+	thread->hardware = false;
+
+#if defined( __linux__ )
+	static const uint64_t events[ PROF_EVENT_COUNT ] =
+	{
+		PERF_COUNT_HW_CPU_CYCLES,
+		PERF_COUNT_HW_INSTRUCTIONS,
+		PERF_COUNT_HW_CACHE_MISSES,
+		PERF_COUNT_HW_BRANCH_MISSES
+	};
+#if defined( PERF_FLAG_FD_CLOEXEC )
+	const unsigned long flags = PERF_FLAG_FD_CLOEXEC;
+#else
+	const unsigned long flags = 0;
+#endif
+
+	for( size_t i = 0; i < PROF_EVENT_COUNT; ++i )
+	{
+		struct perf_event_attr attr;
+		memset( &attr, 0, sizeof( attr ) );
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof( attr );
+		attr.config = events[ i ];
+		// The leader starts disabled and enables the whole group at once below
+		attr.disabled = i == 0 ? 1 : 0;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP;
+
+		const int group = i == 0 ? -1 : thread->fds[ 0 ];
+		thread->fds[ i ] = ( int )syscall( SYS_perf_event_open, &attr, 0, -1, group, flags );
+		if( thread->fds[ i ] < 0 )
+		{
+			prof_close_events( thread, i );
+			return;
+		}
+	}
+
+	ioctl( thread->fds[ 0 ], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+	ioctl( thread->fds[ 0 ], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+	thread->hardware = true;
+#endif
+}
+void prof_close_events( prof_thread* thread, const size_t count )
+{
+#if defined( __linux__ )
+	for( size_t i = 0; i < count; ++i )
+	{
+		close( thread->fds[ i ] );
+		thread->fds[ i ] = -1;
+	}
+#else
+	( void )thread;
+	( void )count;
+#endif
+}
+void prof_sample( const prof_thread* thread, uint64_t* sample )
+{
+	memset( &sample[ PROF_SAMPLE_CYCLES ], 0, PROF_EVENT_COUNT * sizeof( uint64_t ) );
+
+#if defined( __linux__ )
+	if( thread->hardware )
+	{
+		// PERF_FORMAT_GROUP reads the event count followed by the values in the order they were opened
+		uint64_t values[ 1 + PROF_EVENT_COUNT ];
+		if( read( thread->fds[ 0 ], values, sizeof( values ) ) == ( ssize_t )sizeof( values ) )
+		{
+			memcpy( &sample[ PROF_SAMPLE_CYCLES ], &values[ 1 ], PROF_EVENT_COUNT * sizeof( uint64_t ) );
+		}
+	}
+#else
+	( void )thread;
+#endif
+
+	sample[ PROF_SAMPLE_TIME ] = prof_now_ns();
+}
+uint64_t prof_delta( const uint64_t start, const uint64_t end )
+{
+	// The values only grow, a smaller end means one of the reads failed and left zeros
+	return end >= start ? end - start : 0;
+}
+uint64_t prof_now_ns( void )
+{
+#if defined( _WIN32 )
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter( &counter );
+	QueryPerformanceFrequency( &frequency );
+	const uint64_t ticks = ( uint64_t )counter.QuadPart;
+	const uint64_t rate = ( uint64_t )frequency.QuadPart;
+	return ticks / rate * 1000000000ull + ticks % rate * 1000000000ull / rate;
+#else
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return ( uint64_t )now.tv_sec * 1000000000ull + ( uint64_t )now.tv_nsec;
+#endif
+}
+#endif
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "defines.h"
+#include <stdint.h>
+#include <stdio.h>
+
+// Hardware counter regions.  prof_begin and prof_end bracket a region and, when CSAPI_PROFILE is defined,
+// add the time and hardware events spent between them to the calling thread's totals for that region.
+// Without CSAPI_PROFILE they compile to nothing.
+//
+// The events come from perf_event_open on Linux and are opened on a thread's first prof_begin.  Elsewhere,
+// or when the kernel refuses them through perf_event_paranoid or a missing PMU, only calls and nanoseconds
+// are counted.  A begin and end pair costs two read system calls, so bracket whole calls and phases rather
+// than inner loops.  Regions nest, but a region must not be entered again before it ends on the same thread.
+typedef enum prof_region
+{
+	PROF_CS_FIND,
+	PROF_SS_EXTRACT,
+	PROF_CONT_RESERVE,		// only reserves that reallocate
+	// Free for applications, name them with prof_set_region_name
+	PROF_USER_0,
+	PROF_USER_1,
+	PROF_USER_2,
+	PROF_USER_3,
+	PROF_USER_4,
+	PROF_USER_5,
+	PROF_USER_6,
+	PROF_USER_7,
+	PROF_REGION_COUNT
+}prof_region;
+
+typedef struct prof_counters
+{
+	uint64_t calls;
+	uint64_t nanoseconds;
+	uint64_t cycles;
+	uint64_t instructions;
+	uint64_t cache_misses;		// last level cache misses
+	uint64_t branch_misses;
+}prof_counters;
+
+#if defined( CSAPI_PROFILE )
+void prof_begin( const prof_region region );
+void prof_end( const prof_region region );
+#else
+static __inline void prof_begin( const prof_region region )
+{
+	( void )region;
+}
+static __inline void prof_end( const prof_region region )
+{
+	( void )region;
+}
+#endif
+
+// Totals of the calling thread.  Without CSAPI_PROFILE they are zero and the call fails with Result_Not_Initialized.
+_Bool prof_get_thread_stats( const prof_region region, prof_counters* counters );
+// false when the calling thread only counts calls and nanoseconds
+_Bool prof_thread_has_hardware( void );
+void prof_reset_thread( void );
+// Releases the calling thread's event descriptors, profiled threads call it before they exit
+void prof_close_thread( void );
+
+// Names are shared by every thread, set them before profiling starts.  name must outlive its use.
+_Bool prof_set_region_name( const prof_region region, const char* name );
+const char* prof_region_name( const prof_region region );
+
+// Writes a table of the calling thread's regions that were entered at least once, nothing when none were
+void prof_report_thread( FILE* out );
@@ -2,38 +2,112 @@
 #include "customerror.h"
 #include "defines.h"
 #include "memory.h"
+#include "profile.h"
 #include "stringstream.h"
+#include "bitops.h"
+#include "convert.h"
+#include "sync.h"
+#include "tokenizer.h"
 #include <stdlib.h>
 #include <string.h>
 
-typedef struct _sstream
+// Shared positions of an SPSC stream.  Producer and consumer state live on separate cache lines,
+// each side keeps a cached copy of the other side's position to avoid touching its line.
+struct ss_spsc
 {
-	size_t readPos, writePos, alloc_size, str_size;
-	char* buffer;
-}_sstream;
+	size_t writePos, cachedRead, highWater;
+	uint32_t dataSeq, writerWaiting, closed;
+	char pad0[ SYNC_CACHE_LINE ];
+
+	size_t readPos, cachedWrite;
+	uint32_t spaceSeq, readerWaiting;
+	char pad1[ SYNC_CACHE_LINE ];
+
+	bool blocking;
+};
 
 // Private forward declarations
 bool ss_putchar( stringstream this, const char c );
+bool ss_write( stringstream this, const char* data, const size_t length );
+bool ss_write_ring( _sstream* stream, const char* data, const size_t length );
+char* ss_reserve( stringstream this, const size_t length );
+void ss_commit( _sstream* stream, const size_t length );
 bool ss_insert( stringstream this, const char* str );
 bool ss_insert_cstring( stringstream this, const cstring str );
+bool ss_write_buffer( stringstream this, const char* data, const size_t length );
 bool ss_eof( const stringstream this );
 
 bool ss_getchar( stringstream this, char* pc );
 bool ss_extract( stringstream this, cstring* output );
 bool ss_string( stringstream this, cstring* output );
 
-bool ss_seek( size_t* ptr, size_t maxSize, int offset, seekpos position );
+bool ss_seek( size_t* ptr, size_t minPos, size_t maxPos, int offset, seekpos position );
 bool ss_seekg( stringstream this, int offset, seekpos position );
 bool ss_seekp( stringstream this, int offset, seekpos position );
 size_t ss_tellg( stringstream this );
 size_t ss_tellp( stringstream this );
 
+bool ss_set_delimiters( stringstream this, const char* delimiters );
+size_t ss_count_tokens( const stringstream this );
+
+bool ss_find_line( const char* data, const size_t length, const line_terminator term, size_t* lineEnd, size_t* next );
+bool ss_getline( stringstream this, cstring* output, const line_terminator term );
+bool ss_next_line( stringstream this, string_slice* line, const line_terminator term );
+
+bool ss_read_int64( stringstream this, int64_t* value );
+bool ss_read_uint64( stringstream this, uint64_t* value );
+bool ss_read_double( stringstream this, double* value );
+bool ss_read_bool( stringstream this, bool* value );
+bool ss_read_value( stringstream this, const void* value, const char** data, size_t* length, size_t* skipped );
+bool ss_read_done( stringstream this, const bool parsed, const size_t consumed );
+bool ss_write_int64( stringstream this, const int64_t value );
+bool ss_write_uint64( stringstream this, const uint64_t value );
+bool ss_write_double( stringstream this, const double value );
+bool ss_write_bool( stringstream this, const bool value );
+char* ss_write_begin( stringstream this, char* scratch, const size_t maxLength );
+bool ss_write_end( stringstream this, const char* out, const char* scratch, const size_t length );
+
+bool ss_set_compaction( stringstream this, const ss_compaction policy );
+bool ss_get_stats( const stringstream this, ss_stats* stats );
+size_t ss_memory_usage( const stringstream this );
+
+char* ss_at( const _sstream* stream, const size_t pos );
+const char* ss_unread( _sstream* stream, size_t* length );
+void ss_consume( _sstream* stream, const size_t count );
+void ss_compact( _sstream* stream );
+void ss_linearize( _sstream* stream );
+void ss_reverse( char* first, char* last );
 bool ss_resize( stringstream this, size_t newSize );
 bool ss_isInitialized( stringstream this );
 
+bool ss_spsc_putchar( stringstream this, const char c );
+bool ss_spsc_insert( stringstream this, const char* str );
+bool ss_spsc_insert_cstring( stringstream this, const cstring str );
+bool ss_spsc_write_buffer( stringstream this, const char* data, const size_t length );
+bool ss_spsc_write( _sstream* stream, const char* data, const size_t length );
+bool ss_spsc_getchar( stringstream this, char* pc );
+bool ss_spsc_extract( stringstream this, cstring* output );
+bool ss_spsc_getline( stringstream this, cstring* output, const line_terminator term );
+bool ss_spsc_eof( const stringstream this );
+size_t ss_spsc_tellg( stringstream this );
+size_t ss_spsc_tellp( stringstream this );
+bool ss_spsc_get_stats( const stringstream this, ss_stats* stats );
+bool ss_spsc_seek( stringstream this, int offset, seekpos position );
+bool ss_spsc_string( stringstream this, cstring* output );
+bool ss_spsc_next_line( stringstream this, string_slice* line, const line_terminator term );
+size_t ss_spsc_count_tokens( const stringstream this );
+
+bool ss_spsc_poll( _sstream* stream, const size_t have, size_t* available );
+void ss_spsc_consume( _sstream* stream, const size_t pos );
+void ss_spsc_wait( volatile uint32_t* seq, volatile uint32_t* waiting, const volatile size_t* pos, const size_t seen, const volatile uint32_t* closed );
+void ss_spsc_notify( volatile uint32_t* seq, const volatile uint32_t* waiting );
+size_t ss_ring_find( const _sstream* stream, size_t from, const size_t to, const bool delimiter );
+size_t ss_ring_find_byte( const _sstream* stream, size_t from, const size_t to, const char c );
+bool ss_ring_copy( const _sstream* stream, const size_t from, const size_t to, cstring* output );
+
 bool ss_construct( stringstream* this )
 {
-	err_set_result( Result_Ok );
+	err_set_ok();
 	bool result = true;
 	_sstream* stream = nullptr;
 	const size_t alloc_size = 16;
@@ -45,7 +119,7 @@ bool ss_construct( stringstream* this )
 	}
 	if( result )
 	{
-		stream = stream = ( _sstream* )malloc( sizeof( _sstream ) );
+		stream = ( _sstream* )mem_alloc( MEM_STRINGSTREAM, sizeof( _sstream ) );
 		if( stream == nullptr )
 		{
 			err_set_result( Result_Bad_Alloc );
@@ -54,10 +128,10 @@ bool ss_construct( stringstream* this )
 	}
 	if( result )
 	{
-		stream->buffer = ( char* )malloc( alloc_size );
+		stream->buffer = ( char* )mem_alloc( MEM_STRINGSTREAM, alloc_size );
 		if( stream->buffer == nullptr )
 		{
-			free( stream );
+			mem_free( MEM_STRINGSTREAM, stream );
 			err_set_result( Result_Bad_Alloc );
 			result = false;
 		}
@@ -68,12 +142,19 @@ bool ss_construct( stringstream* this )
 		stream->readPos = 0;
 		stream->str_size = 0;
 		stream->writePos = 0;
+		stream->mode = SS_MODE_CONTIGUOUS;
+		stream->compaction = SS_COMPACT_NEVER;
+		stream->base = 0;
+		stream->high_water = 0;
+		stream->spsc = nullptr;
+		dc_whitespace( &stream->delims );
 
 		stringstream self;
 		self.extract = ss_extract;
 		self.getchar = ss_getchar;
 		self.insert = ss_insert;
 		self.insert_cstring = ss_insert_cstring;
+		self.write = ss_write_buffer;
 		self.putchar = ss_putchar;
 		self.tellg = ss_tellg;
 		self.tellp = ss_tellp;
@@ -81,6 +162,21 @@ bool ss_construct( stringstream* this )
 		self.seekp = ss_seekp;
 		self.string = ss_string;
 		self.eof = ss_eof;
+		self.set_delimiters = ss_set_delimiters;
+		self.count_tokens = ss_count_tokens;
+		self.getline = ss_getline;
+		self.next_line = ss_next_line;
+		self.read_int64 = ss_read_int64;
+		self.read_uint64 = ss_read_uint64;
+		self.read_double = ss_read_double;
+		self.read_bool = ss_read_bool;
+		self.write_int64 = ss_write_int64;
+		self.write_uint64 = ss_write_uint64;
+		self.write_double = ss_write_double;
+		self.write_bool = ss_write_bool;
+		self.set_compaction = ss_set_compaction;
+		self.stats = ss_get_stats;
+		self.memory_usage = ss_memory_usage;
 		self.stream = stream;
 
 		*this = self;
@@ -88,9 +184,102 @@ bool ss_construct( stringstream* this )
 
 	return result;
 }
+bool ss_ring_construct( stringstream* this, const size_t capacity )
+{
+	err_set_ok();
+	bool result = true;
+	size_t alloc_size = 16;
+
+	if( capacity == 0 )
+	{
+		err_set_result( Result_Invalid_Parameter );
+		result = false;
+	}
+	if( result )
+	{
+		result = ss_construct( this );
+	}
+	if( result )
+	{
+		// Round up so positions can be wrapped with a mask
+		while( alloc_size < capacity )
+		{
+			alloc_size *= 2;
+		}
+
+		result = ss_resize( *this, alloc_size );
+		if( result == false )
+		{
+			ss_destroy( this );
+			err_set_result( Result_Bad_Alloc );
+		}
+	}
+	if( result )
+	{
+		this->stream->mode = SS_MODE_RING;
+	}
+
+	return result;
+}
+bool ss_spsc_construct( stringstream* this, const size_t capacity, const bool blocking )
+{
+	ss_spsc* spsc = nullptr;
+	bool result = ss_ring_construct( this, capacity );
+
+	if( result )
+	{
+		spsc = ( ss_spsc* )mem_alloc( MEM_STRINGSTREAM, sizeof( ss_spsc ) );
+		if( spsc == nullptr )
+		{
+			ss_destroy( this );
+			err_set_result( Result_Bad_Alloc );
+			result = false;
+		}
+	}
+	if( result )
+	{
+		memset( spsc, 0, sizeof( ss_spsc ) );
+		spsc->blocking = blocking;
+
+		this->stream->spsc = spsc;
+		this->stream->mode = SS_MODE_SPSC;
+
+		this->putchar = ss_spsc_putchar;
+		this->insert = ss_spsc_insert;
+		this->insert_cstring = ss_spsc_insert_cstring;
+		this->write = ss_spsc_write_buffer;
+		this->getchar = ss_spsc_getchar;
+		this->extract = ss_spsc_extract;
+		this->getline = ss_spsc_getline;
+		this->eof = ss_spsc_eof;
+		this->tellg = ss_spsc_tellg;
+		this->tellp = ss_spsc_tellp;
+		this->stats = ss_spsc_get_stats;
+		this->seekg = ss_spsc_seek;
+		this->seekp = ss_spsc_seek;
+		this->string = ss_spsc_string;
+		this->next_line = ss_spsc_next_line;
+		this->count_tokens = ss_spsc_count_tokens;
+	}
+
+	return result;
+}
+void ss_spsc_close( stringstream this )
+{
+	ss_spsc* spsc = this.stream->spsc;
+	if( spsc == nullptr )
+	{
+		err_set_result( Result_Invalid_Parameter );
+		return;
+	}
+
+	sync_store_u32( &spsc->closed, 1 );
+	sync_fetch_add_u32( &spsc->dataSeq, 1 );
+	sync_wake_all( &spsc->dataSeq );
+}
 void ss_destroy( stringstream* this )
 {
-	err_set_result( Result_Ok );
+	err_set_ok();
 
 	bool result = true;
 
@@ -112,24 +301,37 @@ void ss_destroy( stringstream* this )
 		this->tellg = nullptr;
 		this->tellp = nullptr;
 		this->eof = nullptr;
+		this->set_delimiters = nullptr;
+		this->count_tokens = nullptr;
+		this->getline = nullptr;
+		this->next_line = nullptr;
+		this->read_int64 = nullptr;
+		this->read_uint64 = nullptr;
+		this->read_double = nullptr;
+		this->read_bool = nullptr;
+		this->write_int64 = nullptr;
+		this->write_uint64 = nullptr;
+		this->write_double = nullptr;
+		this->write_bool = nullptr;
+		this->set_compaction = nullptr;
+		this->stats = nullptr;
+		this->memory_usage = nullptr;
 
-		this->stream->alloc_size = 0;
-		this->stream->readPos = 0;
-		this->stream->str_size = 0;
-		this->stream->writePos = 0;
-
-		SafeDelete( &this->stream->buffer );
+		mem_free( MEM_STRINGSTREAM, this->stream->buffer );
+		mem_free( MEM_STRINGSTREAM, this->stream->spsc );
+		mem_free( MEM_STRINGSTREAM, this->stream );
+		this->stream = nullptr;
 	}
 }
 bool ss_resize( stringstream this, size_t newSize )
 {
-	err_set_result( Result_Ok );
+	err_set_ok();
 	char* buffer = nullptr;
 	bool result = newSize >= this.stream->alloc_size;
 
 	if( result )
 	{
-		buffer = ( char* )malloc( newSize );
+		buffer = ( char* )mem_alloc( MEM_STRINGSTREAM, newSize );
 		if( buffer == nullptr )
 		{
 			err_set_result( Result_Bad_Alloc );
@@ -138,36 +340,99 @@ bool ss_resize( stringstream this, size_t newSize )
 	}
 	if( result )
 	{
+		mem_count_grow( MEM_STRINGSTREAM );
 		memset( buffer, 0, newSize );
-		memcpy( buffer, this.stream->buffer, this.stream->str_size );
-		SafeDelete( &this.stream->buffer );
+		memcpy( buffer, this.stream->buffer, this.stream->str_size - this.stream->base );
+		mem_free( MEM_STRINGSTREAM, this.stream->buffer );
 		this.stream->buffer = buffer;
 		this.stream->alloc_size = newSize;
 	}
-	
+
 	return result;
 }
 bool ss_putchar( stringstream this, const char c )
 {
-	err_set_result( Result_Ok );
+	return ss_write( this, &c, 1 );
+}
+bool ss_write( stringstream this, const char* data, const size_t length )
+{
+	err_set_ok();
 
-	bool result = this.stream->str_size >= this.stream->alloc_size;
+	_sstream* stream = this.stream;
+	if( stream->mode == SS_MODE_RING )
+	{
+		return ss_write_ring( stream, data, length );
+	}
 
-	if( result )
+	char* out = ss_reserve( this, length );
+	if( out == nullptr )
 	{
-		result = ss_resize( this, this.stream->alloc_size * 3 / 2 );
+		return false;
 	}
-	if( result )
+
+	memcpy( out, data, length );
+	ss_commit( stream, length );
+	return true;
+}
+char* ss_reserve( stringstream this, const size_t length )
+{
+	_sstream* stream = this.stream;
+	bool result = true;
+
+	if( stream->writePos - stream->base + length > stream->alloc_size &&
+		( stream->compaction & SS_COMPACT_ON_GROW ) != 0 )
 	{
-		this.stream->buffer[ this.stream->writePos++ ] = c;
-		++this.stream->str_size;
+		ss_compact( stream );
 	}
 
-	return result;
+	const size_t required = stream->writePos - stream->base + length;
+	if( required > stream->alloc_size )
+	{
+		const size_t grown = stream->alloc_size * 3 / 2;
+		result = ss_resize( this, required > grown ? required : grown );
+	}
+
+	return result ? ss_at( stream, stream->writePos ) : nullptr;
+}
+void ss_commit( _sstream* stream, const size_t length )
+{
+	stream->writePos += length;
+	if( stream->writePos > stream->str_size )
+	{
+		stream->str_size = stream->writePos;
+	}
+	if( stream->str_size - stream->base > stream->high_water )
+	{
+		stream->high_water = stream->str_size - stream->base;
+	}
+}
+bool ss_write_ring( _sstream* stream, const char* data, const size_t length )
+{
+	const size_t used = stream->writePos - stream->readPos;
+	if( length > stream->alloc_size - used )
+	{
+		err_set_result( Result_Buffer_Full );
+		return false;
+	}
+
+	// Split the copy where it wraps around the end of the buffer
+	const size_t phys = ( stream->writePos - stream->base ) & ( stream->alloc_size - 1 );
+	const size_t first = length < stream->alloc_size - phys ? length : stream->alloc_size - phys;
+	memcpy( &stream->buffer[ phys ], data, first );
+	memcpy( stream->buffer, data + first, length - first );
+
+	stream->writePos += length;
+	stream->str_size = stream->writePos;
+	if( used + length > stream->high_water )
+	{
+		stream->high_water = used + length;
+	}
+
+	return true;
 }
 bool ss_insert( stringstream this, const char* str )
 {
-	err_set_result( Result_Ok );
+	err_set_ok();
 	bool result = true;
 
 	if( str == nullptr )
@@ -177,35 +442,33 @@ bool ss_insert( stringstream this, const char* str )
 	}
 	if( result )
 	{
-		const char *iter = str;
-		while( *iter != '\0' && result == true )
-		{
-			result = ss_putchar( this, *iter );
-		}
+		result = ss_write( this, str, strlen( str ) );
 	}
 
 	return result;
 }
 bool ss_insert_cstring( stringstream this, const cstring str )
 {
-	err_set_result( Result_Ok );
-	bool result = true;
-
-	for( size_t i = 0; i < str.size( &str ) && result == true; ++i )
+	return ss_write( this, str.str( &str ), str.size( &str ) );
+}
+bool ss_write_buffer( stringstream this, const char* data, const size_t length )
+{
+	if( data == nullptr && length > 0 )
 	{
-		char c = 0;
-		result = str.at_get( &str, i, &c );
-		if( result )
-		{
-			result = ss_putchar( this, c );
-		}
+		err_set_result( Result_Bad_Pointer );
+		return false;
+	}
+	if( length == 0 )
+	{
+		err_set_ok();
+		return true;
 	}
 
-	return result;
+	return ss_write( this, data, length );
 }
 bool ss_getchar( stringstream this, char* pc )
 {
-	err_set_result( Result_Ok );
+	err_set_ok();
 
 	bool result = true;
 	if( pc == nullptr )
@@ -215,21 +478,31 @@ bool ss_getchar( stringstream this, char* pc )
 	}
 	if( result )
 	{
-		result = ss_eof( this );
+		// Reaching the end of the stream is not an error, the result code is Result_Ok
+		result = ss_eof( this ) == false;
+		if( result == false )
+		{
+			err_set_result( Result_Ok );
+		}
 	}
-	if( result == false && err_get_result() == Result_Ok )
+	if( result )
 	{
-		*pc = this.stream->buffer[ this.stream->readPos++ ];
+		*pc = *ss_at( this.stream, this.stream->readPos );
+		ss_consume( this.stream, 1 );
 	}
 
 	return result;
 }
 bool ss_extract( stringstream this, cstring* output )
 {
-	err_set_result( Result_Ok );
+	prof_begin( PROF_SS_EXTRACT );
+	err_set_ok();
 
 	cstring out = { 0 };
+	token_span span = { 0 };
+	const char* data = nullptr;
 	bool result = true;
+	bool found = false;
 
 	if( output == nullptr )
 	{
@@ -238,26 +511,21 @@ bool ss_extract( stringstream this, cstring* output )
 	}
 	if( result )
 	{
-		result = cs_reserve_construct( &out, this.stream->str_size );
-	}
-	if( result )
-	{
-		for( char c = 0; c != -1 && !isspace( c ) && result == true; )
+		size_t remaining = 0;
+		size_t pos = 0;
+
+		data = ss_unread( this.stream, &remaining );
+		found = tok_next( &this.stream->delims, data, remaining, &pos, &span );
+
+		// An exhausted stream still hands back a valid empty string
+		result = found ?
+			cs_buffer_construct( &out, &data[ span.offset ], span.length ) :
+			cs_default_construct( &out );
+		if( result )
 		{
-			result = ss_getchar( this, &c );
-			if( result )
-			{
-				result = out.push_back( &out, c );
-			}
+			ss_consume( this.stream, pos );
 		}
 	}
-
-	// ss_getchar can return false if a char was not retrieved like at the end of stream
-	// but still set result code to Result_Ok since this is not an error.
-	// In order to not confuse other error checking, 
-	// result is set to true again if this is the case
-	result = ( err_get_result() == Result_Ok );
-
 	if( result )
 	{
 		if( output->at_get != nullptr )
@@ -265,13 +533,21 @@ bool ss_extract( stringstream this, cstring* output )
 			cs_destroy_cstring( output );
 		}
 		*output = out;
+
+		// Running out of tokens is not an error, the result code is Result_Ok
+		result = found;
+		if( found == false )
+		{
+			err_set_result( Result_Ok );
+		}
 	}
 
+	prof_end( PROF_SS_EXTRACT );
 	return result;
 }
 bool ss_string( stringstream this, cstring* output )
 {
-	err_set_result( Result_Ok );
+	err_set_ok();
 	bool result = true;
 	cstring out = { 0 };
 
@@ -282,18 +558,16 @@ bool ss_string( stringstream this, cstring* output )
 	}
 	if( result )
 	{
-		result = cs_reserve_construct( &out, this.stream->str_size );
-	}
-	if( result )
-	{
-		for( size_t i = 0; i < this.stream->str_size && result == true; ++i )
+		// Ring streams only hold unread bytes, contiguous streams everything that was not compacted
+		if( this.stream->mode == SS_MODE_RING )
 		{
-			result = out.push_back( &out, this.stream->buffer[ i ] );
+			ss_linearize( this.stream );
 		}
+		result = cs_buffer_construct( &out, ss_at( this.stream, this.stream->base ), this.stream->str_size - this.stream->base );
 	}
 	if( result )
 	{
-		if( output->empty( output ) == false )
+		if( output->at_get != nullptr )
 		{
 			cs_destroy_cstring( output );
 		}
@@ -302,69 +576,944 @@ bool ss_string( stringstream this, cstring* output )
 
 	return result;
 }
-bool ss_seek( size_t* ptr, size_t maxSize, int offset, seekpos position )
+bool ss_seek( size_t* ptr, size_t minPos, size_t maxPos, int offset, seekpos position )
 {
-	err_set_result( Result_Invalid_Parameter );
 	bool result = false;
 
-	const int newvalue = ( int )*ptr + offset;
+	size_t origin = *ptr;
 	if( position == SS_SEEK_BEG )
 	{
-		if( offset >= 0 && newvalue < ( int )maxSize )
-		{
-			result = true;
-		}
+		origin = minPos;
 	}
-	else if( position == SS_SEEK_CUR )
+	else if( position == SS_SEEK_END )
 	{
-		if( newvalue >= 0 && newvalue < (int)maxSize )
-		{
-			result = true;
-		}
+		origin = maxPos;
+	}
+
+	if( offset < 0 )
+	{
+		const size_t distance = ( size_t )( -( long long )offset );
+		result = distance <= origin - minPos;
 	}
 	else
 	{
-		if( offset < 0 && newvalue >= 0 )
-		{
-			result = true;
-		}
+		result = ( size_t )offset <= maxPos - origin;
 	}
 
 	if( result )
 	{
-		err_set_result( Result_Ok );
-		( int )*ptr = newvalue;
+		err_set_ok();
+		*ptr = origin + offset;
+	}
+	else
+	{
+		err_set_result( Result_Invalid_Parameter );
 	}
 
 	return result;
 }
 bool ss_seekg( stringstream this, int offset, seekpos position )
 {
-	err_set_result( Result_Ok );
-	return ss_seek( &this.stream->readPos, this.stream->str_size, offset, position );
+	err_set_ok();
+
+	// Bytes behind the read position of a ring may already be overwritten
+	const size_t minPos = this.stream->mode == SS_MODE_RING ? this.stream->readPos : this.stream->base;
+	return ss_seek( &this.stream->readPos, minPos, this.stream->str_size, offset, position );
 }
 bool ss_seekp( stringstream this, int offset, seekpos position )
 {
-	err_set_result( Result_Ok );
-	return ss_seek( &this.stream->writePos, this.stream->str_size, offset, position );
+	err_set_ok();
+
+	if( this.stream->mode == SS_MODE_RING )
+	{
+		err_set_result( Result_Invalid_Parameter );
+		return false;
+	}
+
+	return ss_seek( &this.stream->writePos, this.stream->base, this.stream->str_size, offset, position );
 }
 size_t ss_tellg( stringstream this )
 {
-	err_set_result( Result_Ok );
+	err_set_ok();
 	return this.stream->readPos;
 }
 size_t ss_tellp( stringstream this )
 {
-	err_set_result( Result_Ok );
+	err_set_ok();
 	return this.stream->writePos;
 }
 bool ss_eof( const stringstream this )
 {
-	err_set_result( Result_Ok );
+	err_set_ok();
 	return this.stream->readPos >= this.stream->str_size;
 }
-bool ss_isInitialized( stringstream this )
+bool ss_set_delimiters( stringstream this, const char* delimiters )
+{
+	return dc_construct( &this.stream->delims, delimiters );
+}
+size_t ss_count_tokens( const stringstream this )
+{
+	err_set_ok();
+
+	size_t remaining = 0;
+	const char* data = ss_unread( this.stream, &remaining );
+
+	return tok_count( &this.stream->delims, data, remaining );
+}
+bool ss_find_line( const char* data, const size_t length, const line_terminator term, size_t* lineEnd, size_t* next )
+{
+	if( length == 0 )
+	{
+		return false;
+	}
+
+	for( size_t pos = 0; pos < length; )
+	{
+		const char* found = ( const char* )memchr( &data[ pos ], term.delim, length - pos );
+		if( found == nullptr )
+		{
+			break;
+		}
+
+		const size_t at = ( size_t )( found - data );
+		if( term.crlf == false )
+		{
+			*lineEnd = at;
+			*next = at + 1;
+			return true;
+		}
+		if( at > 0 && data[ at - 1 ] == '\r' )
+		{
+			*lineEnd = at - 1;
+			*next = at + 1;
+			return true;
+		}
+
+		pos = at + 1;
+	}
+
+	// Final record without a terminator
+	*lineEnd = length;
+	*next = length;
+	return true;
+}
+bool ss_getline( stringstream this, cstring* output, const line_terminator term )
+{
+	err_set_ok();
+
+	cstring out = { 0 };
+	size_t lineEnd = 0, next = 0;
+	bool result = true;
+	bool found = false;
+
+	if( output == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		result = false;
+	}
+	if( result )
+	{
+		size_t remaining = 0;
+		const char* data = ss_unread( this.stream, &remaining );
+
+		found = ss_find_line( data, remaining, term, &lineEnd, &next );
+
+		// An exhausted stream still hands back a valid empty string
+		result = found ?
+			cs_buffer_construct( &out, data, lineEnd ) :
+			cs_default_construct( &out );
+	}
+	if( result )
+	{
+		if( found )
+		{
+			ss_consume( this.stream, next );
+		}
+		if( output->at_get != nullptr )
+		{
+			cs_destroy_cstring( output );
+		}
+		*output = out;
+
+		// Running out of lines is not an error, the result code is Result_Ok
+		result = found;
+		if( found == false )
+		{
+			err_set_result( Result_Ok );
+		}
+	}
+
+	return result;
+}
+bool ss_next_line( stringstream this, string_slice* line, const line_terminator term )
+{
+	err_set_ok();
+
+	const char* data = nullptr;
+	size_t lineEnd = 0, next = 0;
+	bool result = true;
+
+	if( line == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		result = false;
+	}
+	if( result )
+	{
+		size_t remaining = 0;
+		data = ss_unread( this.stream, &remaining );
+		result = ss_find_line( data, remaining, term, &lineEnd, &next );
+	}
+	if( result )
+	{
+		// The slice points into the stream buffer and is only valid until the next read or write call.
+		// A later read can linearize a wrapped ring in place, which moves the bytes under the slice.
+		line->data = data;
+		line->length = lineEnd;
+		ss_consume( this.stream, next );
+	}
+	else if( line != nullptr )
+	{
+		// Out of lines is not a failure
+		line->data = nullptr;
+		line->length = 0;
+		err_set_result( Result_Ok );
+	}
+
+	return result;
+}
+bool ss_read_int64( stringstream this, int64_t* value )
+{
+	const char* data = nullptr;
+	size_t length = 0, used = 0, skipped = 0;
+
+	if( ss_read_value( this, value, &data, &length, &skipped ) == false )
+	{
+		return false;
+	}
+
+	const bool parsed = cv_parse_int64( data, length, value, &used );
+	return ss_read_done( this, parsed, skipped + used );
+}
+bool ss_read_uint64( stringstream this, uint64_t* value )
+{
+	const char* data = nullptr;
+	size_t length = 0, used = 0, skipped = 0;
+
+	if( ss_read_value( this, value, &data, &length, &skipped ) == false )
+	{
+		return false;
+	}
+
+	const bool parsed = cv_parse_uint64( data, length, value, &used );
+	return ss_read_done( this, parsed, skipped + used );
+}
+bool ss_read_double( stringstream this, double* value )
+{
+	const char* data = nullptr;
+	size_t length = 0, used = 0, skipped = 0;
+
+	if( ss_read_value( this, value, &data, &length, &skipped ) == false )
+	{
+		return false;
+	}
+
+	const bool parsed = cv_parse_double( data, length, value, &used );
+	return ss_read_done( this, parsed, skipped + used );
+}
+bool ss_read_bool( stringstream this, bool* value )
+{
+	const char* data = nullptr;
+	size_t length = 0, used = 0, skipped = 0;
+
+	if( ss_read_value( this, value, &data, &length, &skipped ) == false )
+	{
+		return false;
+	}
+
+	const bool parsed = cv_parse_bool( data, length, value, &used );
+	return ss_read_done( this, parsed, skipped + used );
+}
+bool ss_read_value( stringstream this, const void* value, const char** data, size_t* length, size_t* skipped )
+{
+	err_set_ok();
+
+	if( value == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+	if( this.stream->mode == SS_MODE_SPSC )
+	{
+		err_set_result( Result_Invalid_Parameter );
+		return false;
+	}
+
+	size_t remaining = 0;
+	const char* unread = ss_unread( this.stream, &remaining );
+
+	size_t skip = 0;
+	while( skip < remaining && dc_is_delimiter( &this.stream->delims, unread[ skip ] ) )
+	{
+		++skip;
+	}
+
+	// Running out of values is not an error, the result code is Result_Ok.  Only delimiters were left,
+	// so they are consumed.  Otherwise ss_read_done consumes them together with the value, which
+	// leaves a rejected value and the delimiters before it unread.
+	*data = &unread[ skip ];
+	*length = remaining - skip;
+	*skipped = skip;
+	if( *length == 0 )
+	{
+		ss_consume( this.stream, skip );
+		err_set_result( Result_Ok );
+		return false;
+	}
+	return true;
+}
+bool ss_read_done( stringstream this, const bool parsed, const size_t consumed )
+{
+	if( parsed == false )
+	{
+		err_set_result( Result_Invalid_Parameter );
+		return false;
+	}
+
+	ss_consume( this.stream, consumed );
+	return true;
+}
+bool ss_write_int64( stringstream this, const int64_t value )
 {
-	err_set_result( Result_Ok );
-	return ( this.extract == ss_extract && this.stream != nullptr );
+	char scratch[ CV_MAX_INT_CHARS ];
+	char* out = ss_write_begin( this, scratch, sizeof( scratch ) );
+
+	return out != nullptr && ss_write_end( this, out, scratch, cv_format_int64( out, value ) );
+}
+bool ss_write_uint64( stringstream this, const uint64_t value )
+{
+	char scratch[ CV_MAX_INT_CHARS ];
+	char* out = ss_write_begin( this, scratch, sizeof( scratch ) );
+
+	return out != nullptr && ss_write_end( this, out, scratch, cv_format_uint64( out, value ) );
+}
+bool ss_write_double( stringstream this, const double value )
+{
+	char scratch[ CV_MAX_DOUBLE_CHARS ];
+	char* out = ss_write_begin( this, scratch, sizeof( scratch ) );
+
+	return out != nullptr && ss_write_end( this, out, scratch, cv_format_double( out, value ) );
+}
+bool ss_write_bool( stringstream this, const bool value )
+{
+	char scratch[ CV_MAX_BOOL_CHARS ];
+	char* out = ss_write_begin( this, scratch, sizeof( scratch ) );
+
+	return out != nullptr && ss_write_end( this, out, scratch, cv_format_bool( out, value ) );
+}
+char* ss_write_begin( stringstream this, char* scratch, const size_t maxLength )
+{
+	// Ring and SPSC buffers may wrap inside the value, those format into scratch and copy
+	if( this.stream->mode != SS_MODE_CONTIGUOUS )
+	{
+		return scratch;
+	}
+
+	err_set_ok();
+	return ss_reserve( this, maxLength );
+}
+bool ss_write_end( stringstream this, const char* out, const char* scratch, const size_t length )
+{
+	if( out != scratch )
+	{
+		ss_commit( this.stream, length );
+		return true;
+	}
+	if( this.stream->mode == SS_MODE_SPSC )
+	{
+		return ss_spsc_write( this.stream, scratch, length );
+	}
+
+	return ss_write( this, scratch, length );
+}
+bool ss_set_compaction( stringstream this, const ss_compaction policy )
+{
+	err_set_ok();
+
+	if( this.stream->mode != SS_MODE_CONTIGUOUS )
+	{
+		err_set_result( Result_Invalid_Parameter );
+		return false;
+	}
+
+	this.stream->compaction = policy;
+	return true;
+}
+size_t ss_memory_usage( const stringstream this )
+{
+	const _sstream* stream = this.stream;
+	return sizeof( _sstream ) + stream->alloc_size + ( stream->spsc != nullptr ? sizeof( ss_spsc ) : 0 );
+}
+bool ss_get_stats( const stringstream this, ss_stats* stats )
+{
+	err_set_ok();
+
+	if( stats == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	const _sstream* stream = this.stream;
+	const size_t oldest = stream->mode == SS_MODE_RING ? stream->readPos : stream->base;
+
+	stats->occupancy = stream->str_size - stream->readPos;
+	stats->retained = stream->str_size - oldest;
+	stats->capacity = stream->alloc_size;
+	stats->high_water = stream->high_water;
+	stats->reclaimed = oldest;
+
+	return true;
+}
+char* ss_at( const _sstream* stream, const size_t pos )
+{
+	if( stream->mode == SS_MODE_RING )
+	{
+		return &stream->buffer[ ( pos - stream->base ) & ( stream->alloc_size - 1 ) ];
+	}
+
+	return &stream->buffer[ pos - stream->base ];
+}
+const char* ss_unread( _sstream* stream, size_t* length )
+{
+	if( stream->readPos >= stream->str_size )
+	{
+		*length = 0;
+		return ss_at( stream, stream->str_size );
+	}
+
+	// Scanners need the unread bytes in one piece
+	if( stream->mode == SS_MODE_RING )
+	{
+		const size_t phys = ( stream->readPos - stream->base ) & ( stream->alloc_size - 1 );
+		if( phys + ( stream->str_size - stream->readPos ) > stream->alloc_size )
+		{
+			ss_linearize( stream );
+		}
+	}
+
+	*length = stream->str_size - stream->readPos;
+	return ss_at( stream, stream->readPos );
+}
+void ss_consume( _sstream* stream, const size_t count )
+{
+	stream->readPos += count;
+
+	if( stream->mode == SS_MODE_CONTIGUOUS &&
+		( stream->compaction & SS_COMPACT_ON_DRAIN ) != 0 &&
+		stream->readPos >= stream->str_size &&
+		stream->writePos >= stream->str_size )
+	{
+		stream->base = stream->str_size;
+	}
+}
+void ss_compact( _sstream* stream )
+{
+	// Bytes behind both the read and the write position are no longer reachable
+	const size_t keep = stream->readPos < stream->writePos ? stream->readPos : stream->writePos;
+	if( keep > stream->base )
+	{
+		memmove( stream->buffer, ss_at( stream, keep ), stream->str_size - keep );
+		stream->base = keep;
+	}
+}
+void ss_linearize( _sstream* stream )
+{
+	// Rotate the ring in place so readPos lands on buffer[ 0 ]
+	const size_t phys = ( stream->readPos - stream->base ) & ( stream->alloc_size - 1 );
+	if( phys != 0 )
+	{
+		ss_reverse( stream->buffer, &stream->buffer[ phys ] );
+		ss_reverse( &stream->buffer[ phys ], &stream->buffer[ stream->alloc_size ] );
+		ss_reverse( stream->buffer, &stream->buffer[ stream->alloc_size ] );
+	}
+	stream->base = stream->readPos;
+}
+void ss_reverse( char* first, char* last )
+{
+	while( first < last )
+	{
+		--last;
+		const char c = *first;
+		*first++ = *last;
+		*last = c;
+	}
+}
+bool ss_isInitialized( stringstream this )
+{
+	err_set_ok();
+	return ( ( this.extract == ss_extract || this.extract == ss_spsc_extract ) && this.stream != nullptr );
+}
+
+// SPSC definitions
+// Producer side: putchar, insert, insert_cstring, tellp
+// Consumer side: getchar, extract, getline, eof, tellg
+bool ss_spsc_putchar( stringstream this, const char c )
+{
+	return ss_spsc_write( this.stream, &c, 1 );
+}
+bool ss_spsc_insert( stringstream this, const char* str )
+{
+	if( str == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	return ss_spsc_write( this.stream, str, strlen( str ) );
+}
+bool ss_spsc_insert_cstring( stringstream this, const cstring str )
+{
+	return ss_spsc_write( this.stream, str.str( &str ), str.size( &str ) );
+}
+bool ss_spsc_write_buffer( stringstream this, const char* data, const size_t length )
+{
+	if( data == nullptr && length > 0 )
+	{
+		err_set_result( Result_Bad_Pointer );
+		return false;
+	}
+	if( length == 0 )
+	{
+		err_set_ok();
+		return true;
+	}
+
+	return ss_spsc_write( this.stream, data, length );
+}
+bool ss_spsc_write( _sstream* stream, const char* data, const size_t length )
+{
+	ss_spsc* spsc = stream->spsc;
+	const size_t capacity = stream->alloc_size;
+	size_t pos = spsc->writePos;
+	size_t done = 0;
+
+	while( done < length )
+	{
+		size_t space = capacity - ( pos - spsc->cachedRead );
+		if( space < length - done )
+		{
+			spsc->cachedRead = sync_load_acquire( &spsc->readPos );
+			space = capacity - ( pos - spsc->cachedRead );
+		}
+
+		// Non-blocking writes are all or nothing
+		if( spsc->blocking == false && space < length )
+		{
+			err_set_result( Result_Buffer_Full );
+			return false;
+		}
+		if( space == 0 )
+		{
+			ss_spsc_wait( &spsc->spaceSeq, &spsc->writerWaiting, &spsc->readPos, spsc->cachedRead, nullptr );
+			continue;
+		}
+
+		// Blocking writes larger than the free space go out in pieces
+		const size_t count = length - done < space ? length - done : space;
+		const size_t phys = pos & ( capacity - 1 );
+		const size_t first = count < capacity - phys ? count : capacity - phys;
+		memcpy( &stream->buffer[ phys ], data + done, first );
+		memcpy( stream->buffer, data + done + first, count - first );
+
+		pos += count;
+		done += count;
+		sync_store_release( &spsc->writePos, pos );
+		ss_spsc_notify( &spsc->dataSeq, &spsc->readerWaiting );
+
+		if( pos - spsc->cachedRead > spsc->highWater )
+		{
+			sync_store_release( &spsc->highWater, pos - spsc->cachedRead );
+		}
+	}
+
+	return true;
+}
+bool ss_spsc_getchar( stringstream this, char* pc )
+{
+	size_t available = 0;
+
+	if( pc == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+	if( ss_spsc_poll( this.stream, 0, &available ) == false )
+	{
+		return false;
+	}
+
+	const size_t pos = this.stream->spsc->readPos;
+	*pc = this.stream->buffer[ pos & ( this.stream->alloc_size - 1 ) ];
+	ss_spsc_consume( this.stream, pos + 1 );
+
+	return true;
+}
+bool ss_spsc_extract( stringstream this, cstring* output )
+{
+	_sstream* stream = this.stream;
+	cstring out = { 0 };
+	size_t have = 0;
+
+	if( output == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	for( ;; )
+	{
+		size_t available = 0;
+		const bool more = ss_spsc_poll( stream, have, &available );
+		if( more == false && err_get_result() != Result_Ok )
+		{
+			return false;
+		}
+
+		const size_t end = stream->spsc->readPos + available;
+		const size_t start = ss_ring_find( stream, stream->spsc->readPos, end, false );
+
+		// Leading delimiters can be released right away
+		if( start != stream->spsc->readPos )
+		{
+			ss_spsc_consume( stream, start );
+		}
+		if( start == end )
+		{
+			if( more == false )
+			{
+				// Closed and drained, hand back a valid empty string like extract does
+				if( cs_default_construct( &out ) == false )
+				{
+					return false;
+				}
+				if( output->at_get != nullptr )
+				{
+					cs_destroy_cstring( output );
+				}
+				*output = out;
+				err_set_result( Result_Ok );
+				return false;
+			}
+			have = 0;
+			continue;
+		}
+
+		// A token is complete once a delimiter follows it, the producer closed the stream,
+		// or it fills the whole ring and can never be terminated
+		const size_t tokenEnd = ss_ring_find( stream, start, end, true );
+		if( tokenEnd < end || more == false || end - start == stream->alloc_size )
+		{
+			if( ss_ring_copy( stream, start, tokenEnd, &out ) == false )
+			{
+				return false;
+			}
+			ss_spsc_consume( stream, tokenEnd );
+
+			if( output->at_get != nullptr )
+			{
+				cs_destroy_cstring( output );
+			}
+			*output = out;
+			return true;
+		}
+
+		have = end - start;
+	}
+}
+bool ss_spsc_getline( stringstream this, cstring* output, const line_terminator term )
+{
+	_sstream* stream = this.stream;
+	cstring out = { 0 };
+	size_t have = 0;
+
+	if( output == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	for( ;; )
+	{
+		size_t available = 0;
+		const bool more = ss_spsc_poll( stream, have, &available );
+		if( more == false && err_get_result() != Result_Ok )
+		{
+			return false;
+		}
+
+		const size_t begin = stream->spsc->readPos;
+		const size_t end = begin + available;
+		size_t lineEnd = end, next = end;
+		bool found = false;
+
+		// The crlf check looks one byte back so rescanning the last byte seen is enough
+		for( size_t pos = begin + ( have > 0 ? have - 1 : 0 ); pos < end && found == false; )
+		{
+			const size_t at = ss_ring_find_byte( stream, pos, end, term.delim );
+			if( at == end )
+			{
+				break;
+			}
+			if( term.crlf == false )
+			{
+				lineEnd = at;
+				found = true;
+			}
+			else if( at > begin && stream->buffer[ ( at - 1 ) & ( stream->alloc_size - 1 ) ] == '\r' )
+			{
+				lineEnd = at - 1;
+				found = true;
+			}
+			next = at + 1;
+			pos = at + 1;
+		}
+
+		if( found == false && more == true && available < stream->alloc_size )
+		{
+			have = available;
+			continue;
+		}
+		if( found == false )
+		{
+			lineEnd = end;
+			next = end;
+		}
+
+		const bool exhausted = ( available == 0 );
+		if( exhausted ? cs_default_construct( &out ) == false : ss_ring_copy( stream, begin, lineEnd, &out ) == false )
+		{
+			return false;
+		}
+		ss_spsc_consume( stream, next );
+
+		if( output->at_get != nullptr )
+		{
+			cs_destroy_cstring( output );
+		}
+		*output = out;
+
+		if( exhausted )
+		{
+			err_set_result( Result_Ok );
+		}
+		return exhausted == false;
+	}
+}
+bool ss_spsc_eof( const stringstream this )
+{
+	ss_spsc* spsc = this.stream->spsc;
+	if( sync_load_u32( &spsc->closed ) == 0 )
+	{
+		return false;
+	}
+
+	return spsc->readPos == sync_load_acquire( &spsc->writePos );
+}
+size_t ss_spsc_tellg( stringstream this )
+{
+	return this.stream->spsc->readPos;
+}
+size_t ss_spsc_tellp( stringstream this )
+{
+	return this.stream->spsc->writePos;
+}
+bool ss_spsc_get_stats( const stringstream this, ss_stats* stats )
+{
+	if( stats == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	ss_spsc* spsc = this.stream->spsc;
+	const size_t readPos = sync_load_acquire( &spsc->readPos );
+	const size_t writePos = sync_load_acquire( &spsc->writePos );
+
+	// A snapshot, either side may move while it is taken
+	stats->occupancy = writePos > readPos ? writePos - readPos : 0;
+	stats->retained = stats->occupancy;
+	stats->capacity = this.stream->alloc_size;
+	stats->high_water = sync_load_acquire( &spsc->highWater );
+	stats->reclaimed = readPos;
+
+	return true;
+}
+bool ss_spsc_seek( stringstream this, int offset, seekpos position )
+{
+	( void )this;
+	( void )offset;
+	( void )position;
+	err_set_result( Result_Invalid_Parameter );
+	return false;
+}
+bool ss_spsc_string( stringstream this, cstring* output )
+{
+	( void )this;
+	( void )output;
+	err_set_result( Result_Invalid_Parameter );
+	return false;
+}
+bool ss_spsc_next_line( stringstream this, string_slice* line, const line_terminator term )
+{
+	( void )this;
+	( void )line;
+	( void )term;
+	// A slice would point at bytes the producer is free to overwrite
+	err_set_result( Result_Invalid_Parameter );
+	return false;
+}
+size_t ss_spsc_count_tokens( const stringstream this )
+{
+	( void )this;
+	err_set_result( Result_Invalid_Parameter );
+	return 0;
+}
+bool ss_spsc_poll( _sstream* stream, const size_t have, size_t* available )
+{
+	ss_spsc* spsc = stream->spsc;
+
+	for( ;; )
+	{
+		if( spsc->cachedWrite - spsc->readPos > have )
+		{
+			*available = spsc->cachedWrite - spsc->readPos;
+			return true;
+		}
+
+		spsc->cachedWrite = sync_load_acquire( &spsc->writePos );
+		if( spsc->cachedWrite - spsc->readPos > have )
+		{
+			continue;
+		}
+
+		if( sync_load_u32( &spsc->closed ) != 0 )
+		{
+			// The producer may have written right before closing
+			spsc->cachedWrite = sync_load_acquire( &spsc->writePos );
+			*available = spsc->cachedWrite - spsc->readPos;
+			if( *available > have )
+			{
+				return true;
+			}
+			err_set_result( Result_Ok );
+			return false;
+		}
+		if( spsc->blocking == false )
+		{
+			*available = spsc->cachedWrite - spsc->readPos;
+			err_set_result( Result_Would_Block );
+			return false;
+		}
+
+		ss_spsc_wait( &spsc->dataSeq, &spsc->readerWaiting, &spsc->writePos, spsc->cachedWrite, &spsc->closed );
+	}
+}
+void ss_spsc_consume( _sstream* stream, const size_t pos )
+{
+	sync_store_release( &stream->spsc->readPos, pos );
+	ss_spsc_notify( &stream->spsc->spaceSeq, &stream->spsc->writerWaiting );
+}
+void ss_spsc_wait( volatile uint32_t* seq, volatile uint32_t* waiting, const volatile size_t* pos, const size_t seen, const volatile uint32_t* closed )
+{
+	// The fence pairs with the one in ss_spsc_notify, either this side sees the new position
+	// or the other side sees the waiting flag and bumps seq
+	const uint32_t snapshot = sync_load_u32( seq );
+	sync_store_u32( waiting, 1 );
+	sync_fence();
+
+	if( sync_load_acquire( pos ) == seen && ( closed == nullptr || sync_load_u32( closed ) == 0 ) )
+	{
+		sync_wait( seq, snapshot );
+	}
+
+	sync_store_u32( waiting, 0 );
+}
+void ss_spsc_notify( volatile uint32_t* seq, const volatile uint32_t* waiting )
+{
+	sync_fence();
+	if( sync_load_u32( waiting ) != 0 )
+	{
+		sync_fetch_add_u32( seq, 1 );
+		sync_wake_all( seq );
+	}
+}
+size_t ss_ring_find( const _sstream* stream, size_t from, const size_t to, const bool delimiter )
+{
+	const size_t capacity = stream->alloc_size;
+
+	while( from < to )
+	{
+		const size_t phys = from & ( capacity - 1 );
+		const size_t length = to - from < capacity - phys ? to - from : capacity - phys;
+
+		for( size_t offset = 0; offset < length; offset += TOK_BLOCK_SIZE )
+		{
+			const uint64_t delims = tok_mask( &stream->delims, &stream->buffer[ phys + offset ], length - offset );
+			const uint64_t hits = delimiter ? delims : ~delims;
+			if( hits != 0 )
+			{
+				// Bits past the segment report delimiters, those are not hits
+				const size_t at = offset + bit_ctz64( hits );
+				if( at < length )
+				{
+					return from + at;
+				}
+				break;
+			}
+		}
+
+		from += length;
+	}
+
+	return to;
+}
+size_t ss_ring_find_byte( const _sstream* stream, size_t from, const size_t to, const char c )
+{
+	const size_t capacity = stream->alloc_size;
+
+	while( from < to )
+	{
+		const size_t phys = from & ( capacity - 1 );
+		const size_t length = to - from < capacity - phys ? to - from : capacity - phys;
+
+		const char* found = ( const char* )memchr( &stream->buffer[ phys ], c, length );
+		if( found != nullptr )
+		{
+			return from + ( size_t )( found - &stream->buffer[ phys ] );
+		}
+
+		from += length;
+	}
+
+	return to;
+}
+bool ss_ring_copy( const _sstream* stream, const size_t from, const size_t to, cstring* output )
+{
+	const size_t capacity = stream->alloc_size;
+	const size_t phys = from & ( capacity - 1 );
+	const size_t length = to - from;
+	const size_t first = length < capacity - phys ? length : capacity - phys;
+
+	if( cs_buffer_construct( output, &stream->buffer[ phys ], first ) == false )
+	{
+		return false;
+	}
+	if( cs_append_buffer( output, stream->buffer, length - first ) == false )
+	{
+		cs_destroy_cstring( output );
+		return false;
+	}
+
+	return true;
 }
@@ -1,8 +1,11 @@
 #pragma once
 
+#include "tokenizer.h"
 #include <ctype.h>
+#include <stdint.h>
 
 typedef struct _sstream _sstream;
+typedef struct ss_spsc ss_spsc;
 typedef struct stringstream stringstream;
 
 typedef enum
@@ -12,6 +15,53 @@ typedef enum
 	SS_SEEK_END = 2
 }seekpos;
 
+// A record ends at delim.  With crlf set it ends at a '\r' directly followed by delim,
+// so { '\n', true } reads "\r\n" terminated lines.
+typedef struct line_terminator
+{
+	char delim;
+	_Bool crlf;
+}line_terminator;
+
+typedef enum
+{
+	SS_MODE_CONTIGUOUS = 0,		// grows on demand, consumed bytes are kept unless compacted
+	SS_MODE_RING = 1,			// fixed capacity, reading frees space for writing
+	SS_MODE_SPSC = 2			// ring shared by one writing and one reading thread
+}ss_mode;
+
+// Compaction policy for contiguous streams, flags can be combined
+typedef enum
+{
+	SS_COMPACT_NEVER = 0,		// keeps every byte so seekg can always rewind
+	SS_COMPACT_ON_GROW = 1,		// moves unread bytes to the front instead of growing when possible
+	SS_COMPACT_ON_DRAIN = 2		// rewinds to the start of the buffer once every byte has been read
+}ss_compaction;
+
+typedef struct ss_stats
+{
+	size_t occupancy;	// bytes held and not yet read
+	size_t retained;	// bytes held, including read bytes kept for seeking
+	size_t capacity;
+	size_t high_water;	// peak of retained
+	size_t reclaimed;	// total bytes released by compaction or ring reads
+}ss_stats;
+
+// Private to stringstream.c, the layout is only visible for the unchecked accessors in fastpath.h.
+// readPos, writePos and str_size are logical positions.  base is the logical position
+// stored at buffer[ 0 ], in ring mode positions wrap around alloc_size which is a power of two.
+struct _sstream
+{
+	size_t readPos, writePos, alloc_size, str_size;
+	char* buffer;
+	delimiter_class delims;
+
+	ss_mode mode;
+	ss_compaction compaction;
+	size_t base, high_water;
+	ss_spsc* spsc;
+};
+
 typedef struct stringstream
 {
 	_Bool(*getchar)( stringstream this, char* pc );
@@ -23,12 +73,63 @@ typedef struct stringstream
 	_Bool( *putchar )( stringstream this, const char c );
 	_Bool( *insert )( stringstream this, const char* str );
 	_Bool( *insert_cstring )( stringstream this, const cstring str );
+	// length bytes of data, which may contain zeros and needs no terminator
+	_Bool( *write )( stringstream this, const char* data, const size_t length );
 	_Bool( *eof )( const stringstream this );
 	_Bool(*seekg)( stringstream this, int offset, seekpos position );
 	_Bool(*seekp)( stringstream this, int offset, seekpos position );
 
+	// tokenizer
+	_Bool( *set_delimiters )( stringstream this, const char* delimiters );
+	size_t( *count_tokens )( const stringstream this );
+
+	// records
+	_Bool( *getline )( stringstream this, cstring* output, const line_terminator term );
+	// The slice points into the stream buffer, valid until the next read or write call on the stream
+	_Bool( *next_line )( stringstream this, string_slice* line, const line_terminator term );
+
+	// typed values, see ss_read_int64
+	_Bool( *read_int64 )( stringstream this, int64_t* value );
+	_Bool( *read_uint64 )( stringstream this, uint64_t* value );
+	_Bool( *read_double )( stringstream this, double* value );
+	_Bool( *read_bool )( stringstream this, _Bool* value );
+	_Bool( *write_int64 )( stringstream this, const int64_t value );
+	_Bool( *write_uint64 )( stringstream this, const uint64_t value );
+	_Bool( *write_double )( stringstream this, const double value );
+	_Bool( *write_bool )( stringstream this, const _Bool value );
+
+	// buffer management
+	_Bool( *set_compaction )( stringstream this, const ss_compaction policy );
+	_Bool( *stats )( const stringstream this, ss_stats* stats );
+	// Heap bytes owned by this stream, bookkeeping included
+	size_t( *memory_usage )( const stringstream this );
+
 	_sstream* stream;
 }stringstream;
 
 _Bool ss_construct( stringstream* this );
+_Bool ss_ring_construct( stringstream* this, const size_t capacity );
+
+// Single producer, single consumer stream.  One thread may call putchar, insert and insert_cstring
+// while another calls getchar, extract, getline and eof.  Positions are exchanged with acquire/release
+// atomics only, producer calls write the global result code only when they fail.
+// A blocking stream waits for data on reads and for space on writes, otherwise those calls fail
+// with Result_Would_Block or Result_Buffer_Full.  Seeking, string, next_line and count_tokens are not supported.
+_Bool ss_spsc_construct( stringstream* this, const size_t capacity, const _Bool blocking );
+// Typed reads skip delimiters and parse straight out of the buffer.  They return false with Result_Ok
+// once the stream is exhausted, a malformed or out of range value fails with Result_Invalid_Parameter
+// and stays unread together with the delimiters before it.  Booleans are read as true, false, 1 or 0
+// and written as true or false.
+// Typed writes format straight into the buffer without a separator.  SPSC streams support writes only.
+_Bool ss_read_int64( stringstream this, int64_t* value );
+_Bool ss_read_uint64( stringstream this, uint64_t* value );
+_Bool ss_read_double( stringstream this, double* value );
+_Bool ss_read_bool( stringstream this, _Bool* value );
+_Bool ss_write_int64( stringstream this, const int64_t value );
+_Bool ss_write_uint64( stringstream this, const uint64_t value );
+_Bool ss_write_double( stringstream this, const double value );
+_Bool ss_write_bool( stringstream this, const _Bool value );
+
+// Called by the producer when it is done, the consumer sees eof once the remaining bytes are read
+void ss_spsc_close( stringstream this );
 void ss_destroy( stringstream* this );
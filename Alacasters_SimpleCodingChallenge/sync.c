@@ -0,0 +1,70 @@
+#include "sync.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( _WIN32 )
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#pragma comment( lib, "Synchronization.lib" )
+#elif defined( __linux__ )
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <sched.h>
+#endif
+
+void sync_wait( volatile uint32_t* addr, const uint32_t expected )
+{
+#if defined( _WIN32 )
+	uint32_t compare = expected;
+	WaitOnAddress( addr, &compare, sizeof( uint32_t ), INFINITE );
+#elif defined( __linux__ )
+	syscall( SYS_futex, ( uint32_t* )addr, FUTEX_WAIT_PRIVATE, expected, NULL, NULL, 0 );
+#else
+	if( sync_load_u32( addr ) == expected )
+	{
+		sched_yield();
+	}
+#endif
+}
+void sync_wake_all( volatile uint32_t* addr )
+{
+#if defined( _WIN32 )
+	WakeByAddressAll( ( void* )addr );
+#elif defined( __linux__ )
+	syscall( SYS_futex, ( uint32_t* )addr, FUTEX_WAKE_PRIVATE, 0x7fffffff, NULL, NULL, 0 );
+#else
+	( void )addr;
+#endif
+}
+void* sync_calloc_lines( const size_t count, const size_t size )
+{
+	if( size != 0 && count > ( SIZE_MAX - SYNC_CACHE_LINE - sizeof( void* ) ) / size )
+	{
+		return nullptr;
+	}
+
+	// Over-allocate, round up to the next line and keep what malloc returned just below the block
+	const size_t bytes = count * size;
+	char* raw = ( char* )malloc( bytes + SYNC_CACHE_LINE + sizeof( void* ) );
+	if( raw == nullptr )
+	{
+		return nullptr;
+	}
+
+	const uintptr_t start = ( ( uintptr_t )raw + sizeof( void* ) + SYNC_CACHE_LINE - 1 ) & ~( uintptr_t )( SYNC_CACHE_LINE - 1 );
+	char* block = ( char* )start;
+	memcpy( block - sizeof( void* ), &raw, sizeof( void* ) );
+	memset( block, 0, bytes );
+	return block;
+}
+void sync_free_lines( void* block )
+{
+	if( block != nullptr )
+	{
+		void* raw = nullptr;
+		memcpy( &raw, ( char* )block - sizeof( void* ), sizeof( void* ) );
+		free( raw );
+	}
+}
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "defines.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined( _MSC_VER )
+#include <intrin.h>
+#endif
+
+#define SYNC_CACHE_LINE 64
+
+// Storage class for per thread globals
+#if defined( _MSC_VER )
+#define SYNC_THREAD_LOCAL __declspec( thread )
+#elif defined( __STDC_VERSION__ ) && __STDC_VERSION__ >= 201112L && !defined( __STDC_NO_THREADS__ )
+#define SYNC_THREAD_LOCAL _Thread_local
+#else
+#define SYNC_THREAD_LOCAL __thread
+#endif
+
+// Atomic helpers for positions shared between threads.
+// The acquire/release pair orders the bytes behind a position, the u32 helpers are
+// sequentially consistent and used for wait flags and wake sequences.
+
+static __inline size_t sync_load_acquire( const volatile size_t* ptr )
+{
+#if defined( _MSC_VER )
+	// x86 and x64 loads already have acquire semantics, only stop the compiler reordering
+	const size_t value = *ptr;
+	_ReadWriteBarrier();
+	return value;
+#else
+	return __atomic_load_n( ptr, __ATOMIC_ACQUIRE );
+#endif
+}
+static __inline void sync_store_release( volatile size_t* ptr, const size_t value )
+{
+#if defined( _MSC_VER )
+	_ReadWriteBarrier();
+	*ptr = value;
+#else
+	__atomic_store_n( ptr, value, __ATOMIC_RELEASE );
+#endif
+}
+static __inline uint32_t sync_load_u32( const volatile uint32_t* ptr )
+{
+#if defined( _MSC_VER )
+	const uint32_t value = *ptr;
+	_ReadWriteBarrier();
+	return value;
+#else
+	return __atomic_load_n( ptr, __ATOMIC_SEQ_CST );
+#endif
+}
+static __inline void sync_store_u32( volatile uint32_t* ptr, const uint32_t value )
+{
+#if defined( _MSC_VER )
+	_InterlockedExchange( ( volatile long* )ptr, ( long )value );
+#else
+	__atomic_store_n( ptr, value, __ATOMIC_SEQ_CST );
+#endif
+}
+static __inline uint32_t sync_fetch_add_u32( volatile uint32_t* ptr, const uint32_t value )
+{
+#if defined( _MSC_VER )
+	return ( uint32_t )_InterlockedExchangeAdd( ( volatile long* )ptr, ( long )value );
+#else
+	return __atomic_fetch_add( ptr, value, __ATOMIC_SEQ_CST );
+#endif
+}
+static __inline size_t sync_fetch_add_size( volatile size_t* ptr, const size_t value )
+{
+#if defined( _MSC_VER ) && defined( _WIN64 )
+	return ( size_t )_InterlockedExchangeAdd64( ( volatile long long* )ptr, ( long long )value );
+#elif defined( _MSC_VER )
+	return ( size_t )_InterlockedExchangeAdd( ( volatile long* )ptr, ( long )value );
+#else
+	return __atomic_fetch_add( ptr, value, __ATOMIC_SEQ_CST );
+#endif
+}
+static __inline bool sync_compare_exchange_size( volatile size_t* ptr, const size_t expected, const size_t desired )
+{
+#if defined( _MSC_VER ) && defined( _WIN64 )
+	return ( size_t )_InterlockedCompareExchange64( ( volatile long long* )ptr, ( long long )desired, ( long long )expected ) == expected;
+#elif defined( _MSC_VER )
+	return ( size_t )_InterlockedCompareExchange( ( volatile long* )ptr, ( long )desired, ( long )expected ) == expected;
+#else
+	size_t compare = expected;
+	return __atomic_compare_exchange_n( ptr, &compare, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST );
+#endif
+}
+// Stores desired when *ptr == expected, returns whether it did
+static __inline bool sync_compare_exchange_u32( volatile uint32_t* ptr, const uint32_t expected, const uint32_t desired )
+{
+#if defined( _MSC_VER )
+	return ( uint32_t )_InterlockedCompareExchange( ( volatile long* )ptr, ( long )desired, ( long )expected ) == expected;
+#else
+	uint32_t compare = expected;
+	return __atomic_compare_exchange_n( ptr, &compare, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST );
+#endif
+}
+static __inline void sync_fence( void )
+{
+#if defined( _MSC_VER )
+	_ReadWriteBarrier();
+	_mm_mfence();
+#else
+	__atomic_thread_fence( __ATOMIC_SEQ_CST );
+#endif
+}
+
+// Spin loop hint, lets the sibling hyperthread run while waiting on a cache line
+static __inline void sync_pause( void )
+{
+#if defined( _MSC_VER )
+	_mm_pause();
+#elif defined( __x86_64__ ) || defined( __i386__ )
+	__builtin_ia32_pause();
+#endif
+}
+
+// Blocks while *addr == expected.  May return spuriously, callers re-check their condition.
+void sync_wait( volatile uint32_t* addr, const uint32_t expected );
+void sync_wake_all( volatile uint32_t* addr );
+
+// Zero filled count by size bytes that start on a cache line, for per thread slots a multiple of
+// SYNC_CACHE_LINE apart.  malloc only aligns to 16 bytes, which lets every slot straddle two lines.
+// Returns nullptr when out of memory, free the block with sync_free_lines.
+void* sync_calloc_lines( const size_t count, const size_t size );
+void sync_free_lines( void* block );
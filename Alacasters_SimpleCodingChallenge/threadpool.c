@@ -0,0 +1,381 @@
+#include "threadpool.h"
+#include "customerror.h"
+#include "memory.h"
+#include "sync.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( _WIN32 )
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+typedef HANDLE tp_thread;
+#else
+#include <pthread.h>
+#include <unistd.h>
+typedef pthread_t tp_thread;
+#endif
+
+// Chunks a participant still owns, [next, end).  The owner takes from the front, thieves split off the back.
+// Padded to a cache line and allocated line aligned, so neighbouring participants never share one.
+// lock comes last so the compiler has no alignment padding to add that the pad would not account for.
+typedef struct tp_range
+{
+	size_t next, end;
+	volatile uint32_t lock;
+	char pad[ SYNC_CACHE_LINE - 2 * sizeof( size_t ) - sizeof( uint32_t ) ];
+}tp_range;
+_Static_assert( sizeof( tp_range ) % SYNC_CACHE_LINE == 0, "tp_range must fill whole cache lines" );
+
+typedef struct tp_worker
+{
+	_threadpool* pool;
+	size_t index;
+	tp_thread thread;
+}tp_worker;
+
+struct _threadpool
+{
+	size_t threads;
+	tp_worker* workers;
+	tp_range* ranges;
+
+	// Current job, written by run before jobSeq is bumped
+	range_job job;
+	void* user;
+	size_t count, grain;
+
+	volatile uint32_t jobSeq;
+	volatile uint32_t pending;
+	volatile uint32_t shutdown;
+	// Serializes callers of run
+	volatile uint32_t running;
+};
+
+// Private forward declarations
+size_t tp_thread_count( const threadpool* this );
+_Bool tp_run( threadpool* this, const size_t count, const size_t grain, range_job job, void* user );
+
+void tp_lock( volatile uint32_t* lock );
+void tp_unlock( volatile uint32_t* lock );
+bool tp_take( _threadpool* pool, const size_t self, size_t* first, size_t* last );
+bool tp_steal( _threadpool* pool, const size_t self );
+void tp_work( _threadpool* pool, const size_t self );
+void tp_worker_loop( tp_worker* worker );
+bool tp_start_thread( tp_worker* worker );
+void tp_join_thread( tp_worker* worker );
+void tp_stop( _threadpool* pool, const size_t started );
+
+
+// Public definitions
+bool tp_construct( threadpool* this, const size_t threads )
+{
+	_threadpool* pdata = nullptr;
+	bool result = true;
+	ResultCode rescode = Result_Ok;
+
+	if( this == nullptr )
+	{
+		rescode = Result_Null_Parameter;
+		result = false;
+	}
+	if( result )
+	{
+		pdata = ( _threadpool* )malloc( sizeof( _threadpool ) );
+		if( pdata == nullptr )
+		{
+			rescode = Result_Bad_Alloc;
+			result = false;
+		}
+	}
+	if( result )
+	{
+		memset( pdata, 0, sizeof( _threadpool ) );
+		pdata->threads = threads != 0 ? threads : tp_hardware_threads();
+		pdata->workers = ( tp_worker* )malloc( pdata->threads * sizeof( tp_worker ) );
+		pdata->ranges = ( tp_range* )sync_calloc_lines( pdata->threads, sizeof( tp_range ) );
+		if( pdata->workers == nullptr || pdata->ranges == nullptr )
+		{
+			rescode = Result_Bad_Alloc;
+			free( pdata->workers );
+			sync_free_lines( pdata->ranges );
+			SafeDelete( ( void** )&pdata );
+			result = false;
+		}
+	}
+	if( result )
+	{
+		// Worker 0 is whichever thread calls run
+		for( size_t i = 0; i < pdata->threads; ++i )
+		{
+			pdata->workers[ i ].pool = pdata;
+			pdata->workers[ i ].index = i;
+		}
+		for( size_t i = 1; i < pdata->threads; ++i )
+		{
+			if( tp_start_thread( &pdata->workers[ i ] ) == false )
+			{
+				tp_stop( pdata, i );
+				rescode = Result_Bad_Alloc;
+				free( pdata->workers );
+				sync_free_lines( pdata->ranges );
+				SafeDelete( ( void** )&pdata );
+				result = false;
+				break;
+			}
+		}
+	}
+	if( result )
+	{
+		threadpool self = { 0 };
+		self.thread_count = tp_thread_count;
+		self.run = tp_run;
+		self.pdata = pdata;
+
+		*this = self;
+	}
+
+	err_set_result( rescode );
+	return result;
+}
+bool tp_destroy( threadpool* this )
+{
+	if( this == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+	if( this->pdata == nullptr )
+	{
+		err_set_result( Result_Not_Initialized );
+		return false;
+	}
+
+	tp_stop( this->pdata, this->pdata->threads );
+	free( this->pdata->workers );
+	sync_free_lines( this->pdata->ranges );
+	SafeDelete( ( void** )&this->pdata );
+
+	threadpool self = { 0 };
+	*this = self;
+
+	err_set_ok();
+	return true;
+}
+size_t tp_hardware_threads( void )
+{
+#if defined( _WIN32 )
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	const size_t count = ( size_t )info.dwNumberOfProcessors;
+#else
+	const long online = sysconf( _SC_NPROCESSORS_ONLN );
+	const size_t count = online > 0 ? ( size_t )online : 1;
+#endif
+	return count != 0 ? count : 1;
+}
+
+
+// Private definitions
+size_t tp_thread_count( const threadpool* this )
+{
+	return this->pdata->threads;
+}
+_Bool tp_run( threadpool* this, const size_t count, const size_t grain, range_job job, void* user )
+{
+	if( this == nullptr || job == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	_threadpool* pool = this->pdata;
+	const size_t step = grain != 0 ? grain : 1;
+	if( count == 0 )
+	{
+		err_set_ok();
+		return true;
+	}
+	if( count <= step || pool->threads == 1 )
+	{
+		job( 0, count, 0, user );
+		err_set_ok();
+		return true;
+	}
+
+	while( sync_compare_exchange_u32( &pool->running, 0, 1 ) == false )
+	{
+		sync_wait( &pool->running, 1 );
+	}
+
+	// Equal contiguous shares of chunks, stealing evens out whatever runs unevenly
+	const size_t chunks = ( count + step - 1 ) / step;
+	for( size_t i = 0; i < pool->threads; ++i )
+	{
+		pool->ranges[ i ].next = chunks * i / pool->threads;
+		pool->ranges[ i ].end = chunks * ( i + 1 ) / pool->threads;
+	}
+	pool->job = job;
+	pool->user = user;
+	pool->count = count;
+	pool->grain = step;
+
+	sync_store_u32( &pool->pending, ( uint32_t )( pool->threads - 1 ) );
+	sync_fetch_add_u32( &pool->jobSeq, 1 );
+	sync_wake_all( &pool->jobSeq );
+
+	tp_work( pool, 0 );
+
+	for( uint32_t left = sync_load_u32( &pool->pending ); left != 0; left = sync_load_u32( &pool->pending ) )
+	{
+		sync_wait( &pool->pending, left );
+	}
+
+	sync_store_u32( &pool->running, 0 );
+	sync_wake_all( &pool->running );
+
+	err_set_ok();
+	return true;
+}
+void tp_lock( volatile uint32_t* lock )
+{
+	while( sync_compare_exchange_u32( lock, 0, 1 ) == false )
+	{
+		while( sync_load_u32( lock ) != 0 )
+		{
+			sync_pause();
+		}
+	}
+}
+void tp_unlock( volatile uint32_t* lock )
+{
+	sync_store_u32( lock, 0 );
+}
+bool tp_take( _threadpool* pool, const size_t self, size_t* first, size_t* last )
+{
+	tp_range* range = &pool->ranges[ self ];
+	bool taken = false;
+
+	tp_lock( &range->lock );
+	if( range->next < range->end )
+	{
+		const size_t chunk = range->next++;
+		*first = chunk * pool->grain;
+		*last = *first + pool->grain < pool->count ? *first + pool->grain : pool->count;
+		taken = true;
+	}
+	tp_unlock( &range->lock );
+
+	return taken;
+}
+bool tp_steal( _threadpool* pool, const size_t self )
+{
+	// Visit the others starting after self so thieves spread over different victims
+	for( size_t i = 1; i < pool->threads; ++i )
+	{
+		tp_range* victim = &pool->ranges[ ( self + i ) % pool->threads ];
+
+		tp_lock( &victim->lock );
+		const size_t remaining = victim->end - victim->next;
+		const size_t stolen = remaining > 1 ? remaining / 2 : remaining;
+		const size_t end = victim->end;
+		victim->end -= stolen;
+		tp_unlock( &victim->lock );
+
+		if( stolen != 0 )
+		{
+			tp_range* own = &pool->ranges[ self ];
+			tp_lock( &own->lock );
+			own->next = end - stolen;
+			own->end = end;
+			tp_unlock( &own->lock );
+			return true;
+		}
+	}
+	return false;
+}
+void tp_work( _threadpool* pool, const size_t self )
+{
+	size_t first = 0, last = 0;
+	for( ;; )
+	{
+		if( tp_take( pool, self, &first, &last ) )
+		{
+			pool->job( first, last, self, pool->user );
+		}
+		else if( tp_steal( pool, self ) == false )
+		{
+			break;
+		}
+	}
+}
+void tp_worker_loop( tp_worker* worker )
+{
+	_threadpool* pool = worker->pool;
+	uint32_t seen = 0;
+
+	for( ;; )
+	{
+		uint32_t seq = sync_load_u32( &pool->jobSeq );
+		while( seq == seen )
+		{
+			sync_wait( &pool->jobSeq, seen );
+			seq = sync_load_u32( &pool->jobSeq );
+		}
+		seen = seq;
+
+		if( sync_load_u32( &pool->shutdown ) != 0 )
+		{
+			break;
+		}
+
+		tp_work( pool, worker->index );
+		if( sync_fetch_add_u32( &pool->pending, ( uint32_t )-1 ) == 1 )
+		{
+			sync_wake_all( &pool->pending );
+		}
+	}
+}
+#if defined( _WIN32 )
+DWORD WINAPI tp_thread_main( LPVOID param )
+{
+	tp_worker_loop( ( tp_worker* )param );
+	return 0;
+}
+bool tp_start_thread( tp_worker* worker )
+{
+	worker->thread = CreateThread( NULL, 0, tp_thread_main, worker, 0, NULL );
+	return worker->thread != NULL;
+}
+void tp_join_thread( tp_worker* worker )
+{
+	WaitForSingleObject( worker->thread, INFINITE );
+	CloseHandle( worker->thread );
+}
+#else
+void* tp_thread_main( void* param )
+{
+	tp_worker_loop( ( tp_worker* )param );
+	return NULL;
+}
+bool tp_start_thread( tp_worker* worker )
+{
+	return pthread_create( &worker->thread, NULL, tp_thread_main, worker ) == 0;
+}
+void tp_join_thread( tp_worker* worker )
+{
+	pthread_join( worker->thread, NULL );
+}
+#endif
+void tp_stop( _threadpool* pool, const size_t started )
+{
+	// Workers [1, started) are running, wake them with shutdown set and wait for them to exit
+	sync_store_u32( &pool->shutdown, 1 );
+	sync_fetch_add_u32( &pool->jobSeq, 1 );
+	sync_wake_all( &pool->jobSeq );
+
+	for( size_t i = 1; i < started; ++i )
+	{
+		tp_join_thread( &pool->workers[ i ] );
+	}
+}
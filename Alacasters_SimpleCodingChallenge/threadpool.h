@@ -0,0 +1,33 @@
+#pragma once
+
+#include "defines.h"
+#include <stddef.h>
+
+// Fixed set of worker threads that run index range jobs.  run splits [0, count) into chunks of
+// grain indices, hands every participant a contiguous share of chunks and lets a participant
+// that runs dry steal half of the chunks another one has left.  The calling thread takes part as worker 0
+// and run returns once every index has been processed.
+//
+// Small jobs, count <= grain or a pool with one thread, run inline on the calling thread.
+// Jobs must not call run on the pool that is running them.
+typedef struct _threadpool _threadpool;
+typedef struct threadpool threadpool;
+
+// Processes indices [first, last), worker is below thread_count and no two calls share it at the same time
+typedef void( *range_job )( const size_t first, const size_t last, const size_t worker, void* user );
+
+struct threadpool
+{
+	// getters
+	size_t( *thread_count )( const threadpool* this );
+
+	// grain of 0 is taken as 1
+	_Bool( *run )( threadpool* this, const size_t count, const size_t grain, range_job job, void* user );
+
+	_threadpool* pdata;
+};
+
+// threads counts the calling thread, 0 uses one per hardware thread
+bool tp_construct( threadpool* this, const size_t threads );
+bool tp_destroy( threadpool* this );
+size_t tp_hardware_threads( void );
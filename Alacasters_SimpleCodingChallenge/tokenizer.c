@@ -0,0 +1,285 @@
+#include "tokenizer.h"
+#include "bitops.h"
+#include "customerror.h"
+#include <string.h>
+
+#if defined( CSAPI_HAVE_AVX2 )
+#include <immintrin.h>
+#elif defined( CSAPI_HAVE_SSE2 )
+#include <emmintrin.h>
+#endif
+
+static const char* const g_whitespace = " \t\n\v\f\r";
+
+// Private forward declarations
+uint64_t tok_mask_scalar( const delimiter_class* this, const char* data, const size_t length );
+uint64_t tok_mask_block( const delimiter_class* this, const char* data );
+
+
+// Public definitions
+_Bool dc_construct( delimiter_class* this, const char* delimiters )
+{
+	if( this == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+	if( delimiters == nullptr || delimiters[ 0 ] == '\0' )
+	{
+		dc_whitespace( this );
+		err_set_ok();
+		return true;
+	}
+
+	memset( this, 0, sizeof( delimiter_class ) );
+	for( const char* iter = delimiters; *iter != '\0'; ++iter )
+	{
+		const unsigned char c = ( unsigned char )*iter;
+		if( this->table[ c ] == 0 )
+		{
+			this->table[ c ] = 1;
+			if( this->count < DC_MAX_SIMD_BYTES )
+			{
+				this->bytes[ this->count ] = *iter;
+			}
+			++this->count;
+		}
+	}
+
+	err_set_ok();
+	return true;
+}
+void dc_whitespace( delimiter_class* this )
+{
+	memset( this, 0, sizeof( delimiter_class ) );
+	for( const char* iter = g_whitespace; *iter != '\0'; ++iter )
+	{
+		this->table[ ( unsigned char )*iter ] = 1;
+		this->bytes[ this->count++ ] = *iter;
+	}
+	this->isWhitespace = true;
+}
+_Bool dc_is_delimiter( const delimiter_class* this, const char c )
+{
+	return this->table[ ( unsigned char )c ] != 0;
+}
+
+uint64_t tok_mask( const delimiter_class* this, const char* data, const size_t length )
+{
+	if( length < TOK_BLOCK_SIZE )
+	{
+		return tok_mask_scalar( this, data, length );
+	}
+
+	return tok_mask_block( this, data );
+}
+size_t tok_count( const delimiter_class* this, const char* data, const size_t length )
+{
+	size_t count = 0;
+
+	// carry holds whether the byte before the current block was a delimiter,
+	// the start of the buffer counts as one
+	uint64_t carry = 1;
+	for( size_t pos = 0; pos < length; pos += TOK_BLOCK_SIZE )
+	{
+		const uint64_t delims = tok_mask( this, data + pos, length - pos );
+		const uint64_t starts = ~delims & ( ( delims << 1 ) | carry );
+
+		count += bit_popcount64( starts );
+		carry = delims >> 63;
+	}
+
+	return count;
+}
+_Bool tok_next( const delimiter_class* this, const char* data, const size_t length, size_t* pos, token_span* span )
+{
+	size_t cur = *pos;
+
+	// Skip leading delimiters
+	while( cur < length )
+	{
+		const uint64_t tokens = ~tok_mask( this, data + cur, length - cur );
+		if( tokens != 0 )
+		{
+			cur += bit_ctz64( tokens );
+			break;
+		}
+		cur += TOK_BLOCK_SIZE;
+	}
+	if( cur >= length )
+	{
+		*pos = length;
+		return false;
+	}
+
+	// Bits past the end of data are reported as delimiters so this always terminates
+	size_t end = cur;
+	for( ;; )
+	{
+		const uint64_t delims = tok_mask( this, data + end, length - end );
+		if( delims != 0 )
+		{
+			end += bit_ctz64( delims );
+			break;
+		}
+		end += TOK_BLOCK_SIZE;
+	}
+
+	span->offset = cur;
+	span->length = end - cur;
+	*pos = end;
+
+	return true;
+}
+size_t tok_for_each( const delimiter_class* this, const char* data, const size_t length, token_visitor visitor, void* user )
+{
+	size_t found = 0;
+	size_t start = 0;
+	uint64_t carry = 1;
+
+	for( size_t pos = 0; pos < length; pos += TOK_BLOCK_SIZE )
+	{
+		const uint64_t delims = tok_mask( this, data + pos, length - pos );
+
+		// A bit flips between this byte and the previous one at every token start and end
+		uint64_t events = delims ^ ( ( delims << 1 ) | carry );
+		while( events != 0 )
+		{
+			const unsigned bit = bit_ctz64( events );
+			if( ( ( delims >> bit ) & 1 ) == 0 )
+			{
+				start = pos + bit;
+			}
+			else
+			{
+				const token_span span = { start, pos + bit - start };
+				++found;
+				if( visitor != nullptr && visitor( span, user ) == false )
+				{
+					return found;
+				}
+			}
+			events = bit_clear_lowest( events );
+		}
+
+		carry = delims >> 63;
+	}
+
+	// Only reachable when the last token runs to the end of a full block
+	if( carry == 0 && length > 0 )
+	{
+		const token_span span = { start, length - start };
+		++found;
+		if( visitor != nullptr )
+		{
+			visitor( span, user );
+		}
+	}
+
+	return found;
+}
+
+
+// Private definitions
+uint64_t tok_mask_scalar( const delimiter_class* this, const char* data, const size_t length )
+{
+	uint64_t mask = ( length < TOK_BLOCK_SIZE ) ? ~0ull << length : 0;
+	const size_t count = ( length < TOK_BLOCK_SIZE ) ? length : TOK_BLOCK_SIZE;
+
+	for( size_t i = 0; i < count; ++i )
+	{
+		mask |= ( uint64_t )this->table[ ( unsigned char )data[ i ] ] << i;
+	}
+
+	return mask;
+}
+
+#if defined( CSAPI_HAVE_AVX2 )
+uint64_t tok_mask_block( const delimiter_class* this, const char* data )
+{
+	const __m256i lo = _mm256_loadu_si256( ( const __m256i* )data );
+	const __m256i hi = _mm256_loadu_si256( ( const __m256i* )( data + 32 ) );
+	__m256i mlo, mhi;
+
+	if( this->isWhitespace )
+	{
+		// ' ' or '\t'..'\r'
+		const __m256i space = _mm256_set1_epi8( ' ' );
+		const __m256i tab = _mm256_set1_epi8( '\t' );
+		const __m256i range = _mm256_set1_epi8( '\r' - '\t' );
+		const __m256i tlo = _mm256_sub_epi8( lo, tab );
+		const __m256i thi = _mm256_sub_epi8( hi, tab );
+		mlo = _mm256_or_si256( _mm256_cmpeq_epi8( lo, space ), _mm256_cmpeq_epi8( _mm256_min_epu8( tlo, range ), tlo ) );
+		mhi = _mm256_or_si256( _mm256_cmpeq_epi8( hi, space ), _mm256_cmpeq_epi8( _mm256_min_epu8( thi, range ), thi ) );
+	}
+	else if( this->count <= DC_MAX_SIMD_BYTES )
+	{
+		mlo = _mm256_setzero_si256();
+		mhi = _mm256_setzero_si256();
+		for( size_t i = 0; i < this->count; ++i )
+		{
+			const __m256i d = _mm256_set1_epi8( this->bytes[ i ] );
+			mlo = _mm256_or_si256( mlo, _mm256_cmpeq_epi8( lo, d ) );
+			mhi = _mm256_or_si256( mhi, _mm256_cmpeq_epi8( hi, d ) );
+		}
+	}
+	else
+	{
+		return tok_mask_scalar( this, data, TOK_BLOCK_SIZE );
+	}
+
+	return ( uint64_t )( uint32_t )_mm256_movemask_epi8( mlo ) |
+		( ( uint64_t )( uint32_t )_mm256_movemask_epi8( mhi ) << 32 );
+}
+#elif defined( CSAPI_HAVE_SSE2 )
+uint64_t tok_mask_block( const delimiter_class* this, const char* data )
+{
+	__m128i in[ 4 ], m[ 4 ];
+	for( size_t j = 0; j < 4; ++j )
+	{
+		in[ j ] = _mm_loadu_si128( ( const __m128i* )( data + j * 16 ) );
+	}
+
+	if( this->isWhitespace )
+	{
+		// ' ' or '\t'..'\r'
+		const __m128i space = _mm_set1_epi8( ' ' );
+		const __m128i tab = _mm_set1_epi8( '\t' );
+		const __m128i range = _mm_set1_epi8( '\r' - '\t' );
+		for( size_t j = 0; j < 4; ++j )
+		{
+			const __m128i t = _mm_sub_epi8( in[ j ], tab );
+			m[ j ] = _mm_or_si128( _mm_cmpeq_epi8( in[ j ], space ), _mm_cmpeq_epi8( _mm_min_epu8( t, range ), t ) );
+		}
+	}
+	else if( this->count <= DC_MAX_SIMD_BYTES )
+	{
+		for( size_t j = 0; j < 4; ++j )
+		{
+			m[ j ] = _mm_setzero_si128();
+		}
+		for( size_t i = 0; i < this->count; ++i )
+		{
+			const __m128i d = _mm_set1_epi8( this->bytes[ i ] );
+			for( size_t j = 0; j < 4; ++j )
+			{
+				m[ j ] = _mm_or_si128( m[ j ], _mm_cmpeq_epi8( in[ j ], d ) );
+			}
+		}
+	}
+	else
+	{
+		return tok_mask_scalar( this, data, TOK_BLOCK_SIZE );
+	}
+
+	return ( uint64_t )( uint16_t )_mm_movemask_epi8( m[ 0 ] ) |
+		( ( uint64_t )( uint16_t )_mm_movemask_epi8( m[ 1 ] ) << 16 ) |
+		( ( uint64_t )( uint16_t )_mm_movemask_epi8( m[ 2 ] ) << 32 ) |
+		( ( uint64_t )( uint16_t )_mm_movemask_epi8( m[ 3 ] ) << 48 );
+}
+#else
+uint64_t tok_mask_block( const delimiter_class* this, const char* data )
+{
+	return tok_mask_scalar( this, data, TOK_BLOCK_SIZE );
+}
+#endif
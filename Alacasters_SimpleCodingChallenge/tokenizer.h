@@ -0,0 +1,38 @@
+#pragma once
+
+#include "defines.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#define DC_MAX_SIMD_BYTES 16
+#define TOK_BLOCK_SIZE 64
+
+// Set of bytes that separate tokens.  Classes with up to DC_MAX_SIMD_BYTES members
+// are matched with vector compares, larger classes fall back to the lookup table.
+typedef struct delimiter_class
+{
+	unsigned char table[ 256 ];
+	char bytes[ DC_MAX_SIMD_BYTES ];
+	size_t count;
+	_Bool isWhitespace;
+}delimiter_class;
+
+typedef struct token_span
+{
+	size_t offset, length;
+}token_span;
+
+// Return false to stop the scan early
+typedef _Bool( *token_visitor )( token_span span, void* user );
+
+// A null or empty delimiters string selects the default whitespace class (isspace in the "C" locale)
+_Bool dc_construct( delimiter_class* this, const char* delimiters );
+void dc_whitespace( delimiter_class* this );
+_Bool dc_is_delimiter( const delimiter_class* this, const char c );
+
+// Bit i is set when data[ i ] is a delimiter.  Bits at or past length are set as well.
+uint64_t tok_mask( const delimiter_class* this, const char* data, const size_t length );
+
+size_t tok_count( const delimiter_class* this, const char* data, const size_t length );
+_Bool tok_next( const delimiter_class* this, const char* data, const size_t length, size_t* pos, token_span* span );
+size_t tok_for_each( const delimiter_class* this, const char* data, const size_t length, token_visitor visitor, void* user );
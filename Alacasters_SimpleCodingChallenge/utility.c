@@ -1,22 +1,53 @@
 #include "utility.h"
+#include "bitops.h"
+#include "cstring.h"
 #include "memory.h"
+#include "profile.h"
 #include <string.h>
 #include <stdlib.h>
 
-struct _container
+#if defined( CSAPI_HAVE_SSE2 )
+#include <emmintrin.h>
+#endif
+
+// Inline storage starts on a 16 byte boundary after _container
+#define CONT_INLINE_OFFSET ( ( sizeof( _container ) + 15 ) & ~( size_t )15 )
+#define CONT_DEFAULT_INLINE 3
+
+#define HM_GROUP_WIDTH 16
+#define HM_MIN_CAPACITY 16
+#define HM_CTRL_EMPTY ( ( signed char )-128 )
+#define HM_CTRL_DELETED ( ( signed char )-2 )
+
+typedef struct hm_slot
+{
+	uint64_t hash;
+	char* key;
+	size_t length;
+}hm_slot;
+
+// ctrl has HM_GROUP_WIDTH extra bytes mirroring the first group so a group load never wraps.
+// A control byte is HM_CTRL_EMPTY, HM_CTRL_DELETED or the low 7 bits of a full slot's hash.
+// ctrl, slots and values share one allocation.
+struct _hashmap
 {
-	char* pBuffer;
-	size_t capacity, size, elemSize;
+	signed char* ctrl;
+	hm_slot* slots;
+	char* values;
+	size_t capacity, size, growthLeft, valueSize;
+	// Bytes held by key copies, for memory_usage
+	size_t keyBytes;
 	default_construct constructor;
 	deep_copy_fn copy_construct;
 	destroy destructor;
+	bool trivialCopy, trivialDestroy;
 };
 
 // Forward declarations for iterator
 iterator it_construct( const container *cont, void* addr );
 iterator it_advance( iterator this );
 iterator it_previous( iterator this );
-iterator it_move_by( iterator this, int offset );
+iterator it_move_by( iterator this, ptrdiff_t offset );
 
 bool it_is_equal( iterator this, iterator other );
 ptrdiff_t it_distance( iterator this, iterator other );
@@ -35,24 +66,76 @@ _Bool cont_empty( const container* this );
 size_t cont_size( const container* this );
 size_t cont_capacity( const container* this );
 const void* cont_data( const container* this );
+size_t cont_memory_usage( const container* this );
 
 // utilities
 _Bool cont_copy( const container* this, container* other );
-size_t cont_elem_size( const container* this );
 size_t cont_calc_addr( const container* this, const size_t idx );
+char* cont_inline_storage( _container* pdata );
+bool cont_is_inline( _container* pdata );
 void* cont_get_element( const container* this, const size_t idx );
+bool cont_construct_range( container* this, const size_t first, const size_t last );
+bool cont_copy_range( const container* this, const char* src, char* dst, const size_t count );
+void cont_destroy_range( container* this, const size_t first, const size_t last );
+void cont_relocate_range( const container* this, char* src, char* dst, const size_t count );
+bool cont_assign( container* this, char* elem, const void* value );
+bool cont_grow_for( container* this, const size_t count );
+// Moves the elements to storage for size elements, size is above the capacity
+bool cont_reallocate( container* this, const size_t size );
 
 // container properties
 void cont_clear( container* this );
 void cont_pop_back( container* this );
 _Bool cont_push_back( container* this, const void* value );
+void* cont_emplace_back( container* this );
+_Bool cont_append_n( container* this, const void* value, const size_t count );
+_Bool cont_append_array( container* this, const void* values, const size_t count );
 _Bool cont_reserve( container* this, const size_t size );
 _Bool cont_resize( container* this, const size_t size );
 
 // setter
 _Bool cont_at_set( container* this, size_t idx, const void* value );
 _Bool cont_insert( container* this, size_t offset, const void* value );
-
+_Bool cont_insert_range( container* this, size_t offset, const void* values, const size_t count );
+
+// removal
+_Bool cont_erase( container* this, size_t offset );
+_Bool cont_erase_range( container* this, size_t first, size_t last );
+size_t cont_erase_if( container* this, element_predicate predicate, void* user );
+_Bool cont_swap_remove( container* this, size_t offset );
+
+
+// Forward declarations for hash map
+void* hm_find( const hashmap* this, const char* key, const size_t length );
+void* hm_find_cstring( const hashmap* this, const struct cstring* key );
+_Bool hm_empty( const hashmap* this );
+size_t hm_size( const hashmap* this );
+size_t hm_capacity( const hashmap* this );
+size_t hm_memory_usage( const hashmap* this );
+_Bool hm_for_each( const hashmap* this, entry_visitor visitor, void* user );
+void hm_clear( hashmap* this );
+_Bool hm_reserve( hashmap* this, const size_t size );
+_Bool hm_rehash( hashmap* this, const size_t buckets );
+_Bool hm_insert( hashmap* this, const char* key, const size_t length, const void* value );
+_Bool hm_insert_cstring( hashmap* this, const struct cstring* key, const void* value );
+void* hm_get_or_insert( hashmap* this, const char* key, const size_t length );
+_Bool hm_erase( hashmap* this, const char* key, const size_t length );
+_Bool hm_erase_cstring( hashmap* this, const struct cstring* key );
+
+uint64_t hm_hash( const char* key, const size_t length );
+uint32_t hm_match( const signed char* group, const signed char h2 );
+uint32_t hm_match_empty( const signed char* group );
+uint32_t hm_match_free( const signed char* group );
+bool hm_lookup( const _hashmap* map, const char* key, const size_t length, const uint64_t hash, size_t* index );
+size_t hm_find_free( const _hashmap* map, const uint64_t hash );
+void hm_set_ctrl( _hashmap* map, const size_t idx, const signed char value );
+char* hm_value( const _hashmap* map, const size_t idx );
+size_t hm_capacity_for( const size_t size );
+size_t hm_table_bytes( const size_t capacity, const size_t valueSize, size_t* ctrlBytes );
+void hm_free_key( _hashmap* map, const size_t idx );
+bool hm_resize( _hashmap* map, const size_t capacity );
+bool hm_prepare_insert( _hashmap* map, const char* key, const size_t length, size_t* index, bool* inserted );
+void hm_remove_slot( _hashmap* map, const size_t idx );
 
 
 // Private defintions for iterator
@@ -73,7 +156,7 @@ iterator it_construct( const container *cont, void* addr )
 }
 iterator it_advance( iterator this )
 {
-	if( this.cur != this.cont->end( this.cont ).cur )
+	if( this.cur != ( char* )cont_ptr_end( this.cont ) )
 	{
 		this.cur += cont_elem_size( this.cont );
 	}
@@ -81,20 +164,22 @@ iterator it_advance( iterator this )
 }
 iterator it_previous( iterator this )
 {
-	if( this.cur != this.cont->begin( this.cont ).cur )
+	if( this.cur != ( char* )cont_ptr_begin( this.cont ) )
 	{
 		this.cur -= cont_elem_size( this.cont );
 	}
 	return this;
 }
-iterator it_move_by( iterator this, int offset )
+iterator it_move_by( iterator this, ptrdiff_t offset )
 {
-	const int _offset = ( offset * cont_elem_size( this.cont ) );
+	// Bounds are checked on indices, a pointer outside the buffer is never formed
+	const ptrdiff_t idx = ( this.cur - ( char* )cont_ptr_begin( this.cont ) ) / ( ptrdiff_t )cont_elem_size( this.cont );
+	const ptrdiff_t size = ( ptrdiff_t )cont_size( this.cont );
 
-	if( this.cur + _offset >= this.cont->begin( this.cont ).cur &&
-		this.cur + _offset < this.cont->end( this.cont ).cur )
+	if( ( offset >= 0 && offset <= size - idx ) ||
+		( offset < 0 && -offset <= idx ) )
 	{
-		this.cur += _offset;
+		this.cur += offset * ( ptrdiff_t )cont_elem_size( this.cont );
 	}
 	return this;
 }
@@ -105,7 +190,7 @@ bool it_is_equal( iterator this, iterator other )
 }
 ptrdiff_t it_distance( iterator this, iterator other )
 {
-	return ( other.cur - this.cur ) / cont_elem_size( this.cont );
+	return ( other.cur - this.cur ) / ( ptrdiff_t )cont_elem_size( this.cont );
 }
 
 void* it_get( iterator this )
@@ -116,13 +201,58 @@ void it_set( iterator this, const void* value )
 {
 	if( this.cur != this.cont->end( this.cont ).cur )
 	{
-		this.cont->pdata->copy_construct( value, it_get( this ), cont_elem_size( this.cont ) );
+		cont_assign( ( container* )this.cont, this.cur, value );
+	}
+}
+
+
+
+bool trivially_constructable( container_func_params params )
+{
+	if( params.this == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+	if( params.this_size == 0 )
+	{
+		err_set_result( Result_Invalid_Parameter );
+		return false;
 	}
+
+	memset( ( void* )params.this, 0, params.this_size );
+
+	err_set_ok();
+	return true;
 }
+bool trivially_copyable( container_func_params params )
+{
+	if( params.this == nullptr || params.other == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+	if( params.this_size == 0 )
+	{
+		err_set_result( Result_Invalid_Parameter );
+		return false;
+	}
 
+	memcpy( params.other, params.this, params.this_size );
 
+	return true;
+}
+void trivially_destructable( container_func_params params ){}
+void trivially_relocatable( container_func_params params )
+{
+	memcpy( params.other, params.this, params.this_size );
+}
 
-bool cont_default_construct( container* this, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor )
+bool cont_default_construct( container* this, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor, relocate_fn relocate )
+{
+	return cont_inline_construct( this, CONT_DEFAULT_INLINE, elementSize, constructor, copy_construct, destructor, relocate );
+}
+bool cont_inline_construct( container* this, const size_t inlineCount, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor, relocate_fn relocate )
 {
 	_container* pdata = nullptr;
 	bool result = true;
@@ -135,7 +265,8 @@ bool cont_default_construct( container* this, const size_t elementSize, default_
 	}
 	if( result )
 	{
-		pdata = ( _container* )malloc( sizeof( _container ) );
+		// One allocation holds the bookkeeping and the first inlineCount elements
+		pdata = ( _container* )mem_alloc( MEM_CONTAINER, CONT_INLINE_OFFSET + inlineCount * elementSize );
 		if( pdata == nullptr )
 		{
 			rescode = Result_Bad_Alloc;
@@ -144,20 +275,17 @@ bool cont_default_construct( container* this, const size_t elementSize, default_
 	}
 	if( result )
 	{
-		pdata->pBuffer = ( char* )malloc( elementSize * 3 );
-		if( pdata->pBuffer == nullptr )
-		{
-			rescode = Result_Bad_Alloc;
-			SafeDelete( &pdata );
-			result = false;
-		}
-	}
-	if( result )
-	{
-		pdata->constructor = constructor;
-		pdata->destructor = destructor;
-		pdata->copy_construct = copy_construct;
-		pdata->capacity = 3;
+		pdata->pBuffer = inlineCount != 0 ? cont_inline_storage( pdata ) : nullptr;
+		pdata->inlineCapacity = inlineCount;
+		pdata->constructor = constructor != nullptr ? constructor : trivially_constructable;
+		pdata->destructor = destructor != nullptr ? destructor : trivially_destructable;
+		pdata->copy_construct = copy_construct != nullptr ? copy_construct : trivially_copyable;
+		pdata->relocate = relocate != nullptr ? relocate : trivially_relocatable;
+		pdata->trivialConstruct = pdata->constructor == trivially_constructable;
+		pdata->trivialCopy = pdata->copy_construct == trivially_copyable;
+		pdata->trivialDestroy = pdata->destructor == trivially_destructable;
+		pdata->trivialRelocate = pdata->relocate == trivially_relocatable;
+		pdata->capacity = inlineCount;
 		pdata->elemSize = elementSize;
 		pdata->size = 0;
 
@@ -169,13 +297,22 @@ bool cont_default_construct( container* this, const size_t elementSize, default_
 		self.data = cont_data;
 		self.empty = cont_empty;
 		self.insert = cont_insert;
+		self.insert_range = cont_insert_range;
+		self.erase = cont_erase;
+		self.erase_range = cont_erase_range;
+		self.erase_if = cont_erase_if;
+		self.swap_remove = cont_swap_remove;
 		self.pop_back = cont_pop_back;
 		self.push_back = cont_push_back;
+		self.emplace_back = cont_emplace_back;
+		self.append_n = cont_append_n;
+		self.append_array = cont_append_array;
 		self.reserve = cont_reserve;
 		self.resize = cont_resize;
 		self.size = cont_size;
 		self.pdata = pdata;
 		self.capacity = cont_capacity;
+		self.memory_usage = cont_memory_usage;
 		self.begin = cont_begin;
 		self.end = cont_end;
 
@@ -186,50 +323,44 @@ bool cont_default_construct( container* this, const size_t elementSize, default_
 	err_set_result( rescode );
 	return result;
 }
-bool cont_reserve_construct( container* this, const size_t size, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor )
+bool cont_reserve_construct( container* this, const size_t size, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor, relocate_fn relocate )
 {
 	bool result = true;
 	ResultCode rescode = Result_Ok;
-	result = cont_default_construct( this, elementSize, constructor, copy_construct, destructor );
+	result = cont_default_construct( this, elementSize, constructor, copy_construct, destructor, relocate );
 	
 	if( result )
 	{
 		result = cont_reserve( this, size );
+		if( result == false )
+		{
+			rescode = err_get_result();
+			cont_destroy( this );
+		}
 	}
-	if( result == false )
+	else
 	{
-		cont_destroy( this );
 		rescode = err_get_result();
-		result = false;
 	}
 
 	err_set_result( rescode );
-	return true;
+	return result;
 }
-bool cont_size_construct( container* this, const size_t size, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor )
+bool cont_size_construct( container* this, const size_t size, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor, relocate_fn relocate )
 {
 	ResultCode rescode = Result_Ok;
-	bool result = cont_default_construct( this, elementSize, constructor, copy_construct, destructor );
+	bool result = cont_default_construct( this, elementSize, constructor, copy_construct, destructor, relocate );
 	if( result )
 	{
 		result = cont_resize( this, size );
-	}
-	if( result )
-	{
-		iterator it = cont_begin( this );
-		const iterator end = cont_end( this );
-
-		bool constructed = true;
-		for( ; it.is_equal( it, end ) == false && constructed == true; it = it.advance( it ) )
+		if( result == false )
 		{
-			constructed = this->pdata->constructor( it.get( it ), cont_elem_size( this ) );
+			rescode = err_get_result();
+			cont_destroy( this );
 		}
-		result = constructed;
 	}
-
-	if( result == false )
+	else
 	{
-		cont_destroy( this );
 		rescode = err_get_result();
 	}
 
@@ -253,23 +384,63 @@ bool cont_destroy( container* this )
 	this->data = nullptr;
 	this->empty = nullptr;
 	this->insert = nullptr;
+	this->insert_range = nullptr;
+	this->erase = nullptr;
+	this->erase_range = nullptr;
+	this->erase_if = nullptr;
+	this->swap_remove = nullptr;
 	this->pop_back = nullptr;
 	this->push_back = nullptr;
+	this->emplace_back = nullptr;
+	this->append_n = nullptr;
+	this->append_array = nullptr;
 	this->reserve = nullptr;
 	this->resize = nullptr;
 	this->size = nullptr;
 	this->begin = nullptr;
 	this->end = nullptr;
 	this->capacity = nullptr;
+	this->memory_usage = nullptr;
 
-	SafeDelete( &this->pdata->pBuffer );
-	SafeDelete( &this->pdata );
+	if( cont_is_inline( this->pdata ) == false )
+	{
+		mem_free( MEM_CONTAINER, this->pdata->pBuffer );
+	}
+	mem_free( MEM_CONTAINER, this->pdata );
+	this->pdata = nullptr;
 
-	err_set_result( Result_Ok );
+	err_set_ok();
 	return true;
 }
 
 
+void* cont_ptr_begin( const container* this )
+{
+	return this->pdata->pBuffer;
+}
+void* cont_ptr_end( const container* this )
+{
+	return this->pdata->pBuffer + cont_calc_addr( this, cont_size( this ) );
+}
+bool cont_for_each( const container* this, span_visitor visitor, void* user )
+{
+	if( visitor == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	err_set_ok();
+
+	// Storage is a single block, so there is one span
+	if( cont_empty( this ) )
+	{
+		return true;
+	}
+	return visitor( this->pdata->pBuffer, cont_size( this ), cont_elem_size( this ), user );
+}
+
+
 // container iterators
 iterator cont_begin( const container* this )
 {
@@ -283,7 +454,7 @@ iterator cont_end( const container* this )
 // getters
 _Bool cont_at_get( const container* this, const size_t idx, void* value )
 {
-	if( idx > cont_size( this ) )
+	if( idx >= cont_size( this ) )
 	{
 		err_set_result( Result_Index_Out_Of_Range );
 		return false;
@@ -295,11 +466,12 @@ _Bool cont_at_get( const container* this, const size_t idx, void* value )
 		return false;
 	}
 
-	iterator it = cont_begin( this );
-	it.move_by( it, idx );
-	this->pdata->copy_construct( it.get( it ), value, cont_elem_size( this ) );
+	if( cont_copy_range( this, cont_get_element( this, idx ), ( char* )value, 1 ) == false )
+	{
+		return false;
+	}
 
-	err_set_result( Result_Ok );
+	err_set_ok();
 	return true;
 }
 _Bool cont_empty( const container* this )
@@ -314,6 +486,12 @@ size_t cont_capacity( const container* this )
 {
 	return this->pdata->capacity;
 }
+size_t cont_memory_usage( const container* this )
+{
+	const _container* pdata = this->pdata;
+	const size_t block = CONT_INLINE_OFFSET + pdata->inlineCapacity * pdata->elemSize;
+	return cont_is_inline( this->pdata ) || pdata->pBuffer == nullptr ? block : block + pdata->capacity * pdata->elemSize;
+}
 const void* cont_data( const container* this )
 {
 	return this->pdata->pBuffer;
@@ -333,30 +511,38 @@ _Bool cont_copy( const container* this, container* other )
 	}
 
 	container out = { 0 };
-	if( cont_size_construct(
+	if( cont_inline_construct(
 		&out,
-		cont_size( this ),
+		this->pdata->inlineCapacity,
 		cont_elem_size( this ),
 		this->pdata->constructor,
 		this->pdata->copy_construct,
-		this->pdata->destructor ) == false )
+		this->pdata->destructor,
+		this->pdata->relocate ) == false )
+	{
+		return false;
+	}
+	if( cont_reserve( &out, cont_size( this ) ) == false )
 	{
+		const ResultCode rescode = err_get_result();
+		cont_destroy( &out );
+		err_set_result( rescode );
 		return false;
 	}
 
-	for( iterator this_it = cont_begin( this ),
-		copy_it = cont_begin( &out ),
-		end_it = cont_end( this );
-		this_it.is_equal( this_it, end_it ) == false;
-		this_it = this_it.advance( this_it ),
-		copy_it = copy_it.advance( copy_it ) )
+	if( cont_copy_range( this, this->pdata->pBuffer, out.pdata->pBuffer, cont_size( this ) ) == false )
 	{
-		copy_it.set( copy_it, this_it.get( this_it ) );
+		const ResultCode rescode = err_get_result();
+		cont_destroy( &out );
+		err_set_result( rescode );
+		return false;
 	}
+	out.pdata->size = cont_size( this );
+	mem_count_copy( MEM_CONTAINER );
 
 	*other = out;
 
-	err_set_result( Result_Ok );
+	err_set_ok();
 	return true;
 }
 size_t cont_elem_size( const container* this )
@@ -367,18 +553,144 @@ size_t cont_calc_addr( const container* this, const size_t idx )
 {
 	return idx * cont_elem_size( this );
 }
+char* cont_inline_storage( _container* pdata )
+{
+	return ( char* )pdata + CONT_INLINE_OFFSET;
+}
+bool cont_is_inline( _container* pdata )
+{
+	return pdata->inlineCapacity != 0 && pdata->pBuffer == cont_inline_storage( pdata );
+}
 void* cont_get_element( const container* this, const size_t idx )
 {
 	return &this->pdata->pBuffer[ cont_calc_addr( this, idx ) ];
 }
+bool cont_construct_range( container* this, const size_t first, const size_t last )
+{
+	if( this->pdata->trivialConstruct )
+	{
+		memset( cont_get_element( this, first ), 0, cont_calc_addr( this, last - first ) );
+		return true;
+	}
 
-// container properties
-void cont_clear( container* this )
+	for( size_t i = first; i < last; ++i )
+	{
+		container_func_params params = { cont_get_element( this, i ), nullptr, cont_elem_size( this ) };
+		if( this->pdata->constructor( params ) == false )
+		{
+			cont_destroy_range( this, first, i );
+			return false;
+		}
+	}
+
+	return true;
+}
+bool cont_copy_range( const container* this, const char* src, char* dst, const size_t count )
+{
+	const size_t elemSize = cont_elem_size( this );
+
+	if( this->pdata->trivialCopy )
+	{
+		memcpy( dst, src, count * elemSize );
+		return true;
+	}
+
+	for( size_t i = 0; i < count; ++i )
+	{
+		container_func_params params = { &src[ i * elemSize ], &dst[ i * elemSize ], elemSize };
+		if( this->pdata->copy_construct( params ) == false )
+		{
+			// Undo the copies already made so dst is raw storage again
+			for( size_t j = 0; j < i; ++j )
+			{
+				container_func_params undo = { &dst[ j * elemSize ], nullptr, elemSize };
+				this->pdata->destructor( undo );
+			}
+			return false;
+		}
+	}
+
+	return true;
+}
+void cont_destroy_range( container* this, const size_t first, const size_t last )
+{
+	if( this->pdata->trivialDestroy )
+	{
+		return;
+	}
+
+	for( size_t i = first; i < last; ++i )
+	{
+		container_func_params params = { cont_get_element( this, i ), nullptr, cont_elem_size( this ) };
+		this->pdata->destructor( params );
+	}
+}
+void cont_relocate_range( const container* this, char* src, char* dst, const size_t count )
+{
+	const size_t elemSize = cont_elem_size( this );
+
+	if( this->pdata->trivialRelocate )
+	{
+		memmove( dst, src, count * elemSize );
+		return;
+	}
+
+	// Walk away from the overlap so no element is overwritten before it moves
+	for( size_t i = 0; i < count; ++i )
+	{
+		const size_t idx = dst > src ? count - 1 - i : i;
+		container_func_params params = { &src[ idx * elemSize ], &dst[ idx * elemSize ], elemSize };
+		this->pdata->relocate( params );
+	}
+}
+bool cont_bitwise_relocatable( const container* this )
+{
+	return this->pdata->trivialRelocate;
+}
+void cont_relocate( const container* this, void* src, void* dst, const size_t count )
+{
+	cont_relocate_range( this, ( char* )src, ( char* )dst, count );
+}
+bool cont_assign( container* this, char* elem, const void* value )
+{
+	if( this->pdata->trivialCopy )
+	{
+		memcpy( elem, value, cont_elem_size( this ) );
+		return true;
+	}
+
+	// Copy construction expects raw storage, so the old value goes first
+	container_func_params params = { elem, nullptr, cont_elem_size( this ) };
+	this->pdata->destructor( params );
+	if( cont_copy_range( this, ( const char* )value, elem, 1 ) == false )
+	{
+		// Leave a valid element behind so the size stays correct
+		const ResultCode rescode = err_get_result();
+		this->pdata->constructor( params );
+		err_set_result( rescode );
+		return false;
+	}
+
+	return true;
+}
+
+bool cont_grow_for( container* this, const size_t count )
 {
-	while( cont_empty( this ) == false )
+	const size_t required = cont_size( this ) + count;
+	if( required <= cont_capacity( this ) )
 	{
-		cont_pop_back( this );
+		return true;
 	}
+
+	const size_t grown = ( ( cont_size( this ) + 1 ) * 3 ) / 2;
+	return cont_reserve( this, required > grown ? required : grown );
+}
+
+// container properties
+void cont_clear( container* this )
+{
+	cont_destroy_range( this, 0, cont_size( this ) );
+	this->pdata->size = 0;
 }
 void cont_pop_back( container* this )
 {
@@ -387,146 +699,907 @@ void cont_pop_back( container* this )
 		return;
 	}
 
-	iterator it = cont_end( this );
-	it.previous( it );
-
-	this->pdata->destructor( it.get( it ), cont_elem_size( this ) );
+	cont_destroy_range( this, cont_size( this ) - 1, cont_size( this ) );
 
 	--this->pdata->size;
 }
 _Bool cont_push_back( container* this, const void* value )
 {
-	if( cont_size( this ) >= cont_capacity( this ) )
+	if( cont_grow_for( this, 1 ) == false )
 	{
-		const size_t newSize = ( ( cont_size( this ) + 1 ) * 3 ) / 2;
-		if( cont_reserve( this, newSize ) == false )
-		{
-			return false;
-		}
+		return false;
 	}
 
-	iterator it = cont_end( this );
+	if( cont_copy_range( this, ( const char* )value, cont_get_element( this, cont_size( this ) ), 1 ) == false )
+	{
+		return false;
+	}
 
-	const size_t elemSize = cont_elem_size( this );
-	//this->pdata->constructor( it.get(it), elemSize );
-	this->pdata->copy_construct( value, it.get( it ), elemSize );
+	++this->pdata->size;
+
+	err_set_ok();
+	return true;
+}
+void* cont_emplace_back( container* this )
+{
+	if( cont_grow_for( this, 1 ) == false )
+	{
+		return nullptr;
+	}
+
+	const size_t idx = cont_size( this );
+	if( cont_construct_range( this, idx, idx + 1 ) == false )
+	{
+		return nullptr;
+	}
 
 	++this->pdata->size;
 
-	err_set_result( Result_Ok );
+	err_set_ok();
+	return cont_get_element( this, idx );
+}
+_Bool cont_append_n( container* this, const void* value, const size_t count )
+{
+	if( value == nullptr && count > 0 )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+	if( cont_grow_for( this, count ) == false )
+	{
+		return false;
+	}
+
+	const size_t elemSize = cont_elem_size( this );
+	char* dst = cont_get_element( this, cont_size( this ) );
+	if( this->pdata->trivialCopy && count > 0 )
+	{
+		// Seed one copy, then double the filled prefix until the span is covered
+		memcpy( dst, value, elemSize );
+		for( size_t filled = 1; filled < count; )
+		{
+			const size_t chunk = filled < count - filled ? filled : count - filled;
+			memcpy( &dst[ filled * elemSize ], dst, chunk * elemSize );
+			filled += chunk;
+		}
+	}
+	else
+	{
+		for( size_t i = 0; i < count; ++i )
+		{
+			if( cont_copy_range( this, ( const char* )value, &dst[ i * elemSize ], 1 ) == false )
+			{
+				const ResultCode rescode = err_get_result();
+				for( size_t j = 0; j < i; ++j )
+				{
+					container_func_params undo = { &dst[ j * elemSize ], nullptr, elemSize };
+					this->pdata->destructor( undo );
+				}
+				err_set_result( rescode );
+				return false;
+			}
+		}
+	}
+	this->pdata->size += count;
+
+	err_set_ok();
+	return true;
+}
+_Bool cont_append_array( container* this, const void* values, const size_t count )
+{
+	if( values == nullptr && count > 0 )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+	if( cont_grow_for( this, count ) == false )
+	{
+		return false;
+	}
+
+	if( cont_copy_range( this, ( const char* )values, cont_get_element( this, cont_size( this ) ), count ) == false )
+	{
+		return false;
+	}
+	this->pdata->size += count;
+
+	err_set_ok();
 	return true;
 }
 _Bool cont_reserve( container* this, const size_t size )
 {
 	if( this->pdata->capacity >= size )
 	{
-		err_set_result( Result_Ok );
+		err_set_ok();
 		return true;
 	}
 
+	prof_begin( PROF_CONT_RESERVE );
+	const bool result = cont_reallocate( this, size );
+	prof_end( PROF_CONT_RESERVE );
+
+	return result;
+}
+bool cont_reallocate( container* this, const size_t size )
+{
 	const size_t newSize = size * this->pdata->elemSize;
-	char* pBuffer = ( char* )malloc( newSize );
+
+	// Bitwise relocatable elements can be moved by the allocator, often without copying at all.
+	// Inline storage is part of the _container block and always spills with malloc.
+	if( this->pdata->trivialRelocate && cont_is_inline( this->pdata ) == false )
+	{
+		char* pBuffer = ( char* )mem_realloc( MEM_CONTAINER, this->pdata->pBuffer, newSize );
+		if( pBuffer == nullptr )
+		{
+			err_set_result( Result_Bad_Alloc );
+			return false;
+		}
+		mem_count_grow( MEM_CONTAINER );
+
+		this->pdata->pBuffer = pBuffer;
+		this->pdata->capacity = size;
+
+		err_set_ok();
+		return true;
+	}
+
+	char* pBuffer = ( char* )mem_alloc( MEM_CONTAINER, newSize );
 
 	if( pBuffer == nullptr )
 	{
 		err_set_result( Result_Bad_Alloc );
 		return false;
 	}
+	mem_count_grow( MEM_CONTAINER );
 
-	const iterator beg = cont_begin( this );
-	const iterator end = cont_end( this );
-
-	for( iterator it = beg; it.is_equal( it, end ) == false; it = it.advance( it ) )
+	// The old buffer is raw storage after relocating, nothing is left to destroy
+	cont_relocate_range( this, this->pdata->pBuffer, pBuffer, cont_size( this ) );
+	if( cont_is_inline( this->pdata ) == false )
 	{
-		const size_t diff = it.distance( beg, it );
-		const size_t idx = cont_calc_addr( this, diff );
-		this->pdata->copy_construct( it.get( it ), &pBuffer[ idx ], cont_elem_size( this ) );
+		mem_free( MEM_CONTAINER, this->pdata->pBuffer );
 	}
 
-	SafeDelete( &this->pdata->pBuffer );
-
 	this->pdata->pBuffer = pBuffer;
 	this->pdata->capacity = size;
 
-	err_set_result( Result_Ok );
+	err_set_ok();
 	return true;
 
 }
 _Bool cont_resize( container* this, const size_t size )
 {
-	if( cont_reserve( this, size + 1 ) == true )
+	const size_t oldSize = cont_size( this );
+
+	if( size < oldSize )
 	{
-		this->pdata->size = size;
-		return true;
+		cont_destroy_range( this, size, oldSize );
+	}
+	else if( cont_reserve( this, size ) == false || cont_construct_range( this, oldSize, size ) == false )
+	{
+		return false;
 	}
 
-	return false;
+	this->pdata->size = size;
+
+	err_set_ok();
+	return true;
 }
 
 // setter
 _Bool cont_at_set( container* this, size_t idx, const void* value )
 {
-	iterator it = cont_begin( this );
-	it.move_by( it, idx );
-	it.set( it, value );
+	if( idx >= cont_size( this ) )
+	{
+		err_set_result( Result_Index_Out_Of_Range );
+		return false;
+	}
+
+	if( cont_assign( this, cont_get_element( this, idx ), value ) == false )
+	{
+		return false;
+	}
+
+	err_set_ok();
 	return true;
 }
 _Bool cont_insert( container* this, size_t offset, const void* value )
 {
-	container temp = { 0 };
-	if( cont_size_construct(
-		&temp,
-		cont_size( this ) + 1,
-		cont_elem_size( this ),
-		this->pdata->constructor,
-		this->pdata->copy_construct,
-		this->pdata->destructor
-	) == false )
+	return cont_insert_range( this, offset, value, 1 );
+}
+_Bool cont_insert_range( container* this, size_t offset, const void* values, const size_t count )
+{
+	if( offset > cont_size( this ) )
+	{
+		err_set_result( Result_Index_Out_Of_Range );
+		return false;
+	}
+	if( values == nullptr && count > 0 )
 	{
+		err_set_result( Result_Null_Parameter );
 		return false;
 	}
 
-	iterator this_it = cont_begin( &this );
-	iterator temp_it = cont_begin( &temp );
+	// values may be elements of this container, which growing or opening the gap moves, so only their
+	// byte offset is kept until the gap is open
+	const size_t length = cont_calc_addr( this, count );
+	const char* begin = this->pdata->pBuffer;
+	const bool aliased = count > 0 && cont_size( this ) > 0 && ( const char* )values >= begin && ( const char* )values < begin + cont_calc_addr( this, cont_size( this ) );
+	const size_t source = aliased ? ( size_t )( ( const char* )values - begin ) : 0;
+
+	if( cont_grow_for( this, count ) == false )
+	{
+		return false;
+	}
 
-	iterator end_it = cont_begin( &this );
-	end_it = end_it.move_by( end_it, offset );
+	// Open a gap of count elements at offset, then copy the values into it
+	const size_t back = cont_size( this ) - offset;
+	char* gap = cont_get_element( this, offset );
+	cont_relocate_range( this, gap, gap + length, back );
 
-	for( ; this_it.is_equal( this_it, end_it ) == false;
-		this_it = this_it.advance( this_it ), temp_it = temp_it.advance( temp_it ) )
+	const char* src = ( const char* )values;
+	char* scratch = nullptr;
+	if( aliased )
 	{
-		if( this->pdata->copy_construct(
-			this_it.get( this_it ),
-			temp_it.get( temp_it ),
-			cont_elem_size( this ) ) == false )
+		// The values are gathered from where they are now, the ones past offset moved up by the gap.
+		// The copy reads the gathered bytes while the elements themselves stay in place.
+		const size_t gapAt = cont_calc_addr( this, offset );
+		const size_t before = source < gapAt ? ( gapAt - source < length ? gapAt - source : length ) : 0;
+		const size_t after = ( source > gapAt ? source : gapAt ) + length;
+
+		scratch = ( char* )mem_alloc( MEM_CONTAINER, length );
+		if( scratch == nullptr )
 		{
-			cont_destroy( &temp );
+			cont_relocate_range( this, gap + length, gap, back );
+			err_set_result( Result_Bad_Alloc );
 			return false;
 		}
+
+		begin = this->pdata->pBuffer;
+		memcpy( scratch, &begin[ source ], before );
+		memcpy( &scratch[ before ], &begin[ after ], length - before );
+		src = scratch;
 	}
 
-	temp_it.set( temp_it, value );
-	temp_it = temp_it.advance( temp_it );
+	const bool copied = cont_copy_range( this, src, gap, count );
+	const ResultCode rescode = err_get_result();
+	mem_free( MEM_CONTAINER, scratch );
+	if( copied == false )
+	{
+		cont_relocate_range( this, gap + length, gap, back );
+		err_set_result( rescode );
+		return false;
+	}
+	this->pdata->size += count;
+
+	err_set_ok();
+	return true;
+}
+
+// removal
+_Bool cont_erase( container* this, size_t offset )
+{
+	return cont_erase_range( this, offset, offset + 1 );
+}
+_Bool cont_erase_range( container* this, size_t first, size_t last )
+{
+	if( first > last || last > cont_size( this ) )
+	{
+		err_set_result( Result_Index_Out_Of_Range );
+		return false;
+	}
+
+	// Close the gap by moving the tail down
+	const size_t back = cont_size( this ) - last;
+	cont_destroy_range( this, first, last );
+	cont_relocate_range( this, cont_get_element( this, last ), cont_get_element( this, first ), back );
+	this->pdata->size -= last - first;
+
+	err_set_ok();
+	return true;
+}
+size_t cont_erase_if( container* this, element_predicate predicate, void* user )
+{
+	if( predicate == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return 0;
+	}
+
+	// Kept elements are moved down in runs, so plain data needs one memmove per run
+	const size_t size = cont_size( this );
+	size_t kept = 0;
+	size_t runStart = 0;
+	for( size_t i = 0; i < size; ++i )
+	{
+		if( predicate( cont_get_element( this, i ), user ) == false )
+		{
+			continue;
+		}
+
+		cont_relocate_range( this, cont_get_element( this, runStart ), cont_get_element( this, kept ), i - runStart );
+		kept += i - runStart;
+		runStart = i + 1;
+		cont_destroy_range( this, i, i + 1 );
+	}
+	cont_relocate_range( this, cont_get_element( this, runStart ), cont_get_element( this, kept ), size - runStart );
+	kept += size - runStart;
+
+	this->pdata->size = kept;
+
+	err_set_ok();
+	return size - kept;
+}
+_Bool cont_swap_remove( container* this, size_t offset )
+{
+	if( offset >= cont_size( this ) )
+	{
+		err_set_result( Result_Index_Out_Of_Range );
+		return false;
+	}
+
+	// The last element fills the hole, nothing else moves
+	const size_t last = cont_size( this ) - 1;
+	cont_destroy_range( this, offset, offset + 1 );
+	if( offset != last )
+	{
+		cont_relocate_range( this, cont_get_element( this, last ), cont_get_element( this, offset ), 1 );
+	}
+	--this->pdata->size;
+
+	err_set_ok();
+	return true;
+}
+
+
+// hash map
+bool hm_construct( hashmap* this, const size_t valueSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor )
+{
+	_hashmap* pdata = nullptr;
+	bool result = true;
+	ResultCode rescode = Result_Ok;
+
+	if( this == nullptr )
+	{
+		rescode = Result_Null_Parameter;
+		result = false;
+	}
+	if( result )
+	{
+		pdata = ( _hashmap* )mem_alloc( MEM_HASHMAP, sizeof( _hashmap ) );
+		if( pdata == nullptr )
+		{
+			rescode = Result_Bad_Alloc;
+			result = false;
+		}
+	}
+	if( result )
+	{
+		memset( pdata, 0, sizeof( _hashmap ) );
+		pdata->valueSize = valueSize;
+		pdata->constructor = constructor != nullptr ? constructor : trivially_constructable;
+		pdata->copy_construct = copy_construct != nullptr ? copy_construct : trivially_copyable;
+		pdata->destructor = destructor != nullptr ? destructor : trivially_destructable;
+		pdata->trivialCopy = pdata->copy_construct == trivially_copyable;
+		pdata->trivialDestroy = pdata->destructor == trivially_destructable;
+
+		if( hm_resize( pdata, HM_MIN_CAPACITY ) == false )
+		{
+			rescode = Result_Bad_Alloc;
+			mem_free( MEM_HASHMAP, pdata );
+			pdata = nullptr;
+			result = false;
+		}
+	}
+	if( result )
+	{
+		hashmap self = { 0 };
+		self.find = hm_find;
+		self.find_cstring = hm_find_cstring;
+		self.empty = hm_empty;
+		self.size = hm_size;
+		self.capacity = hm_capacity;
+		self.memory_usage = hm_memory_usage;
+		self.for_each = hm_for_each;
+		self.clear = hm_clear;
+		self.reserve = hm_reserve;
+		self.rehash = hm_rehash;
+		self.insert = hm_insert;
+		self.insert_cstring = hm_insert_cstring;
+		self.get_or_insert = hm_get_or_insert;
+		self.erase = hm_erase;
+		self.erase_cstring = hm_erase_cstring;
+		self.pdata = pdata;
+
+		*this = self;
+	}
+
+	err_set_result( rescode );
+	return result;
+}
+bool hm_destroy( hashmap* this )
+{
+	if( this == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+	if( this->pdata == nullptr )
+	{
+		err_set_result( Result_Not_Initialized );
+		return false;
+	}
+
+	hm_clear( this );
+	mem_free( MEM_HASHMAP, this->pdata->ctrl );
+	mem_free( MEM_HASHMAP, this->pdata );
+	this->pdata = nullptr;
+
+	hashmap self = { 0 };
+	*this = self;
+
+	err_set_ok();
+	return true;
+}
+
+// getters
+void* hm_find( const hashmap* this, const char* key, const size_t length )
+{
+	if( key == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return nullptr;
+	}
+
+	size_t idx = 0;
+	err_set_ok();
+	return hm_lookup( this->pdata, key, length, hm_hash( key, length ), &idx ) ? hm_value( this->pdata, idx ) : nullptr;
+}
+void* hm_find_cstring( const hashmap* this, const struct cstring* key )
+{
+	return hm_find( this, key->str( key ), key->size( key ) );
+}
+_Bool hm_empty( const hashmap* this )
+{
+	return this->pdata->size == 0;
+}
+size_t hm_size( const hashmap* this )
+{
+	return this->pdata->size;
+}
+size_t hm_capacity( const hashmap* this )
+{
+	return this->pdata->capacity;
+}
+
+// utilities
+size_t hm_memory_usage( const hashmap* this )
+{
+	const _hashmap* map = this->pdata;
+	return sizeof( _hashmap ) + hm_table_bytes( map->capacity, map->valueSize, nullptr ) + map->keyBytes;
+}
+_Bool hm_for_each( const hashmap* this, entry_visitor visitor, void* user )
+{
+	if( visitor == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	err_set_ok();
+
+	const _hashmap* map = this->pdata;
+	for( size_t i = 0; i < map->capacity; ++i )
+	{
+		if( map->ctrl[ i ] >= 0 &&
+			visitor( map->slots[ i ].key, map->slots[ i ].length, hm_value( map, i ), user ) == false )
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// map properties
+void hm_clear( hashmap* this )
+{
+	_hashmap* map = this->pdata;
+	for( size_t i = 0; i < map->capacity && map->size > 0; ++i )
+	{
+		if( map->ctrl[ i ] >= 0 )
+		{
+			hm_remove_slot( map, i );
+		}
+	}
+
+	memset( map->ctrl, HM_CTRL_EMPTY, map->capacity + HM_GROUP_WIDTH );
+	map->growthLeft = map->capacity - map->capacity / 8;
+}
+_Bool hm_reserve( hashmap* this, const size_t size )
+{
+	const size_t capacity = hm_capacity_for( size );
+	if( capacity <= this->pdata->capacity )
+	{
+		err_set_ok();
+		return true;
+	}
+
+	return hm_resize( this->pdata, capacity );
+}
+_Bool hm_rehash( hashmap* this, const size_t buckets )
+{
+	// Never shrink below what the current entries need, rehashing at the same size drops tombstones
+	size_t capacity = hm_capacity_for( this->pdata->size );
+	while( capacity < buckets )
+	{
+		capacity *= 2;
+	}
 
-	end_it = this->end( &this );
+	return hm_resize( this->pdata, capacity );
+}
+
+// setters
+_Bool hm_insert( hashmap* this, const char* key, const size_t length, const void* value )
+{
+	_hashmap* map = this->pdata;
+	size_t idx = 0;
+	bool inserted = false;
+
+	if( key == nullptr || value == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+	if( hm_prepare_insert( map, key, length, &idx, &inserted ) == false )
+	{
+		return false;
+	}
+
+	char* slot = hm_value( map, idx );
+	if( map->trivialCopy )
+	{
+		// A bitwise copy can still replace a value that owns resources, unless it is being stored over itself
+		if( inserted == false && map->trivialDestroy == false && ( const void* )slot != value )
+		{
+			container_func_params old = { slot, nullptr, map->valueSize };
+			map->destructor( old );
+		}
+		memcpy( slot, value, map->valueSize );
+		err_set_ok();
+		return true;
+	}
+
+	container_func_params params = { slot, nullptr, map->valueSize };
+	if( inserted == false )
+	{
+		map->destructor( params );
+	}
+
+	container_func_params copy = { value, slot, map->valueSize };
+	if( map->copy_construct( copy ) == false )
+	{
+		const ResultCode rescode = err_get_result();
+		if( inserted )
+		{
+			// Take the half built entry back out, its value was never constructed
+			hm_free_key( map, idx );
+			hm_set_ctrl( map, idx, HM_CTRL_DELETED );
+			--map->size;
+		}
+		else
+		{
+			map->constructor( params );
+		}
+		err_set_result( rescode );
+		return false;
+	}
+
+	err_set_ok();
+	return true;
+}
+_Bool hm_insert_cstring( hashmap* this, const struct cstring* key, const void* value )
+{
+	return hm_insert( this, key->str( key ), key->size( key ), value );
+}
+void* hm_get_or_insert( hashmap* this, const char* key, const size_t length )
+{
+	_hashmap* map = this->pdata;
+	size_t idx = 0;
+	bool inserted = false;
+
+	if( key == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return nullptr;
+	}
+	if( hm_prepare_insert( map, key, length, &idx, &inserted ) == false )
+	{
+		return nullptr;
+	}
 
-	for( ; this_it.is_equal( this_it, end_it ) == false;
-		this_it = this_it.advance( this_it ), temp_it = temp_it.advance( temp_it ) )
+	char* slot = hm_value( map, idx );
+	if( inserted )
 	{
-		if( this->pdata->copy_construct(
-			this_it.get( this_it ),
-			temp_it.get( temp_it ),
-			cont_elem_size( this ) ) == false )
+		container_func_params params = { slot, nullptr, map->valueSize };
+		if( map->constructor( params ) == false )
+		{
+			const ResultCode rescode = err_get_result();
+			hm_free_key( map, idx );
+			hm_set_ctrl( map, idx, HM_CTRL_DELETED );
+			--map->size;
+			err_set_result( rescode );
+			return nullptr;
+		}
+	}
+
+	err_set_ok();
+	return slot;
+}
+_Bool hm_erase( hashmap* this, const char* key, const size_t length )
+{
+	size_t idx = 0;
+
+	if( key == nullptr )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	err_set_ok();
+	if( hm_lookup( this->pdata, key, length, hm_hash( key, length ), &idx ) == false )
+	{
+		return false;
+	}
+
+	hm_remove_slot( this->pdata, idx );
+	return true;
+}
+_Bool hm_erase_cstring( hashmap* this, const struct cstring* key )
+{
+	return hm_erase( this, key->str( key ), key->size( key ) );
+}
+
+// hash map internals
+uint64_t hm_hash( const char* key, const size_t length )
+{
+	const uint64_t mul = 0x9E3779B97F4A7C15ull;
+	uint64_t hash = 0x243F6A8885A308D3ull ^ ( length * mul );
+	size_t pos = 0;
+
+	for( ; pos + 8 <= length; pos += 8 )
+	{
+		uint64_t word = 0;
+		memcpy( &word, &key[ pos ], 8 );
+		hash = ( hash ^ word ) * mul;
+		hash ^= hash >> 29;
+	}
+	if( pos < length )
+	{
+		uint64_t word = 0;
+		memcpy( &word, &key[ pos ], length - pos );
+		hash = ( hash ^ word ) * mul;
+	}
+
+	// Final avalanche so both the low 7 bits and the high bits are well mixed
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDull;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
+uint32_t hm_match( const signed char* group, const signed char h2 )
+{
+#if defined( CSAPI_HAVE_SSE2 )
+	const __m128i ctrl = _mm_loadu_si128( ( const __m128i* )group );
+	return ( uint32_t )_mm_movemask_epi8( _mm_cmpeq_epi8( ctrl, _mm_set1_epi8( h2 ) ) );
+#else
+	uint32_t mask = 0;
+	for( unsigned i = 0; i < HM_GROUP_WIDTH; ++i )
+	{
+		mask |= ( uint32_t )( group[ i ] == h2 ) << i;
+	}
+	return mask;
+#endif
+}
+uint32_t hm_match_empty( const signed char* group )
+{
+	return hm_match( group, HM_CTRL_EMPTY );
+}
+uint32_t hm_match_free( const signed char* group )
+{
+	// Empty and deleted are the only control bytes with the sign bit set
+#if defined( CSAPI_HAVE_SSE2 )
+	return ( uint32_t )_mm_movemask_epi8( _mm_loadu_si128( ( const __m128i* )group ) );
+#else
+	uint32_t mask = 0;
+	for( unsigned i = 0; i < HM_GROUP_WIDTH; ++i )
+	{
+		mask |= ( uint32_t )( group[ i ] < 0 ) << i;
+	}
+	return mask;
+#endif
+}
+bool hm_lookup( const _hashmap* map, const char* key, const size_t length, const uint64_t hash, size_t* index )
+{
+	const size_t mask = map->capacity - 1;
+	const signed char h2 = ( signed char )( hash & 0x7F );
+	size_t pos = ( size_t )( hash >> 7 ) & mask;
+
+	// Triangular steps over groups visit every group once the table size is a power of two
+	for( size_t step = HM_GROUP_WIDTH; ; step += HM_GROUP_WIDTH )
+	{
+		const signed char* group = &map->ctrl[ pos ];
+		for( uint32_t match = hm_match( group, h2 ); match != 0; match = ( uint32_t )bit_clear_lowest( match ) )
+		{
+			const size_t idx = ( pos + bit_ctz64( match ) ) & mask;
+			const hm_slot* slot = &map->slots[ idx ];
+			if( slot->hash == hash && slot->length == length && memcmp( slot->key, key, length ) == 0 )
+			{
+				*index = idx;
+				return true;
+			}
+		}
+		if( hm_match_empty( group ) != 0 )
 		{
-			cont_destroy( &temp );
 			return false;
 		}
+
+		pos = ( pos + step ) & mask;
 	}
+}
+size_t hm_find_free( const _hashmap* map, const uint64_t hash )
+{
+	const size_t mask = map->capacity - 1;
+	size_t pos = ( size_t )( hash >> 7 ) & mask;
 
-	SafeDelete( &this->pdata->pBuffer );
-	*this->pdata = *temp.pdata;
-	SafeDelete( &temp.pdata );
+	for( size_t step = HM_GROUP_WIDTH; ; step += HM_GROUP_WIDTH )
+	{
+		const uint32_t match = hm_match_free( &map->ctrl[ pos ] );
+		if( match != 0 )
+		{
+			return ( pos + bit_ctz64( match ) ) & mask;
+		}
 
-	err_set_result( Result_Ok );
+		pos = ( pos + step ) & mask;
+	}
+}
+void hm_set_ctrl( _hashmap* map, const size_t idx, const signed char value )
+{
+	// Slots in the first group are mirrored past the end, for the rest both writes hit idx
+	map->ctrl[ idx ] = value;
+	map->ctrl[ ( ( idx - HM_GROUP_WIDTH ) & ( map->capacity - 1 ) ) + HM_GROUP_WIDTH ] = value;
+}
+char* hm_value( const _hashmap* map, const size_t idx )
+{
+	return &map->values[ idx * map->valueSize ];
+}
+size_t hm_capacity_for( const size_t size )
+{
+	// Smallest power of two that keeps the load at or below 7/8
+	size_t capacity = HM_MIN_CAPACITY;
+	while( capacity - capacity / 8 < size )
+	{
+		capacity *= 2;
+	}
+	return capacity;
+}
+size_t hm_table_bytes( const size_t capacity, const size_t valueSize, size_t* ctrlBytes )
+{
+	// Control bytes, padded to keep the slots aligned, then slots, then values
+	const size_t ctrl = ( capacity + HM_GROUP_WIDTH + 15 ) & ~( size_t )15;
+	if( ctrlBytes != nullptr )
+	{
+		*ctrlBytes = ctrl;
+	}
+	return ctrl + capacity * sizeof( hm_slot ) + capacity * valueSize;
+}
+bool hm_resize( _hashmap* map, const size_t capacity )
+{
+	size_t ctrlBytes = 0;
+	const size_t slotBytes = capacity * sizeof( hm_slot );
+	char* block = ( char* )mem_alloc( MEM_HASHMAP, hm_table_bytes( capacity, map->valueSize, &ctrlBytes ) );
+	if( block == nullptr )
+	{
+		err_set_result( Result_Bad_Alloc );
+		return false;
+	}
+	if( map->ctrl != nullptr )
+	{
+		mem_count_grow( MEM_HASHMAP );
+	}
+
+	signed char* oldCtrl = map->ctrl;
+	hm_slot* oldSlots = map->slots;
+	char* oldValues = map->values;
+	const size_t oldCapacity = map->capacity;
+
+	map->ctrl = ( signed char* )block;
+	map->slots = ( hm_slot* )( block + ctrlBytes );
+	map->values = block + ctrlBytes + slotBytes;
+	map->capacity = capacity;
+	map->growthLeft = capacity - capacity / 8 - map->size;
+	memset( map->ctrl, HM_CTRL_EMPTY, capacity + HM_GROUP_WIDTH );
+
+	// Keys move with their slot and values are relocated bitwise, nothing is copied or destroyed
+	for( size_t i = 0; i < oldCapacity; ++i )
+	{
+		if( oldCtrl[ i ] >= 0 )
+		{
+			const size_t idx = hm_find_free( map, oldSlots[ i ].hash );
+			hm_set_ctrl( map, idx, oldCtrl[ i ] );
+			map->slots[ idx ] = oldSlots[ i ];
+			memcpy( hm_value( map, idx ), &oldValues[ i * map->valueSize ], map->valueSize );
+		}
+	}
+
+	mem_free( MEM_HASHMAP, oldCtrl );
+
+	err_set_ok();
+	return true;
+}
+bool hm_prepare_insert( _hashmap* map, const char* key, const size_t length, size_t* index, bool* inserted )
+{
+	const uint64_t hash = hm_hash( key, length );
+	if( hm_lookup( map, key, length, hash, index ) )
+	{
+		*inserted = false;
+		return true;
+	}
+
+	size_t idx = hm_find_free( map, hash );
+	if( map->growthLeft == 0 && map->ctrl[ idx ] == HM_CTRL_EMPTY )
+	{
+		// Out of room, grow unless tombstones take up more than half of the table
+		const size_t capacity = map->size * 2 >= map->capacity - map->capacity / 8 ?
+			map->capacity * 2 :
+			map->capacity;
+		if( hm_resize( map, capacity ) == false )
+		{
+			return false;
+		}
+		idx = hm_find_free( map, hash );
+	}
+
+	char* copy = ( char* )mem_alloc( MEM_HASHMAP, length + 1 );
+	if( copy == nullptr )
+	{
+		err_set_result( Result_Bad_Alloc );
+		return false;
+	}
+	map->keyBytes += length + 1;
+	memcpy( copy, key, length );
+	copy[ length ] = '\0';
+
+	if( map->ctrl[ idx ] == HM_CTRL_EMPTY )
+	{
+		--map->growthLeft;
+	}
+	hm_set_ctrl( map, idx, ( signed char )( hash & 0x7F ) );
+	map->slots[ idx ].hash = hash;
+	map->slots[ idx ].key = copy;
+	map->slots[ idx ].length = length;
+	++map->size;
+
+	*index = idx;
+	*inserted = true;
 	return true;
 }
+void hm_free_key( _hashmap* map, const size_t idx )
+{
+	map->keyBytes -= map->slots[ idx ].length + 1;
+	mem_free( MEM_HASHMAP, map->slots[ idx ].key );
+	map->slots[ idx ].key = nullptr;
+}
+void hm_remove_slot( _hashmap* map, const size_t idx )
+{
+	if( map->trivialDestroy == false )
+	{
+		container_func_params params = { hm_value( map, idx ), nullptr, map->valueSize };
+		map->destructor( params );
+	}
+
+	hm_free_key( map, idx );
+	hm_set_ctrl( map, idx, HM_CTRL_DELETED );
+	--map->size;
+}
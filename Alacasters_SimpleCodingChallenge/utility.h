@@ -3,6 +3,7 @@
 #include "defines.h"
 #include "customerror.h"
 #include <ctype.h>
+#include <stddef.h>
 #include <string.h>
 #include <stdarg.h>
 
@@ -19,54 +20,26 @@ typedef struct container_func_params
 typedef bool( *default_construct )( container_func_params params );
 typedef bool( *deep_copy_fn )( container_func_params params );
 typedef void( *destroy )( container_func_params params );
+// Moves the element at this into the raw storage at other, afterwards this is raw storage
+typedef void( *relocate_fn )( container_func_params params );
 typedef struct iterator iterator;
+typedef bool( *element_predicate )( const void* element, void* user );
+// Called with count elements of elemSize bytes starting at first, return false to stop early
+typedef bool( *span_visitor )( void* first, const size_t count, const size_t elemSize, void* user );
 
+// Hooks for plain data elements.  Containers compare against these addresses at construction
+// and replace per element calls with single memset, memcpy and realloc operations.
+// Passing nullptr for a hook selects the matching trivial hook.
 bool trivially_constructable( container_func_params params );
 bool trivially_copyable( container_func_params params );
 void trivially_destructable( container_func_params params );
-
-inline bool trivially_constructable( container_func_params params )
-{
-	if( params.this == nullptr )
-	{
-		err_set_result( Result_Null_Parameter );
-		return false;
-	}
-	if( params.this_size == 0 )
-	{
-		err_set_result( Result_Invalid_Parameter );
-		return false;
-	}
-
-	memset( params.this, 0, params.this_size );
-
-	err_set_result( Result_Ok );
-	return true;
-}
-inline bool trivially_copyable( container_func_params params )
-{
-	if( params.this == nullptr || params.other == nullptr )
-	{
-		err_set_result( Result_Null_Parameter );
-		return false;
-	}
-	if( params.this_size == 0 )
-	{
-		err_set_result( Result_Invalid_Parameter );
-		return false;
-	}
-
-	memcpy( params.other, params.this, params.this_size );
-
-	return true;
-}
-inline void trivially_destructable( container_func_params params ){}
+void trivially_relocatable( container_func_params params );
 
 struct iterator
 {
 	iterator( *advance )( iterator this );
 	iterator( *previous )( iterator this );
-	iterator( *move_by )( iterator this, int offset );
+	iterator( *move_by )( iterator this, ptrdiff_t offset );
 
 	bool( *is_equal )( iterator this, iterator other );
 	ptrdiff_t( *distance )( iterator this, iterator other );
@@ -78,6 +51,22 @@ struct iterator
 	char* cur;
 };
 
+// Private to utility.c, the layout is only visible for the unchecked accessors in fastpath.h
+struct _container
+{
+	char* pBuffer;
+	size_t capacity, size, elemSize;
+	// Elements that fit in the storage allocated behind this struct, pBuffer points there until it spills
+	size_t inlineCapacity;
+	default_construct constructor;
+	deep_copy_fn copy_construct;
+	destroy destructor;
+	relocate_fn relocate;
+
+	// Set when the matching hook is one of the trivially_* functions
+	bool trivialConstruct, trivialCopy, trivialDestroy, trivialRelocate;
+};
+
 struct container
 {
 	iterator( *begin )( const container* this );
@@ -89,6 +78,8 @@ struct container
 	size_t( *size )( const container* this );
 	size_t( *capacity )( const container* this );
 	const void* const( *data )( const container* this );
+	// Heap bytes of the element storage and bookkeeping, memory owned by the elements is not included
+	size_t( *memory_usage )( const container* this );
 
 	// utilities
 	_Bool( *copy )( const container* this, container* other );
@@ -97,21 +88,98 @@ struct container
 	void( *clear )( container* this );
 	void( *pop_back )( container* this );
 	_Bool( *push_back )( container* this, const void* value );
+	// Default constructs a new element at the back and returns it to be filled in place, nullptr on failure.
+	// The pointer is valid until the next call that changes the size or capacity.
+	void*( *emplace_back )( container* this );
+	// Grow once and copy count elements to the back, values must not point into this container.
+	// append_n copies the single value count times, append_array copies count consecutive values.
+	_Bool( *append_n )( container* this, const void* value, const size_t count );
+	_Bool( *append_array )( container* this, const void* values, const size_t count );
 	_Bool( *reserve )( container* this, const size_t size );
 	_Bool( *resize )( container* this, const size_t size );
 
 	// setter
 	_Bool( *at_set )( container* this, size_t idx, const void* value );
 	_Bool( *insert )( container* this, size_t offset, const void* value );
+	// values may point into this container, the elements are copied as they were before the insert
+	_Bool( *insert_range )( container* this, size_t offset, const void* values, const size_t count );
+
+	// removal, the order of the remaining elements is kept except by swap_remove
+	_Bool( *erase )( container* this, size_t offset );
+	_Bool( *erase_range )( container* this, size_t first, size_t last );
+	size_t( *erase_if )( container* this, element_predicate predicate, void* user );
+	_Bool( *swap_remove )( container* this, size_t offset );
 
 	_container* pdata;
 };
 
-bool cont_default_construct( container* this, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor );
-bool cont_reserve_construct( container* this, const size_t size, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor );
-bool cont_size_construct( container* this, const size_t size, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor );
+bool cont_default_construct( container* this, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor, relocate_fn relocate );
+// The first inlineCount elements are stored in the same allocation as the container's bookkeeping,
+// growing past them moves the elements to a separate heap buffer.  cont_default_construct keeps 3 inline
+// and copies keep the inline count of their source.
+bool cont_inline_construct( container* this, const size_t inlineCount, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor, relocate_fn relocate );
+bool cont_reserve_construct( container* this, const size_t size, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor, relocate_fn relocate );
+bool cont_size_construct( container* this, const size_t size, const size_t elementSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor, relocate_fn relocate );
 bool cont_destroy( container* this );
 
+// Raw element range, valid until the next call that changes the size or capacity.
+// Step through it with a char* and the element size, or cast it to the element type.
+void* cont_ptr_begin( const container* this );
+void* cont_ptr_end( const container* this );
+
+// Calls visitor once per contiguous run of elements, returns false when the visitor stopped early
+bool cont_for_each( const container* this, span_visitor visitor, void* user );
+
+// Element moves for algorithms layered on container.  cont_relocate moves count elements from src
+// to dst with the relocate hook, the ranges may overlap and src is raw storage afterwards.
+size_t cont_elem_size( const container* this );
+bool cont_bitwise_relocatable( const container* this );
+void cont_relocate( const container* this, void* src, void* dst, const size_t count );
+
+
+// Hash map from byte string keys to values of a fixed size.  Open addressing over flat arrays,
+// a control byte per slot holds 7 bits of the hash and groups of 16 are probed with one vector compare.
+// Keys are copied into the map, values are built with the same hooks container uses and are
+// relocated bitwise when the table grows.  Value pointers are valid until the next insert, rehash or reserve.
+struct cstring;
+typedef struct _hashmap _hashmap;
+typedef struct hashmap hashmap;
+
+// Called once per entry, return false to stop early
+typedef bool( *entry_visitor )( const char* key, const size_t length, void* value, void* user );
+
+struct hashmap
+{
+	// getters, a missing key returns nullptr
+	void*( *find )( const hashmap* this, const char* key, const size_t length );
+	void*( *find_cstring )( const hashmap* this, const struct cstring* key );
+	_Bool( *empty )( const hashmap* this );
+	size_t( *size )( const hashmap* this );
+	size_t( *capacity )( const hashmap* this );
+	// Heap bytes of the table, key copies and bookkeeping, memory owned by the values is not included
+	size_t( *memory_usage )( const hashmap* this );
+
+	// utilities
+	_Bool( *for_each )( const hashmap* this, entry_visitor visitor, void* user );
+
+	// map properties
+	void( *clear )( hashmap* this );
+	_Bool( *reserve )( hashmap* this, const size_t size );
+	_Bool( *rehash )( hashmap* this, const size_t buckets );
+
+	// setters, insert replaces the value of an existing key
+	_Bool( *insert )( hashmap* this, const char* key, const size_t length, const void* value );
+	_Bool( *insert_cstring )( hashmap* this, const struct cstring* key, const void* value );
+	// Returns the value for key, default constructing it first when the key is new
+	void*( *get_or_insert )( hashmap* this, const char* key, const size_t length );
+	_Bool( *erase )( hashmap* this, const char* key, const size_t length );
+	_Bool( *erase_cstring )( hashmap* this, const struct cstring* key );
+
+	_hashmap* pdata;
+};
+
+bool hm_construct( hashmap* this, const size_t valueSize, default_construct constructor, deep_copy_fn copy_construct, destroy destructor );
+bool hm_destroy( hashmap* this );
 
 #ifndef swap
 #define swap(type,a,b){ type c = (*a);(*a) = (*b);(*b) = c;}
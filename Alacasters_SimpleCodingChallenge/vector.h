@@ -0,0 +1,301 @@
+#pragma once
+
+#include "defines.h"
+#include "customerror.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Typed counterpart of container.  DEFINE_VECTOR( name, T ) generates
+//
+//	typedef struct name { T* data; size_t size, capacity; } name;
+//
+// plus static inline functions prefixed with name, so the element size is known at compile time and
+// element hooks inline into the loops that call them.  Elements are always relocated bitwise.
+// Functions only write the global result code when they fail, a successful call leaves it untouched.
+//
+// DEFINE_VECTOR zero constructs, assigns and skips destruction, which suits plain data.
+// DEFINE_VECTOR_HOOKS takes typed hooks for elements that own resources:
+//	_Bool construct( T* elem ), _Bool copy( const T* src, T* dst ), void destroy( T* elem )
+// construct and copy are handed raw storage.
+
+#define DEFINE_VECTOR( name, T ) \
+static __inline _Bool name##_trivial_construct( T* elem ) \
+{ \
+	memset( elem, 0, sizeof( T ) ); \
+	return true; \
+} \
+static __inline _Bool name##_trivial_copy( const T* src, T* dst ) \
+{ \
+	*dst = *src; \
+	return true; \
+} \
+static __inline void name##_trivial_destroy( T* elem ) \
+{ \
+	( void )elem; \
+} \
+DEFINE_VECTOR_HOOKS( name, T, name##_trivial_construct, name##_trivial_copy, name##_trivial_destroy )
+
+#define DEFINE_VECTOR_HOOKS( name, T, construct_fn, copy_fn, destroy_fn ) \
+typedef struct name \
+{ \
+	T* data; \
+	size_t size, capacity; \
+}name; \
+\
+static __inline _Bool name##_construct( name* this ) \
+{ \
+	if( this == nullptr ) \
+	{ \
+		err_set_result( Result_Null_Parameter ); \
+		return false; \
+	} \
+\
+	this->data = nullptr; \
+	this->size = 0; \
+	this->capacity = 0; \
+	return true; \
+} \
+\
+/* getters */ \
+static __inline size_t name##_size( const name* this ) \
+{ \
+	return this->size; \
+} \
+static __inline size_t name##_capacity( const name* this ) \
+{ \
+	return this->capacity; \
+} \
+static __inline _Bool name##_empty( const name* this ) \
+{ \
+	return this->size == 0; \
+} \
+static __inline T* name##_begin( const name* this ) \
+{ \
+	return this->data; \
+} \
+static __inline T* name##_end( const name* this ) \
+{ \
+	return this->data + this->size; \
+} \
+/* Unchecked, idx must be less than size */ \
+static __inline T* name##_at( const name* this, const size_t idx ) \
+{ \
+	return &this->data[ idx ]; \
+} \
+static __inline _Bool name##_at_get( const name* this, const size_t idx, T* value ) \
+{ \
+	if( idx >= this->size ) \
+	{ \
+		err_set_result( Result_Index_Out_Of_Range ); \
+		return false; \
+	} \
+	return copy_fn( &this->data[ idx ], value ); \
+} \
+\
+/* container properties */ \
+static __inline void name##_destroy_range( name* this, const size_t first, const size_t last ) \
+{ \
+	for( size_t i = first; i < last; ++i ) \
+	{ \
+		destroy_fn( &this->data[ i ] ); \
+	} \
+} \
+static __inline void name##_clear( name* this ) \
+{ \
+	name##_destroy_range( this, 0, this->size ); \
+	this->size = 0; \
+} \
+static __inline void name##_destroy( name* this ) \
+{ \
+	name##_clear( this ); \
+	free( this->data ); \
+	this->data = nullptr; \
+	this->capacity = 0; \
+} \
+static __inline _Bool name##_reserve( name* this, const size_t size ) \
+{ \
+	if( size <= this->capacity ) \
+	{ \
+		return true; \
+	} \
+\
+	T* data = ( T* )realloc( this->data, size * sizeof( T ) ); \
+	if( data == nullptr ) \
+	{ \
+		err_set_result( Result_Bad_Alloc ); \
+		return false; \
+	} \
+\
+	this->data = data; \
+	this->capacity = size; \
+	return true; \
+} \
+static __inline _Bool name##_grow_for( name* this, const size_t count ) \
+{ \
+	const size_t required = this->size + count; \
+	if( required <= this->capacity ) \
+	{ \
+		return true; \
+	} \
+\
+	const size_t grown = ( ( this->size + 1 ) * 3 ) / 2; \
+	return name##_reserve( this, required > grown ? required : grown ); \
+} \
+static __inline _Bool name##_resize( name* this, const size_t size ) \
+{ \
+	if( size <= this->size ) \
+	{ \
+		name##_destroy_range( this, size, this->size ); \
+		this->size = size; \
+		return true; \
+	} \
+	if( name##_reserve( this, size ) == false ) \
+	{ \
+		return false; \
+	} \
+\
+	for( size_t i = this->size; i < size; ++i ) \
+	{ \
+		if( construct_fn( &this->data[ i ] ) == false ) \
+		{ \
+			name##_destroy_range( this, this->size, i ); \
+			return false; \
+		} \
+	} \
+	this->size = size; \
+	return true; \
+} \
+static __inline _Bool name##_push_back( name* this, const T* value ) \
+{ \
+	if( this->size == this->capacity && name##_grow_for( this, 1 ) == false ) \
+	{ \
+		return false; \
+	} \
+	if( copy_fn( value, &this->data[ this->size ] ) == false ) \
+	{ \
+		return false; \
+	} \
+\
+	++this->size; \
+	return true; \
+} \
+static __inline void name##_pop_back( name* this ) \
+{ \
+	if( this->size > 0 ) \
+	{ \
+		--this->size; \
+		destroy_fn( &this->data[ this->size ] ); \
+	} \
+} \
+\
+/* setters, at_set's value must not be the element it replaces */ \
+static __inline _Bool name##_at_set( name* this, const size_t idx, const T* value ) \
+{ \
+	if( idx >= this->size ) \
+	{ \
+		err_set_result( Result_Index_Out_Of_Range ); \
+		return false; \
+	} \
+\
+	destroy_fn( &this->data[ idx ] ); \
+	if( copy_fn( value, &this->data[ idx ] ) == false ) \
+	{ \
+		construct_fn( &this->data[ idx ] ); \
+		return false; \
+	} \
+	return true; \
+} \
+static __inline _Bool name##_insert_range( name* this, const size_t offset, const T* values, const size_t count ) \
+{ \
+	if( offset > this->size ) \
+	{ \
+		err_set_result( Result_Index_Out_Of_Range ); \
+		return false; \
+	} \
+	if( values == nullptr && count > 0 ) \
+	{ \
+		err_set_result( Result_Null_Parameter ); \
+		return false; \
+	} \
+\
+	/* values may be elements of this vector, which growing or opening the gap moves, so they are found by index */ \
+	const bool aliased = count > 0 && this->size > 0 && values >= this->data && values < this->data + this->size; \
+	const size_t source = aliased ? ( size_t )( values - this->data ) : 0; \
+	if( name##_grow_for( this, count ) == false ) \
+	{ \
+		return false; \
+	} \
+\
+	T* gap = &this->data[ offset ]; \
+	const size_t back = this->size - offset; \
+	if( back > 0 ) \
+	{ \
+		memmove( gap + count, gap, back * sizeof( T ) ); \
+	} \
+\
+	for( size_t i = 0; i < count; ++i ) \
+	{ \
+		const T* value = aliased ? &this->data[ source + i < offset ? source + i : source + i + count ] : &values[ i ]; \
+		if( copy_fn( value, &gap[ i ] ) == false ) \
+		{ \
+			for( size_t j = 0; j < i; ++j ) \
+			{ \
+				destroy_fn( &gap[ j ] ); \
+			} \
+			memmove( gap, gap + count, back * sizeof( T ) ); \
+			return false; \
+		} \
+	} \
+	this->size += count; \
+	return true; \
+} \
+static __inline _Bool name##_insert( name* this, const size_t offset, const T* value ) \
+{ \
+	return name##_insert_range( this, offset, value, 1 ); \
+} \
+\
+/* removal */ \
+static __inline _Bool name##_erase_range( name* this, const size_t first, const size_t last ) \
+{ \
+	if( first > last || last > this->size ) \
+	{ \
+		err_set_result( Result_Index_Out_Of_Range ); \
+		return false; \
+	} \
+\
+	name##_destroy_range( this, first, last ); \
+	if( last < this->size ) \
+	{ \
+		memmove( &this->data[ first ], &this->data[ last ], ( this->size - last ) * sizeof( T ) ); \
+	} \
+	this->size -= last - first; \
+	return true; \
+} \
+static __inline _Bool name##_erase( name* this, const size_t offset ) \
+{ \
+	return name##_erase_range( this, offset, offset + 1 ); \
+} \
+\
+/* utilities, other is overwritten without being destroyed */ \
+static __inline _Bool name##_copy( const name* this, name* other ) \
+{ \
+	name out; \
+	name##_construct( &out ); \
+	if( name##_reserve( &out, this->size ) == false ) \
+	{ \
+		return false; \
+	} \
+\
+	for( ; out.size < this->size; ++out.size ) \
+	{ \
+		if( copy_fn( &this->data[ out.size ], &out.data[ out.size ] ) == false ) \
+		{ \
+			name##_destroy( &out ); \
+			return false; \
+		} \
+	} \
+\
+	*other = out; \
+	return true; \
+}
@@ -0,0 +1,712 @@
+#include "wordgrid.h"
+#include "bitops.h"
+#include "customerror.h"
+#include "fastpath.h"
+#include "sync.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined( CSAPI_HAVE_SSE2 )
+#include <emmintrin.h>
+#endif
+
+// Tiles are WG_TILE bytes square, a panel of WG_PANEL columns is finished before the next one starts
+#define WG_TILE 16
+#define WG_PANEL 64
+
+// Scratch owned by one batch worker, the chunks it takes are encoded into output back to back
+typedef struct wg_batch_worker
+{
+	token_span* words;
+	size_t numWords, wordCapacity, longest;
+	size_t* rows;
+	size_t rowCapacity;
+	cstring output;
+	ResultCode failure;
+}wg_batch_worker;
+
+// Where the messages [ i * grain, ( i + 1 ) * grain ) ended up, a chunk nobody took is left empty
+typedef struct wg_batch_chunk
+{
+	size_t worker, offset, length;
+}wg_batch_chunk;
+
+// Everything a batch job needs, shared read only between the threads apart from the workers and chunks
+typedef struct wg_batch
+{
+	const string_slice* messages;
+	size_t grain;
+	delimiter_class delimiters;
+
+	// One wg_batch_worker per thread, stride bytes apart from a line aligned start so threads never write
+	// the same cache line
+	char* workers;
+	size_t stride;
+	wg_batch_chunk* chunks;
+}wg_batch;
+
+// Private forward declarations
+bool wg_encode_rows( const char* text, const size_t textLength, const token_span* words, const size_t numWords, const size_t numRows, size_t* rows, cstring* output );
+void wg_batch_job( const size_t first, const size_t last, const size_t worker, void* user );
+bool wg_batch_message( const wg_batch* batch, wg_batch_worker* worker, const string_slice* message );
+bool wg_batch_word( token_span span, void* user );
+void wg_load_words( const char* text, const size_t textLength, const token_span* words, const size_t count, const size_t row, char* tile );
+void wg_transpose_tile( const char* src, const size_t srcStride, char* dst, const size_t dstStride );
+void wg_transpose_block( const char* src, const size_t srcStride, char* dst, const size_t dstStride, const size_t rows, const size_t columns );
+size_t wg_longest( const token_span* words, const size_t count );
+size_t wg_compact( const char* src, const size_t length, char* dst );
+size_t wg_copy_word( const char* word, const size_t length, char* dst );
+bool wg_grow( cstring* output, const size_t size );
+bool wg_finish( cstring* output, const size_t start, const size_t length );
+
+
+// Public definitions
+void wg_transform( const char* text, const size_t textLength, const token_span* words, const size_t numColumns, const size_t numRows, char* grid )
+{
+	char tile[ WG_TILE * WG_TILE ];
+	char rows[ WG_TILE * WG_TILE ];
+
+	for( size_t panel = 0; panel < numColumns; panel += WG_PANEL )
+	{
+		const size_t panelWidth = numColumns - panel < WG_PANEL ? numColumns - panel : WG_PANEL;
+		const size_t longest = wg_longest( &words[ panel ], panelWidth );
+
+		size_t row = 0;
+		for( ; row < longest; row += WG_TILE )
+		{
+			const size_t height = numRows - row < WG_TILE ? numRows - row : WG_TILE;
+			for( size_t column = panel; column < panel + panelWidth; column += WG_TILE )
+			{
+				const size_t width = panel + panelWidth - column < WG_TILE ? panel + panelWidth - column : WG_TILE;
+
+				// One word per tile row, transposed into one word per grid column.  The loaded tile is
+				// padded to full size, so edge tiles only need their stores cut short.
+				wg_load_words( text, textLength, &words[ column ], width, row, tile );
+				char* dst = &grid[ row * numColumns + column ];
+				if( width == WG_TILE && height == WG_TILE )
+				{
+					wg_transpose_tile( tile, WG_TILE, dst, numColumns );
+					continue;
+				}
+
+				wg_transpose_tile( tile, WG_TILE, rows, WG_TILE );
+				for( size_t k = 0; k < height; ++k )
+				{
+					memcpy( &dst[ k * numColumns ], &rows[ k * WG_TILE ], width );
+				}
+			}
+		}
+
+		// Rows below the panel's longest word are padding only
+		for( ; row < numRows; ++row )
+		{
+			memset( &grid[ row * numColumns + panel ], 0, panelWidth );
+		}
+	}
+}
+bool wg_encode_grid( const char* grid, const size_t numColumns, const size_t numRows, cstring* output )
+{
+	const size_t start = cs_len_fast( output );
+	if( wg_grow( output, start + ( numColumns + 1 ) * numRows ) == false )
+	{
+		return false;
+	}
+
+	char* out = &cs_buffer_fast( output )[ start ];
+	size_t length = 0;
+	for( size_t row = 0; row < numRows; ++row )
+	{
+		length += wg_compact( &grid[ row * numColumns ], numColumns, &out[ length ] );
+		out[ length++ ] = ' ';
+	}
+
+	return wg_finish( output, start, length );
+}
+bool wg_encode( const char* text, const size_t textLength, const token_span* words, const size_t numWords, const size_t numRows, cstring* output )
+{
+	size_t* rows = ( size_t* )malloc( ( 2 * numRows + 1 ) * sizeof( size_t ) );
+	if( rows == nullptr )
+	{
+		err_set_result( Result_Bad_Alloc );
+		return false;
+	}
+
+	const bool result = wg_encode_rows( text, textLength, words, numWords, numRows, rows, output );
+	free( rows );
+	return result;
+}
+bool wg_decode_grid( const char* grid, const size_t numColumns, const size_t numRows, cstring* output )
+{
+	// A panel of columns is transposed into one word per scratch row, stride bytes apart.  Rounding the
+	// stride up to whole tiles lets every tile store in full and every word load in full.
+	const size_t stride = ( numRows + WG_TILE - 1 ) / WG_TILE * WG_TILE;
+	const size_t start = cs_len_fast( output );
+	bool result = true;
+
+	char* words = ( char* )malloc( WG_PANEL * stride + 1 );
+	if( words == nullptr )
+	{
+		err_set_result( Result_Bad_Alloc );
+		result = false;
+	}
+	if( result )
+	{
+		// Words are stored a tile at a time, so the last one may write a tile past the message
+		result = wg_grow( output, start + ( numRows + 1 ) * numColumns + WG_TILE );
+	}
+	if( result )
+	{
+		char* out = &cs_buffer_fast( output )[ start ];
+		char tile[ WG_TILE * WG_TILE ];
+		size_t length = 0;
+
+		for( size_t panel = 0; panel < numColumns; panel += WG_PANEL )
+		{
+			const size_t panelWidth = numColumns - panel < WG_PANEL ? numColumns - panel : WG_PANEL;
+			for( size_t row = 0; row < numRows; row += WG_TILE )
+			{
+				const size_t height = numRows - row < WG_TILE ? numRows - row : WG_TILE;
+				for( size_t column = panel; column < panel + panelWidth; column += WG_TILE )
+				{
+					const size_t width = panel + panelWidth - column < WG_TILE ? panel + panelWidth - column : WG_TILE;
+					const char* src = &grid[ row * numColumns + column ];
+					char* dst = &words[ ( column - panel ) * stride + row ];
+					if( width == WG_TILE && height == WG_TILE )
+					{
+						wg_transpose_tile( src, numColumns, dst, stride );
+						continue;
+					}
+
+					// Edge tiles are padded with '\0', which reads back as the end of the words
+					memset( tile, 0, sizeof( tile ) );
+					for( size_t k = 0; k < height; ++k )
+					{
+						memcpy( &tile[ k * WG_TILE ], &src[ k * numColumns ], width );
+					}
+					wg_transpose_tile( tile, WG_TILE, dst, stride );
+				}
+			}
+
+			for( size_t k = 0; k < panelWidth; ++k )
+			{
+				length += wg_copy_word( &words[ k * stride ], stride, &out[ length ] );
+				out[ length++ ] = ' ';
+			}
+		}
+
+		// Words are separated, not followed, by ' '
+		result = wg_finish( output, start, length > 0 ? length - 1 : 0 );
+	}
+
+	free( words );
+	return result;
+}
+bool wg_decode( const char* encoded, const size_t length, cstring* output )
+{
+	if( encoded == nullptr && length > 0 )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	// Every row ends in ' ', a last row without one is taken as it is.  The first row has a byte of every word.
+	size_t numColumns = 0, numRows = 0, previous = 0;
+	for( size_t pos = 0; pos < length; ++numRows )
+	{
+		const char* found = ( const char* )memchr( &encoded[ pos ], ' ', length - pos );
+		const size_t end = found != nullptr ? ( size_t )( found - encoded ) : length;
+		if( numRows == 0 )
+		{
+			numColumns = end - pos;
+		}
+		else if( end - pos > previous )
+		{
+			err_set_result( Result_Invalid_Parameter );
+			return false;
+		}
+
+		previous = end - pos;
+		pos = end + 1;
+	}
+
+	char* grid = ( char* )malloc( numColumns * numRows + 1 );
+	if( grid == nullptr )
+	{
+		err_set_result( Result_Bad_Alloc );
+		return false;
+	}
+
+	// Row j's bytes go to the first columns, the columns past them are the words that already ended
+	size_t pos = 0;
+	for( size_t row = 0; row < numRows; ++row )
+	{
+		const char* found = ( const char* )memchr( &encoded[ pos ], ' ', length - pos );
+		const size_t rowLength = ( found != nullptr ? ( size_t )( found - encoded ) : length ) - pos;
+		memcpy( &grid[ row * numColumns ], &encoded[ pos ], rowLength );
+		memset( &grid[ row * numColumns + rowLength ], 0, numColumns - rowLength );
+		pos += rowLength + 1;
+	}
+
+	const bool result = wg_decode_grid( grid, numColumns, numRows, output );
+	free( grid );
+	return result;
+}
+bool wg_encode_batch( threadpool* pool, const string_slice* messages, const size_t count, const size_t grain, cstring* output )
+{
+	if( pool == nullptr || output == nullptr || ( messages == nullptr && count > 0 ) )
+	{
+		err_set_result( Result_Null_Parameter );
+		return false;
+	}
+
+	const size_t threads = pool->thread_count( pool );
+	wg_batch batch = { 0 };
+	bool result = true;
+
+	batch.messages = messages;
+	batch.grain = grain == 0 ? WG_BATCH_GRAIN : grain;
+	batch.stride = ( sizeof( wg_batch_worker ) + SYNC_CACHE_LINE - 1 ) / SYNC_CACHE_LINE * SYNC_CACHE_LINE;
+	dc_whitespace( &batch.delimiters );
+
+	batch.workers = ( char* )sync_calloc_lines( threads, batch.stride );
+	batch.chunks = ( wg_batch_chunk* )calloc( count / batch.grain + 1, sizeof( wg_batch_chunk ) );
+	if( batch.workers == nullptr || batch.chunks == nullptr )
+	{
+		err_set_result( Result_Bad_Alloc );
+		result = false;
+	}
+	if( result )
+	{
+		result = pool->run( pool, count, batch.grain, wg_batch_job, &batch );
+	}
+
+	// Every worker's failure is checked before its output is used, a worker that never ran has none
+	size_t total = 0;
+	for( size_t i = 0; i < threads && result; ++i )
+	{
+		const wg_batch_worker* worker = ( const wg_batch_worker* )&batch.workers[ i * batch.stride ];
+		if( worker->failure != Result_Ok )
+		{
+			err_set_result( worker->failure );
+			result = false;
+		}
+	}
+	for( size_t i = 0; i <= count / batch.grain && result; ++i )
+	{
+		total += batch.chunks[ i ].length;
+	}
+	if( result )
+	{
+		result = cs_reserve_construct( output, total + 1 );
+	}
+	if( result )
+	{
+		// Chunks were encoded by whichever worker took them, copying them out in index order restores the input order
+		char* out = cs_buffer_fast( output );
+		for( size_t i = 0; i <= count / batch.grain; ++i )
+		{
+			const wg_batch_chunk* chunk = &batch.chunks[ i ];
+			if( chunk->length > 0 )
+			{
+				const wg_batch_worker* worker = ( const wg_batch_worker* )&batch.workers[ chunk->worker * batch.stride ];
+				memcpy( out, &cs_data_fast( &worker->output )[ chunk->offset ], chunk->length );
+				out += chunk->length;
+			}
+		}
+		result = wg_finish( output, 0, total );
+	}
+
+	for( size_t i = 0; batch.workers != nullptr && i < threads; ++i )
+	{
+		wg_batch_worker* worker = ( wg_batch_worker* )&batch.workers[ i * batch.stride ];
+		free( worker->words );
+		free( worker->rows );
+		if( worker->output._string != nullptr )
+		{
+			cs_destroy_cstring( &worker->output );
+		}
+	}
+	sync_free_lines( batch.workers );
+	free( batch.chunks );
+
+	if( result )
+	{
+		err_set_ok();
+	}
+	return result;
+}
+void wg_transpose( const char* src, const size_t srcStride, char* dst, const size_t dstStride, const size_t rows, const size_t columns )
+{
+	// A panel of source rows fills whole cache lines of the destination rows it writes
+	for( size_t panel = 0; panel < rows; panel += WG_PANEL )
+	{
+		const size_t panelHeight = rows - panel < WG_PANEL ? rows - panel : WG_PANEL;
+		for( size_t column = 0; column < columns; column += WG_TILE )
+		{
+			const size_t width = columns - column < WG_TILE ? columns - column : WG_TILE;
+			for( size_t row = panel; row < panel + panelHeight; row += WG_TILE )
+			{
+				const size_t height = panel + panelHeight - row < WG_TILE ? panel + panelHeight - row : WG_TILE;
+				wg_transpose_block( &src[ row * srcStride + column ], srcStride, &dst[ column * dstStride + row ], dstStride, height, width );
+			}
+		}
+	}
+}
+
+
+// Private definitions
+bool wg_encode_rows( const char* text, const size_t textLength, const token_span* words, const size_t numWords, const size_t numRows, size_t* rows, cstring* output )
+{
+	// rowStart[ j ] is where row j begins in out, rowEnd[ j ] where its next byte goes
+	size_t* rowStart = rows;
+	size_t* rowEnd = &rows[ numRows + 1 ];
+	char* out = nullptr;
+	const size_t start = cs_len_fast( output );
+	bool result = true;
+
+	memset( rowStart, 0, ( numRows + 1 ) * sizeof( size_t ) );
+
+	// Row j holds one byte of every word longer than j, count the words of each length first
+	for( size_t i = 0; i < numWords && result; ++i )
+	{
+		if( words[ i ].length > numRows )
+		{
+			err_set_result( Result_Invalid_Parameter );
+			result = false;
+		}
+		else
+		{
+			++rowStart[ words[ i ].length ];
+		}
+	}
+	if( result )
+	{
+		size_t longer = 0;
+		for( size_t j = numRows; j-- > 0; )
+		{
+			longer += rowStart[ j + 1 ];
+			rowEnd[ j ] = longer;
+		}
+
+		size_t offset = 0;
+		for( size_t j = 0; j < numRows; ++j )
+		{
+			rowStart[ j ] = offset;
+			offset += rowEnd[ j ] + 1;
+			rowEnd[ j ] = rowStart[ j ];
+		}
+		rowStart[ numRows ] = offset;
+
+		result = wg_grow( output, start + offset );
+	}
+	if( result )
+	{
+		out = &cs_buffer_fast( output )[ start ];
+
+		char tile[ WG_TILE * WG_TILE ];
+		char rows[ WG_TILE * WG_TILE ];
+		for( size_t panel = 0; panel < numWords; panel += WG_PANEL )
+		{
+			const size_t panelWidth = numWords - panel < WG_PANEL ? numWords - panel : WG_PANEL;
+			const size_t longest = wg_longest( &words[ panel ], panelWidth );
+
+			for( size_t row = 0; row < longest; row += WG_TILE )
+			{
+				const size_t height = longest - row < WG_TILE ? longest - row : WG_TILE;
+				for( size_t column = panel; column < panel + panelWidth; column += WG_TILE )
+				{
+					const size_t width = panel + panelWidth - column < WG_TILE ? panel + panelWidth - column : WG_TILE;
+
+					wg_load_words( text, textLength, &words[ column ], width, row, tile );
+					wg_transpose_tile( tile, WG_TILE, rows, WG_TILE );
+					for( size_t k = 0; k < height; ++k )
+					{
+						rowEnd[ row + k ] += wg_compact( &rows[ k * WG_TILE ], width, &out[ rowEnd[ row + k ] ] );
+					}
+				}
+			}
+		}
+
+		// Rows are full unless a word contained '\0', which the grid would have dropped as padding
+		size_t length = 0;
+		for( size_t j = 0; j < numRows; ++j )
+		{
+			const size_t used = rowEnd[ j ] - rowStart[ j ];
+			if( length != rowStart[ j ] )
+			{
+				memmove( &out[ length ], &out[ rowStart[ j ] ], used );
+			}
+			length += used;
+			out[ length++ ] = ' ';
+		}
+
+		result = wg_finish( output, start, length );
+	}
+
+	return result;
+}
+void wg_batch_job( const size_t first, const size_t last, const size_t worker, void* user )
+{
+	wg_batch* batch = ( wg_batch* )user;
+	wg_batch_worker* scratch = ( wg_batch_worker* )&batch->workers[ worker * batch->stride ];
+	if( scratch->failure != Result_Ok )
+	{
+		return;
+	}
+	if( scratch->output._string == nullptr && cs_default_construct( &scratch->output ) == false )
+	{
+		scratch->failure = err_get_result();
+		return;
+	}
+
+	wg_batch_chunk* chunk = &batch->chunks[ first / batch->grain ];
+	chunk->worker = worker;
+	chunk->offset = cs_len_fast( &scratch->output );
+	for( size_t i = first; i < last; ++i )
+	{
+		if( wg_batch_message( batch, scratch, &batch->messages[ i ] ) == false )
+		{
+			scratch->failure = err_get_result();
+			return;
+		}
+	}
+	chunk->length = cs_len_fast( &scratch->output ) - chunk->offset;
+}
+bool wg_batch_message( const wg_batch* batch, wg_batch_worker* worker, const string_slice* message )
+{
+	worker->numWords = 0;
+	worker->longest = 0;
+	tok_for_each( &batch->delimiters, message->data, message->length, wg_batch_word, worker );
+	if( worker->failure != Result_Ok )
+	{
+		err_set_result( worker->failure );
+		return false;
+	}
+
+	// The word and row tables only ever grow, so a worker stops allocating once it has seen its longest message
+	const size_t rowsNeeded = 2 * worker->longest + 1;
+	if( worker->rowCapacity < rowsNeeded )
+	{
+		const size_t capacity = rowsNeeded > 2 * worker->rowCapacity ? rowsNeeded : 2 * worker->rowCapacity;
+		size_t* rows = ( size_t* )realloc( worker->rows, capacity * sizeof( size_t ) );
+		if( rows == nullptr )
+		{
+			err_set_result( Result_Bad_Alloc );
+			return false;
+		}
+		worker->rows = rows;
+		worker->rowCapacity = capacity;
+	}
+
+	return wg_encode_rows( message->data, message->length, worker->words, worker->numWords, worker->longest, worker->rows, &worker->output ) &&
+		worker->output.push_back( &worker->output, '\n' );
+}
+bool wg_batch_word( token_span span, void* user )
+{
+	wg_batch_worker* worker = ( wg_batch_worker* )user;
+	if( worker->numWords == worker->wordCapacity )
+	{
+		const size_t capacity = worker->wordCapacity == 0 ? 64 : 2 * worker->wordCapacity;
+		token_span* words = ( token_span* )realloc( worker->words, capacity * sizeof( token_span ) );
+		if( words == nullptr )
+		{
+			worker->failure = Result_Bad_Alloc;
+			return false;
+		}
+		worker->words = words;
+		worker->wordCapacity = capacity;
+	}
+
+	worker->words[ worker->numWords++ ] = span;
+	worker->longest = span.length > worker->longest ? span.length : worker->longest;
+	return true;
+}
+void wg_load_words( const char* text, const size_t textLength, const token_span* words, const size_t count, const size_t row, char* tile )
+{
+#if defined( CSAPI_HAVE_SSE2 )
+	const __m128i index = _mm_setr_epi8( 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 );
+#endif
+
+	for( size_t i = 0; i < count; ++i )
+	{
+		char* dst = &tile[ i * WG_TILE ];
+		const size_t left = words[ i ].length > row ? words[ i ].length - row : 0;
+		const size_t take = left < WG_TILE ? left : WG_TILE;
+		const size_t from = words[ i ].offset + row;
+
+#if defined( CSAPI_HAVE_SSE2 )
+		// A full load is only safe while it stays inside the text, the bytes past the word are masked off
+		if( take > 0 && from + WG_TILE <= textLength )
+		{
+			const __m128i keep = _mm_cmpgt_epi8( _mm_set1_epi8( ( char )take ), index );
+			const __m128i bytes = _mm_loadu_si128( ( const __m128i* )&text[ from ] );
+			_mm_storeu_si128( ( __m128i* )dst, _mm_and_si128( bytes, keep ) );
+			continue;
+		}
+#else
+		( void )textLength;
+#endif
+		if( take > 0 )
+		{
+			memcpy( dst, &text[ from ], take );
+		}
+		memset( &dst[ take ], 0, WG_TILE - take );
+	}
+
+	memset( &tile[ count * WG_TILE ], 0, ( WG_TILE - count ) * WG_TILE );
+}
+void wg_transpose_tile( const char* src, const size_t srcStride, char* dst, const size_t dstStride )
+{
+#if defined( CSAPI_HAVE_SSE2 )
+	__m128i a[ WG_TILE ], b[ WG_TILE ];
+	for( size_t i = 0; i < WG_TILE; ++i )
+	{
+		a[ i ] = _mm_loadu_si128( ( const __m128i* )&src[ i * srcStride ] );
+	}
+
+	// Interleaving row i with row i + 8 rotates the 4 bit row and column indices by one bit, four rounds transpose
+	for( int round = 0; round < 4; ++round )
+	{
+		__m128i* in = round & 1 ? b : a;
+		__m128i* out = round & 1 ? a : b;
+		for( size_t i = 0; i < WG_TILE / 2; ++i )
+		{
+			out[ 2 * i ] = _mm_unpacklo_epi8( in[ i ], in[ i + WG_TILE / 2 ] );
+			out[ 2 * i + 1 ] = _mm_unpackhi_epi8( in[ i ], in[ i + WG_TILE / 2 ] );
+		}
+	}
+
+	for( size_t i = 0; i < WG_TILE; ++i )
+	{
+		_mm_storeu_si128( ( __m128i* )&dst[ i * dstStride ], a[ i ] );
+	}
+#else
+	for( size_t r = 0; r < WG_TILE; ++r )
+	{
+		for( size_t c = 0; c < WG_TILE; ++c )
+		{
+			dst[ c * dstStride + r ] = src[ r * srcStride + c ];
+		}
+	}
+#endif
+}
+void wg_transpose_block( const char* src, const size_t srcStride, char* dst, const size_t dstStride, const size_t rows, const size_t columns )
+{
+	if( rows == WG_TILE && columns == WG_TILE )
+	{
+		wg_transpose_tile( src, srcStride, dst, dstStride );
+		return;
+	}
+
+	// Partial tiles at the edges go through scratch tiles so nothing outside them is read or written
+	char in[ WG_TILE * WG_TILE ];
+	char out[ WG_TILE * WG_TILE ];
+	memset( in, 0, sizeof( in ) );
+	for( size_t r = 0; r < rows; ++r )
+	{
+		memcpy( &in[ r * WG_TILE ], &src[ r * srcStride ], columns );
+	}
+
+	wg_transpose_tile( in, WG_TILE, out, WG_TILE );
+	for( size_t c = 0; c < columns; ++c )
+	{
+		memcpy( &dst[ c * dstStride ], &out[ c * WG_TILE ], rows );
+	}
+}
+size_t wg_longest( const token_span* words, const size_t count )
+{
+	size_t longest = 0;
+	for( size_t i = 0; i < count; ++i )
+	{
+		longest = words[ i ].length > longest ? words[ i ].length : longest;
+	}
+	return longest;
+}
+size_t wg_compact( const char* src, const size_t length, char* dst )
+{
+	size_t count = 0;
+	size_t i = 0;
+
+#if defined( CSAPI_HAVE_SSE2 )
+	const __m128i zero = _mm_setzero_si128();
+	for( ; i + WG_TILE <= length; i += WG_TILE )
+	{
+		const __m128i bytes = _mm_loadu_si128( ( const __m128i* )&src[ i ] );
+		const int padding = _mm_movemask_epi8( _mm_cmpeq_epi8( bytes, zero ) );
+		if( padding == 0 )
+		{
+			_mm_storeu_si128( ( __m128i* )&dst[ count ], bytes );
+			count += WG_TILE;
+		}
+		else if( padding != 0xFFFF )
+		{
+			for( size_t k = 0; k < WG_TILE; ++k )
+			{
+				dst[ count ] = src[ i + k ];
+				count += src[ i + k ] != '\0';
+			}
+		}
+	}
+#endif
+	// Every byte is stored and only kept when it is not padding, which avoids a mispredicted branch per byte.
+	// The one byte this can write past the kept ones is the ' ' that always follows a row.
+	for( ; i < length; ++i )
+	{
+		dst[ count ] = src[ i ];
+		count += src[ i ] != '\0';
+	}
+
+	return count;
+}
+size_t wg_copy_word( const char* word, const size_t length, char* dst )
+{
+#if defined( CSAPI_HAVE_SSE2 )
+	// A word is a run of bytes followed by padding, so each tile of it is usually stored whole and cut at the
+	// first '\0'.  length is whole tiles and dst has a tile of room past the word.
+	const __m128i zero = _mm_setzero_si128();
+	size_t count = 0;
+	for( size_t i = 0; i < length; i += WG_TILE )
+	{
+		const __m128i bytes = _mm_loadu_si128( ( const __m128i* )&word[ i ] );
+		const unsigned padding = ( unsigned )_mm_movemask_epi8( _mm_cmpeq_epi8( bytes, zero ) );
+		const unsigned kept = padding == 0 ? WG_TILE : bit_ctz64( padding );
+		if( ( padding >> kept ) != ( 0xFFFFu >> kept ) )
+		{
+			// A '\0' inside the word, which the grid drops like padding
+			count += wg_compact( &word[ i ], WG_TILE, &dst[ count ] );
+			continue;
+		}
+
+		_mm_storeu_si128( ( __m128i* )&dst[ count ], bytes );
+		count += kept;
+	}
+	return count;
+#else
+	return wg_compact( word, length, dst );
+#endif
+}
+bool wg_grow( cstring* output, const size_t size )
+{
+	// resize alone grows to exactly the size asked for, which makes appending many messages to one string quadratic
+	const size_t capacity = output->_string->capacity;
+	if( size + 1 > capacity )
+	{
+		const size_t grown = ( ( capacity * 3 ) / 2 ) + 3;
+		if( output->reserve( output, size + 1 > grown ? size + 1 : grown ) == false )
+		{
+			return false;
+		}
+	}
+	return output->resize( output, size );
+}
+bool wg_finish( cstring* output, const size_t start, const size_t length )
+{
+	if( output->resize( output, start + length ) == false )
+	{
+		return false;
+	}
+
+	cs_buffer_fast( output )[ start + length ] = '\0';
+	err_set_ok();
+	return true;
+}
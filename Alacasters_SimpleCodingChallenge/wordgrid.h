@@ -0,0 +1,41 @@
+#pragma once
+
+#include "cstring.h"
+#include "defines.h"
+#include "threadpool.h"
+#include "tokenizer.h"
+#include <stddef.h>
+
+// Word grid cipher.  Word i of a message goes down column i of a grid with one column per word and one
+// row per character of the longest word, rows are numColumns bytes apart and '\0' pads below short words.
+// The encoded message is the grid read row by row with the padding dropped and a ' ' after every row.
+//
+// The grid is built and read in 16 by 16 tiles that are transposed in registers where SSE2 is available,
+// walking 64 columns at a time so the rows a tile writes stay in cache until the neighbouring tiles
+// have filled them.  words are spans into text, which must be readable for textLength bytes.
+
+// Fills the numColumns by numRows grid, words must be at most numRows long
+void wg_transform( const char* text, const size_t textLength, const token_span* words, const size_t numColumns, const size_t numRows, char* grid );
+// Appends the encoded grid to output
+_Bool wg_encode_grid( const char* grid, const size_t numColumns, const size_t numRows, cstring* output );
+// Appends the encoded words to output the way wg_transform followed by wg_encode_grid would, without the grid
+_Bool wg_encode( const char* text, const size_t textLength, const token_span* words, const size_t numWords, const size_t numRows, cstring* output );
+
+// Appends the message the grid holds, its columns read as words separated by ' '.  The inverse of wg_transform.
+_Bool wg_decode_grid( const char* grid, const size_t numColumns, const size_t numRows, cstring* output );
+// Appends a message that encodes to encoded.  The encoding does not keep which words a row's bytes came from,
+// so row j is taken to hold byte j of the first words, one per byte of the row.  That is the original
+// message whenever no word is longer than the one before it, and a message with the same encoding otherwise.
+// Fails with Result_Invalid_Parameter when a row is longer than the row before it, which no encoding has.
+_Bool wg_decode( const char* encoded, const size_t length, cstring* output );
+
+// Messages a wg_encode_batch job encodes when the caller passes a grain of 0
+#define WG_BATCH_GRAIN 256
+
+// Encodes count independent messages on pool, each split into words at whitespace the way the encrypter
+// splits its input.  Every worker keeps its own word and row tables and output buffer, output is then
+// replaced with the encoded messages in input order, each one followed by '\n'.
+_Bool wg_encode_batch( threadpool* pool, const string_slice* messages, const size_t count, const size_t grain, cstring* output );
+
+// dst[ c * dstStride + r ] = src[ r * srcStride + c ] for rows by columns bytes
+void wg_transpose( const char* src, const size_t srcStride, char* dst, const size_t dstStride, const size_t rows, const size_t columns );
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <stddef.h>
+
+// Interface between the benchmark driver and the case tables.  The library headers only compile as C,
+// so the csapi cases live in bench_csapi.c and the driver and standard library baselines in C++.
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// How many items one call of run processes, for the throughput column
+typedef enum
+{
+	BENCH_ITEMS_PER_ELEMENT = 0,	// size items, one per character or element
+	BENCH_ITEMS_PER_CALL = 1,		// a single item whatever the size
+	BENCH_BYTES_PER_ELEMENT = 2		// size items that are bytes of a message, reported as MB/s as well
+}bench_items;
+
+// One measured operation on data of size characters or elements.  setup builds the state outside the
+// timed region and run performs the operation once.  run must leave the state ready to run again,
+// the driver calls it many times per sample.
+typedef struct bench_case
+{
+	const char* group;
+	const char* name;
+	bench_items items;
+	void*( *setup )( const size_t size );
+	void( *run )( void* state );
+	void( *teardown )( void* state );
+}bench_case;
+
+// Both tables list the same group and name pairs, the driver matches them by name
+extern const bench_case bench_csapi_cases[];
+extern const size_t bench_csapi_case_count;
+extern const bench_case bench_std_cases[];
+extern const size_t bench_std_case_count;
+
+// Keeps results observable so the optimizer cannot drop the work that produced them
+void bench_consume( const size_t value );
+
+// Deterministic text of size bytes plus a null terminator, words of 1 to 8 lowercase letters separated by single spaces
+void bench_fill_words( char* text, const size_t size );
+// Copies the words of text into buffer as null terminated strings that keep their trailing space.
+// buffer needs size + size / 2 + 2 bytes and words size / 2 + 1 entries, returns the word count.
+size_t bench_split_words( const char* text, const size_t size, char* buffer, const char** words );
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,504 @@
+#include "bench.h"
+#include "cstring.h"
+#include "defines.h"
+#include "fastpath.h"
+#include "stringstream.h"
+#include "tokenizer.h"
+#include "utility.h"
+#include "wordgrid.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_SEEK_POSITIONS 256
+
+typedef struct bench_cs_state
+{
+	size_t size;
+	char* text;
+	// text with a '#' in the last position, so find scans every byte
+	cstring str;
+}bench_cs_state;
+
+typedef struct bench_ss_state
+{
+	size_t size;
+	char* text;
+	char* wordBuffer;
+	const char** words;
+	size_t wordCount;
+	// Holds text, extract and seek rewind it instead of rebuilding it
+	stringstream ss;
+	size_t positions[ BENCH_SEEK_POSITIONS ];
+	size_t cursor;
+}bench_ss_state;
+
+typedef struct bench_cont_state
+{
+	size_t size;
+	// size uint64_t elements with the trivial hooks
+	container cont;
+	uint64_t value;
+}bench_cont_state;
+
+typedef struct bench_wg_state
+{
+	size_t size;
+	// text as one message of numWords words, the grid is numWords by numRows
+	char* text;
+	token_span* words;
+	size_t numWords;
+	size_t numRows;
+	char* grid;
+	cstring output;
+	// Only built by bench_wg_codec_setup, text encoded and a buffer to decode into
+	cstring encoded;
+	cstring decoded;
+}bench_wg_state;
+
+
+// cstring
+void* bench_cs_setup( const size_t size )
+{
+	bench_cs_state* state = ( bench_cs_state* )calloc( 1, sizeof( bench_cs_state ) );
+	bool result = state != nullptr;
+	if( result )
+	{
+		state->size = size;
+		state->text = ( char* )malloc( size + 1 );
+		result = state->text != nullptr;
+	}
+	if( result )
+	{
+		bench_fill_words( state->text, size );
+		result = cs_buffer_construct( &state->str, state->text, size );
+	}
+	if( result )
+	{
+		state->str.at_set( &state->str, size - 1, '#' );
+		return state;
+	}
+
+	if( state != nullptr )
+	{
+		free( state->text );
+		free( state );
+	}
+	return nullptr;
+}
+void bench_cs_teardown( void* user )
+{
+	bench_cs_state* state = ( bench_cs_state* )user;
+	cs_destroy_cstring( &state->str );
+	free( state->text );
+	free( state );
+}
+void bench_cs_construct( void* user )
+{
+	const bench_cs_state* state = ( const bench_cs_state* )user;
+	cstring str = { 0 };
+	cs_buffer_construct( &str, state->text, state->size );
+	bench_consume( str.size( &str ) );
+	cs_destroy_cstring( &str );
+}
+void bench_cs_push_back( void* user )
+{
+	const bench_cs_state* state = ( const bench_cs_state* )user;
+	cstring str = { 0 };
+	cs_default_construct( &str );
+	for( size_t i = 0; i < state->size; ++i )
+	{
+		str.push_back( &str, state->text[ i ] );
+	}
+	bench_consume( str.size( &str ) );
+	cs_destroy_cstring( &str );
+}
+void bench_cs_insert( void* user )
+{
+	// 16 bytes into the middle, then cut back to size so every run starts from the same length
+	bench_cs_state* state = ( bench_cs_state* )user;
+	state->str.insert_string( &state->str, state->size / 2, "0123456789abcdef" );
+	state->str.resize( &state->str, state->size );
+	bench_consume( state->str.size( &state->str ) );
+}
+void bench_cs_find( void* user )
+{
+	const bench_cs_state* state = ( const bench_cs_state* )user;
+	size_t foundAt = 0;
+	state->str.find( &state->str, 0, '#', &foundAt );
+	bench_consume( foundAt );
+}
+void bench_cs_copy( void* user )
+{
+	const bench_cs_state* state = ( const bench_cs_state* )user;
+	cstring copy = { 0 };
+	state->str.copy( &state->str, &copy );
+	bench_consume( copy.size( &copy ) );
+	cs_destroy_cstring( &copy );
+}
+
+
+// stringstream
+void* bench_ss_setup( const size_t size )
+{
+	bench_ss_state* state = ( bench_ss_state* )calloc( 1, sizeof( bench_ss_state ) );
+	bool result = state != nullptr;
+	if( result )
+	{
+		state->size = size;
+		state->text = ( char* )malloc( size + 1 );
+		state->wordBuffer = ( char* )malloc( size + size / 2 + 2 );
+		state->words = ( const char** )malloc( ( size / 2 + 1 ) * sizeof( const char* ) );
+		result = state->text != nullptr && state->wordBuffer != nullptr && state->words != nullptr;
+	}
+	if( result )
+	{
+		bench_fill_words( state->text, size );
+		state->wordCount = bench_split_words( state->text, size, state->wordBuffer, state->words );
+		result = ss_construct( &state->ss ) && state->ss.insert( state->ss, state->text );
+	}
+	if( result )
+	{
+		uint32_t seed = 2463534242u;
+		for( size_t i = 0; i < BENCH_SEEK_POSITIONS; ++i )
+		{
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			state->positions[ i ] = seed % size;
+		}
+		return state;
+	}
+
+	if( state != nullptr )
+	{
+		if( state->ss.stream != nullptr )
+		{
+			ss_destroy( &state->ss );
+		}
+		free( state->text );
+		free( state->wordBuffer );
+		free( ( void* )state->words );
+		free( state );
+	}
+	return nullptr;
+}
+void bench_ss_teardown( void* user )
+{
+	bench_ss_state* state = ( bench_ss_state* )user;
+	ss_destroy( &state->ss );
+	free( state->text );
+	free( state->wordBuffer );
+	free( ( void* )state->words );
+	free( state );
+}
+void bench_ss_insert( void* user )
+{
+	const bench_ss_state* state = ( const bench_ss_state* )user;
+	stringstream ss = { 0 };
+	ss_construct( &ss );
+	for( size_t i = 0; i < state->wordCount; ++i )
+	{
+		ss.insert( ss, state->words[ i ] );
+	}
+	bench_consume( ss.tellp( ss ) );
+	ss_destroy( &ss );
+}
+void bench_ss_extract( void* user )
+{
+	bench_ss_state* state = ( bench_ss_state* )user;
+	cstring word = { 0 };
+	size_t count = 0;
+
+	state->ss.seekg( state->ss, 0, SS_SEEK_BEG );
+	while( state->ss.extract( state->ss, &word ) )
+	{
+		++count;
+	}
+	cs_destroy_cstring( &word );
+	bench_consume( count );
+}
+void bench_ss_seek( void* user )
+{
+	bench_ss_state* state = ( bench_ss_state* )user;
+	const size_t pos = state->positions[ state->cursor++ % BENCH_SEEK_POSITIONS ];
+	char c = 0;
+
+	state->ss.seekg( state->ss, ( int )pos, SS_SEEK_BEG );
+	state->ss.getchar( state->ss, &c );
+	bench_consume( ( size_t )c );
+}
+
+
+// container
+void* bench_cont_setup( const size_t size )
+{
+	bench_cont_state* state = ( bench_cont_state* )calloc( 1, sizeof( bench_cont_state ) );
+	bool result = state != nullptr;
+	if( result )
+	{
+		state->size = size;
+		state->value = 0x9e3779b97f4a7c15ull;
+		result = cont_reserve_construct( &state->cont, size, sizeof( uint64_t ), nullptr, nullptr, nullptr, nullptr );
+	}
+	for( uint64_t i = 0; result && i < size; ++i )
+	{
+		result = state->cont.push_back( &state->cont, &i );
+	}
+	if( result )
+	{
+		return state;
+	}
+
+	if( state != nullptr )
+	{
+		if( state->cont.pdata != nullptr )
+		{
+			cont_destroy( &state->cont );
+		}
+		free( state );
+	}
+	return nullptr;
+}
+void bench_cont_teardown( void* user )
+{
+	bench_cont_state* state = ( bench_cont_state* )user;
+	cont_destroy( &state->cont );
+	free( state );
+}
+void bench_cont_push_back( void* user )
+{
+	const bench_cont_state* state = ( const bench_cont_state* )user;
+	container cont = { 0 };
+	cont_default_construct( &cont, sizeof( uint64_t ), nullptr, nullptr, nullptr, nullptr );
+	for( uint64_t i = 0; i < state->size; ++i )
+	{
+		cont.push_back( &cont, &i );
+	}
+	bench_consume( cont.size( &cont ) );
+	cont_destroy( &cont );
+}
+void bench_cont_reserve( void* user )
+{
+	const bench_cont_state* state = ( const bench_cont_state* )user;
+	container cont = { 0 };
+	cont_default_construct( &cont, sizeof( uint64_t ), nullptr, nullptr, nullptr, nullptr );
+	cont.reserve( &cont, state->size );
+	for( uint64_t i = 0; i < state->size; ++i )
+	{
+		cont.push_back( &cont, &i );
+	}
+	bench_consume( cont.size( &cont ) );
+	cont_destroy( &cont );
+}
+void bench_cont_insert( void* user )
+{
+	bench_cont_state* state = ( bench_cont_state* )user;
+	state->cont.insert( &state->cont, state->size / 2, &state->value );
+	state->cont.pop_back( &state->cont );
+	bench_consume( state->cont.size( &state->cont ) );
+}
+void bench_cont_copy( void* user )
+{
+	const bench_cont_state* state = ( const bench_cont_state* )user;
+	container copy = { 0 };
+	state->cont.copy( &state->cont, &copy );
+	bench_consume( copy.size( &copy ) );
+	cont_destroy( &copy );
+}
+
+
+
+
+// word grid
+void* bench_wg_setup( const size_t size )
+{
+	bench_wg_state* state = ( bench_wg_state* )calloc( 1, sizeof( bench_wg_state ) );
+	bool result = state != nullptr;
+	if( result )
+	{
+		state->size = size;
+		state->text = ( char* )malloc( size + 1 );
+		state->words = ( token_span* )malloc( ( size / 2 + 1 ) * sizeof( token_span ) );
+		result = state->text != nullptr && state->words != nullptr;
+	}
+	if( result )
+	{
+		delimiter_class delims;
+		dc_whitespace( &delims );
+		bench_fill_words( state->text, size );
+
+		size_t pos = 0;
+		token_span span = { 0 };
+		while( tok_next( &delims, state->text, size, &pos, &span ) )
+		{
+			state->numRows = span.length > state->numRows ? span.length : state->numRows;
+			state->words[ state->numWords++ ] = span;
+		}
+
+		state->grid = ( char* )malloc( state->numWords * state->numRows + 1 );
+		result = state->grid != nullptr;
+	}
+	if( result )
+	{
+		result = cs_reserve_construct( &state->output, ( state->numWords + 1 ) * state->numRows + 1 );
+	}
+	if( result )
+	{
+		return state;
+	}
+
+	if( state != nullptr )
+	{
+		free( state->text );
+		free( state->words );
+		free( state->grid );
+		free( state );
+	}
+	return nullptr;
+}
+void bench_wg_teardown( void* user )
+{
+	bench_wg_state* state = ( bench_wg_state* )user;
+	if( state->encoded._string != nullptr )
+	{
+		cs_destroy_cstring( &state->encoded );
+	}
+	if( state->decoded._string != nullptr )
+	{
+		cs_destroy_cstring( &state->decoded );
+	}
+	cs_destroy_cstring( &state->output );
+	free( state->text );
+	free( state->words );
+	free( state->grid );
+	free( state );
+}
+void* bench_wg_codec_setup( const size_t size )
+{
+	bench_wg_state* state = ( bench_wg_state* )bench_wg_setup( size );
+	bool result = state != nullptr;
+	if( result )
+	{
+		wg_transform( state->text, state->size, state->words, state->numWords, state->numRows, state->grid );
+		result = cs_default_construct( &state->encoded ) && cs_default_construct( &state->decoded );
+	}
+	if( result )
+	{
+		result = wg_encode( state->text, state->size, state->words, state->numWords, state->numRows, &state->encoded );
+	}
+
+	// Both directions have to give back what went in before they are timed.  The grid decodes to the
+	// words of text with single spaces, text without its trailing space.
+	if( result )
+	{
+		const size_t length = state->size > 0 && state->text[ state->size - 1 ] == ' ' ? state->size - 1 : state->size;
+		result = wg_decode_grid( state->grid, state->numWords, state->numRows, &state->decoded ) &&
+			cs_len_fast( &state->decoded ) == length && memcmp( cs_data_fast( &state->decoded ), state->text, length ) == 0;
+	}
+	if( result )
+	{
+		// Decoding the rows may reorder the words, but it has to encode to the same rows again
+		delimiter_class delims;
+		dc_whitespace( &delims );
+		state->decoded.resize( &state->decoded, 0 );
+		result = wg_decode( cs_data_fast( &state->encoded ), cs_len_fast( &state->encoded ), &state->decoded );
+
+		token_span* words = ( token_span* )malloc( ( state->numWords + 1 ) * sizeof( token_span ) );
+		size_t pos = 0, numWords = 0, numRows = 0;
+		token_span span = { 0 };
+		result = result && words != nullptr;
+		while( result && numWords <= state->numWords &&
+			tok_next( &delims, cs_data_fast( &state->decoded ), cs_len_fast( &state->decoded ), &pos, &span ) )
+		{
+			numRows = span.length > numRows ? span.length : numRows;
+			words[ numWords++ ] = span;
+		}
+
+		state->output.resize( &state->output, 0 );
+		result = result && numWords == state->numWords &&
+			wg_encode( cs_data_fast( &state->decoded ), cs_len_fast( &state->decoded ), words, numWords, numRows, &state->output ) &&
+			cs_len_fast( &state->output ) == cs_len_fast( &state->encoded ) &&
+			memcmp( cs_data_fast( &state->output ), cs_data_fast( &state->encoded ), cs_len_fast( &state->output ) ) == 0;
+		free( words );
+	}
+	if( result )
+	{
+		return state;
+	}
+
+	if( state != nullptr )
+	{
+		bench_wg_teardown( state );
+	}
+	return nullptr;
+}
+void bench_wg_transform( void* user )
+{
+	bench_wg_state* state = ( bench_wg_state* )user;
+	wg_transform( state->text, state->size, state->words, state->numWords, state->numRows, state->grid );
+	bench_consume( ( size_t )state->grid[ 0 ] );
+}
+void bench_wg_encode( void* user )
+{
+	// Through the grid, as when the grid is printed as well
+	bench_wg_state* state = ( bench_wg_state* )user;
+	wg_transform( state->text, state->size, state->words, state->numWords, state->numRows, state->grid );
+	state->output.resize( &state->output, 0 );
+	wg_encode_grid( state->grid, state->numWords, state->numRows, &state->output );
+	bench_consume( state->output.size( &state->output ) );
+}
+void bench_wg_encode_fused( void* user )
+{
+	bench_wg_state* state = ( bench_wg_state* )user;
+	state->output.resize( &state->output, 0 );
+	wg_encode( state->text, state->size, state->words, state->numWords, state->numRows, &state->output );
+	bench_consume( state->output.size( &state->output ) );
+}
+void bench_wg_decode_grid( void* user )
+{
+	bench_wg_state* state = ( bench_wg_state* )user;
+	state->decoded.resize( &state->decoded, 0 );
+	wg_decode_grid( state->grid, state->numWords, state->numRows, &state->decoded );
+	bench_consume( state->decoded.size( &state->decoded ) );
+}
+void bench_wg_decode( void* user )
+{
+	bench_wg_state* state = ( bench_wg_state* )user;
+	state->decoded.resize( &state->decoded, 0 );
+	wg_decode( cs_data_fast( &state->encoded ), cs_len_fast( &state->encoded ), &state->decoded );
+	bench_consume( state->decoded.size( &state->decoded ) );
+}
+void bench_wg_roundtrip( void* user )
+{
+	bench_wg_state* state = ( bench_wg_state* )user;
+	state->output.resize( &state->output, 0 );
+	state->decoded.resize( &state->decoded, 0 );
+	wg_encode( state->text, state->size, state->words, state->numWords, state->numRows, &state->output );
+	wg_decode( cs_data_fast( &state->output ), cs_len_fast( &state->output ), &state->decoded );
+	bench_consume( state->decoded.size( &state->decoded ) );
+}
+
+
+const bench_case bench_csapi_cases[] =
+{
+	{ "cstring", "construct", BENCH_ITEMS_PER_ELEMENT, bench_cs_setup, bench_cs_construct, bench_cs_teardown },
+	{ "cstring", "push_back", BENCH_ITEMS_PER_ELEMENT, bench_cs_setup, bench_cs_push_back, bench_cs_teardown },
+	{ "cstring", "insert", BENCH_ITEMS_PER_CALL, bench_cs_setup, bench_cs_insert, bench_cs_teardown },
+	{ "cstring", "find", BENCH_ITEMS_PER_ELEMENT, bench_cs_setup, bench_cs_find, bench_cs_teardown },
+	{ "cstring", "copy", BENCH_ITEMS_PER_ELEMENT, bench_cs_setup, bench_cs_copy, bench_cs_teardown },
+	{ "stringstream", "insert", BENCH_ITEMS_PER_ELEMENT, bench_ss_setup, bench_ss_insert, bench_ss_teardown },
+	{ "stringstream", "extract", BENCH_ITEMS_PER_ELEMENT, bench_ss_setup, bench_ss_extract, bench_ss_teardown },
+	{ "stringstream", "seek", BENCH_ITEMS_PER_CALL, bench_ss_setup, bench_ss_seek, bench_ss_teardown },
+	{ "container", "push_back", BENCH_ITEMS_PER_ELEMENT, bench_cont_setup, bench_cont_push_back, bench_cont_teardown },
+	{ "container", "reserve", BENCH_ITEMS_PER_ELEMENT, bench_cont_setup, bench_cont_reserve, bench_cont_teardown },
+	{ "container", "insert", BENCH_ITEMS_PER_CALL, bench_cont_setup, bench_cont_insert, bench_cont_teardown },
+	{ "container", "copy", BENCH_ITEMS_PER_ELEMENT, bench_cont_setup, bench_cont_copy, bench_cont_teardown },
+	{ "wordgrid", "transform", BENCH_BYTES_PER_ELEMENT, bench_wg_setup, bench_wg_transform, bench_wg_teardown },
+	{ "wordgrid", "encode", BENCH_BYTES_PER_ELEMENT, bench_wg_setup, bench_wg_encode, bench_wg_teardown },
+	{ "wordgrid", "encode_fused", BENCH_BYTES_PER_ELEMENT, bench_wg_setup, bench_wg_encode_fused, bench_wg_teardown },
+	{ "wordgrid", "decode_grid", BENCH_BYTES_PER_ELEMENT, bench_wg_codec_setup, bench_wg_decode_grid, bench_wg_teardown },
+	{ "wordgrid", "decode", BENCH_BYTES_PER_ELEMENT, bench_wg_codec_setup, bench_wg_decode, bench_wg_teardown },
+	{ "wordgrid", "roundtrip", BENCH_BYTES_PER_ELEMENT, bench_wg_codec_setup, bench_wg_roundtrip, bench_wg_teardown },
+};
+const size_t bench_csapi_case_count = sizeof( bench_csapi_cases ) / sizeof( bench_csapi_cases[ 0 ] );
@@ -0,0 +1,382 @@
+#include "bench.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Runs every case of bench_csapi.c next to its bench_std.cpp baseline at each size.
+//
+// A sample times reps back to back calls of run and records the mean nanoseconds per call, reps is
+// calibrated per case and size so a sample lasts at least --min-sample-us.  The percentiles are over
+// those samples, so they describe how steady the per call cost is rather than single call outliers.
+// Throughput is items per second at the mean, see bench_items, and MB/s for cases that count bytes.
+//
+//	csapi_bench [--sizes=16,256,4096,65536] [--samples=50] [--min-sample-us=200]
+//	            [--filter=text] [--format=text|csv|json]
+
+extern "C"
+{
+	volatile size_t bench_sink = 0;
+
+	void bench_consume( const size_t value )
+	{
+		bench_sink = bench_sink + value;
+	}
+	void bench_fill_words( char* text, const size_t size )
+	{
+		uint32_t seed = 88172645u;
+		size_t i = 0;
+		while( i < size )
+		{
+			seed ^= seed << 13;
+			seed ^= seed >> 17;
+			seed ^= seed << 5;
+			const size_t length = 1 + seed % 8;
+
+			for( size_t j = 0; j < length && i < size; ++j )
+			{
+				seed ^= seed << 13;
+				seed ^= seed >> 17;
+				seed ^= seed << 5;
+				text[ i++ ] = static_cast< char >( 'a' + seed % 26 );
+			}
+			if( i < size )
+			{
+				text[ i++ ] = ' ';
+			}
+		}
+		text[ size ] = '\0';
+	}
+	size_t bench_split_words( const char* text, const size_t size, char* buffer, const char** words )
+	{
+		size_t count = 0;
+		size_t i = 0;
+		while( i < size )
+		{
+			words[ count++ ] = buffer;
+			while( i < size && text[ i ] != ' ' )
+			{
+				*buffer++ = text[ i++ ];
+			}
+			while( i < size && text[ i ] == ' ' )
+			{
+				*buffer++ = text[ i++ ];
+			}
+			*buffer++ = '\0';
+		}
+		return count;
+	}
+}
+
+namespace
+{
+	enum class output_format
+	{
+		text,
+		csv,
+		json
+	};
+
+	struct options
+	{
+		std::vector< size_t > sizes = { 16, 256, 4096, 65536 };
+		size_t samples = 50;
+		double minSampleNs = 200000.0;
+		std::string filter;
+		output_format format = output_format::text;
+	};
+
+	struct measurement
+	{
+		const char* group;
+		const char* name;
+		const char* impl;
+		size_t size;
+		size_t samples;
+		size_t reps;
+		double p50, p90, p99, min, mean;
+		double itemsPerSec;
+		// 0 unless the case counts bytes
+		double megabytesPerSec;
+		bool ok;
+	};
+
+	// Calls run reps times and returns the elapsed nanoseconds
+	double time_runs( const bench_case& test, void* state, const size_t reps )
+	{
+		const auto start = std::chrono::steady_clock::now();
+		for( size_t i = 0; i < reps; ++i )
+		{
+			test.run( state );
+		}
+		const auto stop = std::chrono::steady_clock::now();
+		return std::chrono::duration< double, std::nano >( stop - start ).count();
+	}
+
+	// Nearest rank percentile of sorted values
+	double percentile( const std::vector< double >& sorted, const double p )
+	{
+		const size_t rank = static_cast< size_t >( std::ceil( p * static_cast< double >( sorted.size() ) ) );
+		return sorted[ rank > 0 ? rank - 1 : 0 ];
+	}
+
+	measurement measure( const bench_case& test, const char* impl, const size_t size, const options& opts )
+	{
+		measurement m = {};
+		m.group = test.group;
+		m.name = test.name;
+		m.impl = impl;
+		m.size = size;
+
+		void* state = test.setup( size );
+		if( state == nullptr )
+		{
+			return m;
+		}
+
+		// Warm the caches and the allocator, then double reps until a sample is long enough to time
+		test.run( state );
+		size_t reps = 1;
+		while( reps < ( size_t( 1 ) << 24 ) && time_runs( test, state, reps ) < opts.minSampleNs )
+		{
+			reps *= 2;
+		}
+
+		std::vector< double > perCall( opts.samples );
+		double total = 0.0;
+		for( size_t i = 0; i < opts.samples; ++i )
+		{
+			perCall[ i ] = time_runs( test, state, reps ) / static_cast< double >( reps );
+			total += perCall[ i ];
+		}
+		test.teardown( state );
+
+		std::sort( perCall.begin(), perCall.end() );
+		m.samples = opts.samples;
+		m.reps = reps;
+		m.p50 = percentile( perCall, 0.50 );
+		m.p90 = percentile( perCall, 0.90 );
+		m.p99 = percentile( perCall, 0.99 );
+		m.min = perCall.front();
+		m.mean = total / static_cast< double >( opts.samples );
+
+		const double items = test.items != BENCH_ITEMS_PER_CALL ? static_cast< double >( size ) : 1.0;
+		m.itemsPerSec = m.mean > 0.0 ? items * 1e9 / m.mean : 0.0;
+		m.megabytesPerSec = test.items == BENCH_BYTES_PER_ELEMENT ? m.itemsPerSec / 1e6 : 0.0;
+		m.ok = true;
+		return m;
+	}
+
+	const bench_case* find_case( const bench_case* cases, const size_t count, const bench_case& match )
+	{
+		for( size_t i = 0; i < count; ++i )
+		{
+			if( std::strcmp( cases[ i ].group, match.group ) == 0 && std::strcmp( cases[ i ].name, match.name ) == 0 )
+			{
+				return &cases[ i ];
+			}
+		}
+		return nullptr;
+	}
+
+	bool parse_sizes( const char* text, std::vector< size_t >& sizes )
+	{
+		sizes.clear();
+		while( *text != '\0' )
+		{
+			char* end = nullptr;
+			const unsigned long long value = std::strtoull( text, &end, 10 );
+			if( end == text || value == 0 || ( *end != ',' && *end != '\0' ) )
+			{
+				return false;
+			}
+			sizes.push_back( static_cast< size_t >( value ) );
+			text = *end == ',' ? end + 1 : end;
+		}
+		return sizes.empty() == false;
+	}
+
+	bool parse_options( const int argc, char** argv, options& opts )
+	{
+		for( int i = 1; i < argc; ++i )
+		{
+			const char* arg = argv[ i ];
+			const char* value = std::strchr( arg, '=' );
+			const std::string key = value != nullptr ? std::string( arg, value - arg ) : std::string( arg );
+			value = value != nullptr ? value + 1 : "";
+
+			if( key == "--sizes" )
+			{
+				if( parse_sizes( value, opts.sizes ) == false )
+				{
+					return false;
+				}
+			}
+			else if( key == "--samples" )
+			{
+				opts.samples = static_cast< size_t >( std::strtoull( value, nullptr, 10 ) );
+				if( opts.samples == 0 )
+				{
+					return false;
+				}
+			}
+			else if( key == "--min-sample-us" )
+			{
+				opts.minSampleNs = std::strtod( value, nullptr ) * 1000.0;
+			}
+			else if( key == "--filter" )
+			{
+				opts.filter = value;
+			}
+			else if( key == "--format" )
+			{
+				const std::string format = value;
+				if( format == "text" )
+				{
+					opts.format = output_format::text;
+				}
+				else if( format == "csv" )
+				{
+					opts.format = output_format::csv;
+				}
+				else if( format == "json" )
+				{
+					opts.format = output_format::json;
+				}
+				else
+				{
+					return false;
+				}
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void print_header( const options& opts )
+	{
+		switch( opts.format )
+		{
+		case output_format::text:
+			std::printf( "%-13s %-10s %-6s %9s %9s %12s %12s %12s %14s %10s %8s\n",
+				"group", "op", "impl", "size", "reps", "p50 ns", "p90 ns", "p99 ns", "items/s", "MB/s", "vs std" );
+			break;
+		case output_format::csv:
+			std::printf( "group,op,impl,size,samples,reps,p50_ns,p90_ns,p99_ns,min_ns,mean_ns,items_per_sec,mb_per_sec\n" );
+			break;
+		case output_format::json:
+			std::printf( "{\n  \"unit\": \"ns_per_call\",\n  \"results\": [" );
+			break;
+		}
+	}
+
+	// baseline is the std measurement for a csapi row and nullptr otherwise
+	void print_row( const measurement& m, const measurement* baseline, const options& opts, const bool first )
+	{
+		// Left out, rather than printed as 0, for cases that do not count bytes
+		char megabytes[ 32 ] = "";
+		if( m.megabytesPerSec > 0.0 )
+		{
+			std::snprintf( megabytes, sizeof( megabytes ), "%.1f", m.megabytesPerSec );
+		}
+
+		switch( opts.format )
+		{
+		case output_format::text:
+			if( m.ok == false )
+			{
+				std::printf( "%-13s %-10s %-6s %9zu   setup failed\n", m.group, m.name, m.impl, m.size );
+			}
+			else if( baseline != nullptr && baseline->ok && baseline->p50 > 0.0 )
+			{
+				std::printf( "%-13s %-10s %-6s %9zu %9zu %12.1f %12.1f %12.1f %14.4g %10s %7.2fx\n",
+					m.group, m.name, m.impl, m.size, m.reps, m.p50, m.p90, m.p99, m.itemsPerSec, megabytes[ 0 ] != '\0' ? megabytes : "-",
+					m.p50 / baseline->p50 );
+			}
+			else
+			{
+				std::printf( "%-13s %-10s %-6s %9zu %9zu %12.1f %12.1f %12.1f %14.4g %10s\n",
+					m.group, m.name, m.impl, m.size, m.reps, m.p50, m.p90, m.p99, m.itemsPerSec, megabytes[ 0 ] != '\0' ? megabytes : "-" );
+			}
+			break;
+		case output_format::csv:
+			if( m.ok )
+			{
+				std::printf( "%s,%s,%s,%zu,%zu,%zu,%.2f,%.2f,%.2f,%.2f,%.2f,%.6g,%s\n",
+					m.group, m.name, m.impl, m.size, m.samples, m.reps, m.p50, m.p90, m.p99, m.min, m.mean, m.itemsPerSec, megabytes );
+			}
+			break;
+		case output_format::json:
+			if( m.ok )
+			{
+				std::printf( "%s\n    { \"group\": \"%s\", \"op\": \"%s\", \"impl\": \"%s\", \"size\": %zu, \"samples\": %zu, \"reps\": %zu, "
+					"\"p50\": %.2f, \"p90\": %.2f, \"p99\": %.2f, \"min\": %.2f, \"mean\": %.2f, \"items_per_sec\": %.6g, \"mb_per_sec\": %s }",
+					first ? "" : ",", m.group, m.name, m.impl, m.size, m.samples, m.reps, m.p50, m.p90, m.p99, m.min, m.mean, m.itemsPerSec,
+					megabytes[ 0 ] != '\0' ? megabytes : "null" );
+			}
+			break;
+		}
+	}
+
+	void print_footer( const options& opts )
+	{
+		if( opts.format == output_format::json )
+		{
+			std::printf( "\n  ]\n}\n" );
+		}
+	}
+}
+
+int main( int argc, char** argv )
+{
+	options opts;
+	if( parse_options( argc, argv, opts ) == false )
+	{
+		std::fprintf( stderr,
+			"usage: %s [--sizes=16,256,4096,65536] [--samples=50] [--min-sample-us=200] [--filter=text] [--format=text|csv|json]\n",
+			argv[ 0 ] );
+		return 1;
+	}
+
+	print_header( opts );
+	bool first = true;
+	for( size_t i = 0; i < bench_csapi_case_count; ++i )
+	{
+		const bench_case& test = bench_csapi_cases[ i ];
+		const std::string label = std::string( test.group ) + "/" + test.name;
+		if( opts.filter.empty() == false && label.find( opts.filter ) == std::string::npos )
+		{
+			continue;
+		}
+		const bench_case* baseline = find_case( bench_std_cases, bench_std_case_count, test );
+
+		for( const size_t size : opts.sizes )
+		{
+			const measurement ours = measure( test, "csapi", size, opts );
+			if( baseline != nullptr )
+			{
+				const measurement theirs = measure( *baseline, "std", size, opts );
+				print_row( ours, &theirs, opts, first && ours.ok );
+				print_row( theirs, nullptr, opts, first && ours.ok == false );
+				first = first && ours.ok == false && theirs.ok == false;
+			}
+			else
+			{
+				print_row( ours, nullptr, opts, first );
+				first = first && ours.ok == false;
+			}
+			std::fflush( stdout );
+		}
+	}
+	print_footer( opts );
+
+	return 0;
+}
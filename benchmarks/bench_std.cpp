@@ -0,0 +1,419 @@
+#include "bench.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The standard library counterparts of bench_csapi.c, case for case, written the way
+// the equivalent C++ would normally be written.
+namespace
+{
+	const size_t seekPositions = 256;
+
+	struct string_state
+	{
+		size_t size;
+		std::string text;
+		// text with a '#' in the last position, so find scans every byte
+		std::string str;
+	};
+
+	struct stream_state
+	{
+		size_t size;
+		std::string text;
+		std::vector< char > wordBuffer;
+		std::vector< const char* > words;
+		size_t wordCount;
+		std::stringstream ss;
+		size_t positions[ seekPositions ];
+		size_t cursor;
+	};
+
+	struct vector_state
+	{
+		size_t size;
+		std::vector< uint64_t > vec;
+		uint64_t value;
+	};
+
+	struct grid_state
+	{
+		size_t size;
+		std::string text;
+		// offset and length of every word in text, the grid is words.size() by numRows
+		std::vector< std::pair< size_t, size_t > > words;
+		size_t numRows;
+		std::string grid;
+		std::string output;
+		// Only built by grid_codec_setup, text encoded and a buffer to decode into
+		std::string encoded;
+		std::string decoded;
+	};
+
+	// std::string and std::vector may keep small contents out of the heap, handing the
+	// data pointer to bench_consume stops the compiler eliding the allocations it does make
+	size_t observe( const void* data )
+	{
+		return reinterpret_cast< size_t >( data );
+	}
+
+
+	// std::string
+	void* string_setup( const size_t size )
+	{
+		try
+		{
+			string_state* state = new string_state();
+			state->size = size;
+			state->text.resize( size + 1 );
+			bench_fill_words( &state->text[ 0 ], size );
+			state->text.resize( size );
+			state->str = state->text;
+			state->str[ size - 1 ] = '#';
+			return state;
+		}
+		catch( const std::bad_alloc& )
+		{
+			return nullptr;
+		}
+	}
+	void string_teardown( void* user )
+	{
+		delete static_cast< string_state* >( user );
+	}
+	void string_construct( void* user )
+	{
+		const string_state* state = static_cast< const string_state* >( user );
+		std::string str( state->text.data(), state->size );
+		bench_consume( observe( str.data() ) );
+	}
+	void string_push_back( void* user )
+	{
+		const string_state* state = static_cast< const string_state* >( user );
+		std::string str;
+		for( size_t i = 0; i < state->size; ++i )
+		{
+			str.push_back( state->text[ i ] );
+		}
+		bench_consume( observe( str.data() ) );
+	}
+	void string_insert( void* user )
+	{
+		string_state* state = static_cast< string_state* >( user );
+		state->str.insert( state->size / 2, "0123456789abcdef", 16 );
+		state->str.resize( state->size );
+		bench_consume( state->str.size() );
+	}
+	void string_find( void* user )
+	{
+		const string_state* state = static_cast< const string_state* >( user );
+		bench_consume( state->str.find( '#' ) );
+	}
+	void string_copy( void* user )
+	{
+		const string_state* state = static_cast< const string_state* >( user );
+		std::string copy( state->str );
+		bench_consume( observe( copy.data() ) );
+	}
+
+
+	// std::stringstream
+	void* stream_setup( const size_t size )
+	{
+		try
+		{
+			stream_state* state = new stream_state();
+			state->size = size;
+			state->text.resize( size + 1 );
+			bench_fill_words( &state->text[ 0 ], size );
+			state->text.resize( size );
+			state->wordBuffer.resize( size + size / 2 + 2 );
+			state->words.resize( size / 2 + 1 );
+			state->wordCount = bench_split_words( state->text.data(), size, state->wordBuffer.data(), state->words.data() );
+			state->ss.str( state->text );
+
+			uint32_t seed = 2463534242u;
+			for( size_t i = 0; i < seekPositions; ++i )
+			{
+				seed ^= seed << 13;
+				seed ^= seed >> 17;
+				seed ^= seed << 5;
+				state->positions[ i ] = seed % size;
+			}
+			state->cursor = 0;
+			return state;
+		}
+		catch( const std::bad_alloc& )
+		{
+			return nullptr;
+		}
+	}
+	void stream_teardown( void* user )
+	{
+		delete static_cast< stream_state* >( user );
+	}
+	void stream_insert( void* user )
+	{
+		const stream_state* state = static_cast< const stream_state* >( user );
+		std::stringstream ss;
+		for( size_t i = 0; i < state->wordCount; ++i )
+		{
+			ss << state->words[ i ];
+		}
+		bench_consume( static_cast< size_t >( ss.tellp() ) );
+	}
+	void stream_extract( void* user )
+	{
+		stream_state* state = static_cast< stream_state* >( user );
+		std::string word;
+		size_t count = 0;
+
+		state->ss.clear();
+		state->ss.seekg( 0 );
+		while( state->ss >> word )
+		{
+			++count;
+		}
+		bench_consume( count );
+	}
+	void stream_seek( void* user )
+	{
+		stream_state* state = static_cast< stream_state* >( user );
+		const size_t pos = state->positions[ state->cursor++ % seekPositions ];
+
+		state->ss.clear();
+		state->ss.seekg( static_cast< std::streamoff >( pos ) );
+		bench_consume( static_cast< size_t >( state->ss.get() ) );
+	}
+
+
+	// std::vector
+	void* vector_setup( const size_t size )
+	{
+		try
+		{
+			vector_state* state = new vector_state();
+			state->size = size;
+			state->value = 0x9e3779b97f4a7c15ull;
+			state->vec.reserve( size );
+			for( uint64_t i = 0; i < size; ++i )
+			{
+				state->vec.push_back( i );
+			}
+			return state;
+		}
+		catch( const std::bad_alloc& )
+		{
+			return nullptr;
+		}
+	}
+	void vector_teardown( void* user )
+	{
+		delete static_cast< vector_state* >( user );
+	}
+	void vector_push_back( void* user )
+	{
+		const vector_state* state = static_cast< const vector_state* >( user );
+		std::vector< uint64_t > vec;
+		for( uint64_t i = 0; i < state->size; ++i )
+		{
+			vec.push_back( i );
+		}
+		bench_consume( observe( vec.data() ) );
+	}
+	void vector_reserve( void* user )
+	{
+		const vector_state* state = static_cast< const vector_state* >( user );
+		std::vector< uint64_t > vec;
+		vec.reserve( state->size );
+		for( uint64_t i = 0; i < state->size; ++i )
+		{
+			vec.push_back( i );
+		}
+		bench_consume( observe( vec.data() ) );
+	}
+	void vector_insert( void* user )
+	{
+		vector_state* state = static_cast< vector_state* >( user );
+		state->vec.insert( state->vec.begin() + static_cast< ptrdiff_t >( state->size / 2 ), state->value );
+		state->vec.pop_back();
+		bench_consume( state->vec.size() );
+	}
+	void vector_copy( void* user )
+	{
+		const vector_state* state = static_cast< const vector_state* >( user );
+		std::vector< uint64_t > copy( state->vec );
+		bench_consume( observe( copy.data() ) );
+	}
+
+
+	// word grid, column by column and row by row as the cipher describes it
+	void* grid_setup( const size_t size )
+	{
+		try
+		{
+			grid_state* state = new grid_state();
+			state->size = size;
+			state->text.resize( size + 1 );
+			bench_fill_words( &state->text[ 0 ], size );
+			state->text.resize( size );
+			state->numRows = 0;
+
+			size_t pos = 0;
+			while( pos < size )
+			{
+				const size_t end = std::min( state->text.find( ' ', pos ), size );
+				state->words.emplace_back( pos, end - pos );
+				state->numRows = std::max( state->numRows, end - pos );
+				pos = end + 1;
+			}
+			return state;
+		}
+		catch( const std::bad_alloc& )
+		{
+			return nullptr;
+		}
+	}
+	void grid_teardown( void* user )
+	{
+		delete static_cast< grid_state* >( user );
+	}
+	void grid_fill( grid_state* state )
+	{
+		const size_t numColumns = state->words.size();
+		state->grid.assign( numColumns * state->numRows, '\0' );
+		for( size_t column = 0; column < numColumns; ++column )
+		{
+			for( size_t i = 0; i < state->words[ column ].second; ++i )
+			{
+				state->grid[ column + i * numColumns ] = state->text[ state->words[ column ].first + i ];
+			}
+		}
+	}
+	void grid_transform( void* user )
+	{
+		grid_state* state = static_cast< grid_state* >( user );
+		grid_fill( state );
+		bench_consume( static_cast< size_t >( state->grid[ 0 ] ) );
+	}
+	void grid_encode( void* user )
+	{
+		grid_state* state = static_cast< grid_state* >( user );
+		grid_fill( state );
+
+		const size_t numColumns = state->words.size();
+		state->output.clear();
+		for( size_t row = 0; row < state->numRows; ++row )
+		{
+			for( size_t column = 0; column < numColumns; ++column )
+			{
+				const char c = state->grid[ row * numColumns + column ];
+				if( c != '\0' )
+				{
+					state->output.push_back( c );
+				}
+			}
+			state->output.push_back( ' ' );
+		}
+		bench_consume( state->output.size() );
+	}
+	// The words of encoded, the first words of every row being the ones that are still going
+	void grid_split_rows( const std::string& encoded, std::string& decoded )
+	{
+		std::vector< std::string > rows;
+		size_t pos = 0;
+		while( pos < encoded.size() )
+		{
+			const size_t end = std::min( encoded.find( ' ', pos ), encoded.size() );
+			rows.emplace_back( encoded, pos, end - pos );
+			pos = end + 1;
+		}
+
+		decoded.clear();
+		const size_t numColumns = rows.empty() ? 0 : rows[ 0 ].size();
+		for( size_t column = 0; column < numColumns; ++column )
+		{
+			if( column > 0 )
+			{
+				decoded.push_back( ' ' );
+			}
+			for( size_t row = 0; row < rows.size() && column < rows[ row ].size(); ++row )
+			{
+				decoded.push_back( rows[ row ][ column ] );
+			}
+		}
+	}
+	void* grid_codec_setup( const size_t size )
+	{
+		grid_state* state = static_cast< grid_state* >( grid_setup( size ) );
+		if( state != nullptr )
+		{
+			grid_encode( state );
+			state->encoded = state->output;
+		}
+		return state;
+	}
+	void grid_decode_grid( void* user )
+	{
+		grid_state* state = static_cast< grid_state* >( user );
+		const size_t numColumns = state->words.size();
+		state->decoded.clear();
+		for( size_t column = 0; column < numColumns; ++column )
+		{
+			if( column > 0 )
+			{
+				state->decoded.push_back( ' ' );
+			}
+			for( size_t row = 0; row < state->numRows; ++row )
+			{
+				const char c = state->grid[ row * numColumns + column ];
+				if( c != '\0' )
+				{
+					state->decoded.push_back( c );
+				}
+			}
+		}
+		bench_consume( state->decoded.size() );
+	}
+	void grid_decode( void* user )
+	{
+		grid_state* state = static_cast< grid_state* >( user );
+		grid_split_rows( state->encoded, state->decoded );
+		bench_consume( state->decoded.size() );
+	}
+	void grid_roundtrip( void* user )
+	{
+		grid_state* state = static_cast< grid_state* >( user );
+		grid_encode( state );
+		grid_split_rows( state->output, state->decoded );
+		bench_consume( state->decoded.size() );
+	}
+}
+
+extern "C" const bench_case bench_std_cases[] =
+{
+	{ "cstring", "construct", BENCH_ITEMS_PER_ELEMENT, string_setup, string_construct, string_teardown },
+	{ "cstring", "push_back", BENCH_ITEMS_PER_ELEMENT, string_setup, string_push_back, string_teardown },
+	{ "cstring", "insert", BENCH_ITEMS_PER_CALL, string_setup, string_insert, string_teardown },
+	{ "cstring", "find", BENCH_ITEMS_PER_ELEMENT, string_setup, string_find, string_teardown },
+	{ "cstring", "copy", BENCH_ITEMS_PER_ELEMENT, string_setup, string_copy, string_teardown },
+	{ "stringstream", "insert", BENCH_ITEMS_PER_ELEMENT, stream_setup, stream_insert, stream_teardown },
+	{ "stringstream", "extract", BENCH_ITEMS_PER_ELEMENT, stream_setup, stream_extract, stream_teardown },
+	{ "stringstream", "seek", BENCH_ITEMS_PER_CALL, stream_setup, stream_seek, stream_teardown },
+	{ "container", "push_back", BENCH_ITEMS_PER_ELEMENT, vector_setup, vector_push_back, vector_teardown },
+	{ "container", "reserve", BENCH_ITEMS_PER_ELEMENT, vector_setup, vector_reserve, vector_teardown },
+	{ "container", "insert", BENCH_ITEMS_PER_CALL, vector_setup, vector_insert, vector_teardown },
+	{ "container", "copy", BENCH_ITEMS_PER_ELEMENT, vector_setup, vector_copy, vector_teardown },
+	{ "wordgrid", "transform", BENCH_BYTES_PER_ELEMENT, grid_setup, grid_transform, grid_teardown },
+	{ "wordgrid", "encode", BENCH_BYTES_PER_ELEMENT, grid_setup, grid_encode, grid_teardown },
+	// There is no grid to skip in the plain version, the fused encoder is measured against the same code
+	{ "wordgrid", "encode_fused", BENCH_BYTES_PER_ELEMENT, grid_setup, grid_encode, grid_teardown },
+	{ "wordgrid", "decode_grid", BENCH_BYTES_PER_ELEMENT, grid_codec_setup, grid_decode_grid, grid_teardown },
+	{ "wordgrid", "decode", BENCH_BYTES_PER_ELEMENT, grid_codec_setup, grid_decode, grid_teardown },
+	{ "wordgrid", "roundtrip", BENCH_BYTES_PER_ELEMENT, grid_codec_setup, grid_roundtrip, grid_teardown },
+};
+extern "C" const size_t bench_std_case_count = sizeof( bench_std_cases ) / sizeof( bench_std_cases[ 0 ] );
@@ -0,0 +1,259 @@
+#include "customerror.h"
+#include "defines.h"
+#include "vector.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Instantiates both vector macros and checks them against plain arrays, inserting ranges taken from the
+// vector itself and erasing at both ends.  Exits with 1 when any check fails.
+
+// Longest vector the insert and erase cases build
+#define TEST_MAX_SIZE 12
+
+// Elements that own heap memory, copies must be deep and erased elements destroyed.  The macros paste T
+// after const, so a pointer element type needs a name of its own.
+typedef char* test_string;
+bool test_string_construct( test_string* elem );
+bool test_string_copy( const test_string* src, test_string* dst );
+void test_string_destroy( test_string* elem );
+
+DEFINE_VECTOR( test_ints, int )
+DEFINE_VECTOR_HOOKS( test_strings, test_string, test_string_construct, test_string_copy, test_string_destroy )
+
+static size_t g_failures = 0;
+
+// Private forward declarations
+void test_check( const char* name, const bool passed, const char* what );
+bool test_ints_fill( test_ints* vec, const size_t size );
+bool test_ints_equal( const test_ints* vec, const int* expected, const size_t size );
+void test_insert_range( const size_t size, const size_t offset, const size_t source, const size_t count, const bool outside );
+void test_erase_range( const size_t size, const size_t first, const size_t last );
+void test_strings_cases( void );
+
+int main( int argc, char* argv[] )
+{
+	( void )argc;
+	( void )argv;
+
+	// Every offset with every source range, from the vector and from a separate array
+	for( size_t size = 0; size <= 6; ++size )
+	{
+		for( size_t offset = 0; offset <= size; ++offset )
+		{
+			for( size_t source = 0; source <= size; ++source )
+			{
+				for( size_t count = 0; source + count <= size || ( size == 0 && count <= 2 ); ++count )
+				{
+					test_insert_range( size, offset, source, count, size == 0 );
+					test_insert_range( size, offset, source, count, true );
+				}
+			}
+		}
+	}
+
+	// Empty vectors, empty ranges and ranges that end at size
+	for( size_t size = 0; size <= 6; ++size )
+	{
+		for( size_t first = 0; first <= size; ++first )
+		{
+			for( size_t last = first; last <= size; ++last )
+			{
+				test_erase_range( size, first, last );
+			}
+		}
+	}
+
+	test_ints rejected;
+	test_ints_construct( &rejected );
+	err_set_result( Result_Ok );
+	test_check( "erase past the end", test_ints_erase_range( &rejected, 0, 1 ) == false && err_get_result() == Result_Index_Out_Of_Range, "was not rejected" );
+	err_set_result( Result_Ok );
+	test_check( "erase backwards", test_ints_fill( &rejected, 3 ) && test_ints_erase_range( &rejected, 2, 1 ) == false && err_get_result() == Result_Index_Out_Of_Range, "was not rejected" );
+	err_set_result( Result_Ok );
+	test_check( "insert from nullptr", test_ints_insert_range( &rejected, 0, nullptr, 1 ) == false && err_get_result() == Result_Null_Parameter, "was not rejected" );
+	test_ints_destroy( &rejected );
+
+	test_strings_cases();
+
+	if( g_failures > 0 )
+	{
+		printf( "%zu checks failed\n", g_failures );
+		return 1;
+	}
+
+	printf( "All vector checks passed\n" );
+	return 0;
+}
+
+// Public definitions
+bool test_string_construct( test_string* elem )
+{
+	*elem = nullptr;
+	return true;
+}
+bool test_string_copy( const test_string* src, test_string* dst )
+{
+	*dst = nullptr;
+	if( *src == nullptr )
+	{
+		return true;
+	}
+
+	const size_t length = strlen( *src );
+	*dst = ( char* )malloc( length + 1 );
+	if( *dst == nullptr )
+	{
+		err_set_result( Result_Bad_Alloc );
+		return false;
+	}
+	memcpy( *dst, *src, length + 1 );
+	return true;
+}
+void test_string_destroy( test_string* elem )
+{
+	free( *elem );
+	*elem = nullptr;
+}
+
+
+// Private definitions
+void test_check( const char* name, const bool passed, const char* what )
+{
+	if( passed == false )
+	{
+		printf( "FAIL %s: %s\n", name, what );
+		++g_failures;
+	}
+}
+// Elements 0 to size - 1, with the capacity exactly size so an insert has to grow and move them
+bool test_ints_fill( test_ints* vec, const size_t size )
+{
+	test_ints_clear( vec );
+	if( test_ints_reserve( vec, size ) == false )
+	{
+		return false;
+	}
+	for( size_t i = 0; i < size; ++i )
+	{
+		const int value = ( int )i;
+		if( test_ints_push_back( vec, &value ) == false )
+		{
+			return false;
+		}
+	}
+	return true;
+}
+bool test_ints_equal( const test_ints* vec, const int* expected, const size_t size )
+{
+	return test_ints_size( vec ) == size && ( size == 0 || memcmp( test_ints_begin( vec ), expected, size * sizeof( int ) ) == 0 );
+}
+void test_insert_range( const size_t size, const size_t offset, const size_t source, const size_t count, const bool outside )
+{
+	char name[ 96 ];
+	snprintf( name, sizeof( name ), "insert_range size %zu offset %zu source %zu count %zu%s", size, offset, source, count, outside ? " from an array" : "" );
+
+	// outside copies the source elements to an array first, the expected result is the same either way
+	int values[ TEST_MAX_SIZE ], expected[ TEST_MAX_SIZE ];
+	for( size_t i = 0; i < count; ++i )
+	{
+		values[ i ] = source + i < size ? ( int )( source + i ) : 100 + ( int )i;
+	}
+	for( size_t i = 0, at = 0; i < size + count; ++i )
+	{
+		expected[ i ] = i < offset ? ( int )i : i < offset + count ? values[ i - offset ] : ( int )( offset + at++ );
+	}
+
+	test_ints vec;
+	test_ints_construct( &vec );
+	bool result = test_ints_fill( &vec, size );
+	test_check( name, result, "could not fill the vector" );
+	if( result )
+	{
+		const int* from = outside ? values : test_ints_at( &vec, source );
+		result = test_ints_insert_range( &vec, offset, count > 0 ? from : nullptr, count );
+		test_check( name, result, "the insert failed" );
+	}
+	if( result )
+	{
+		test_check( name, test_ints_equal( &vec, expected, size + count ), "the elements differ from the plain insert" );
+	}
+	test_ints_destroy( &vec );
+}
+void test_erase_range( const size_t size, const size_t first, const size_t last )
+{
+	char name[ 64 ];
+	snprintf( name, sizeof( name ), "erase_range size %zu from %zu to %zu", size, first, last );
+
+	int expected[ TEST_MAX_SIZE ];
+	for( size_t i = 0; i + ( last - first ) < size; ++i )
+	{
+		expected[ i ] = ( int )( i < first ? i : i + last - first );
+	}
+
+	test_ints vec;
+	test_ints_construct( &vec );
+	bool result = test_ints_fill( &vec, size );
+	test_check( name, result, "could not fill the vector" );
+	if( result )
+	{
+		result = test_ints_erase_range( &vec, first, last );
+		test_check( name, result, "the erase failed" );
+	}
+	if( result )
+	{
+		test_check( name, test_ints_equal( &vec, expected, size - ( last - first ) ), "the elements differ from the plain erase" );
+	}
+	test_ints_destroy( &vec );
+}
+void test_strings_cases( void )
+{
+	const char* const words[] = { "zero", "one", "two", "three" };
+	const char* const inserted[] = { "zero", "one", "two", "one", "two", "three" };
+	const char* const erased[] = { "zero", "three" };
+
+	test_strings vec, copy;
+	test_strings_construct( &vec );
+	test_strings_construct( &copy );
+
+	bool result = true;
+	for( size_t i = 0; result && i < sizeof( words ) / sizeof( words[ 0 ] ); ++i )
+	{
+		test_string word = ( test_string )words[ i ];
+		result = test_strings_push_back( &vec, &word );
+	}
+	test_check( "strings", result, "could not fill the vector" );
+
+	// The copies have to be taken before the insert moves the elements they come from
+	if( result )
+	{
+		result = test_strings_insert_range( &vec, 3, test_strings_at( &vec, 1 ), 2 ) && test_strings_size( &vec ) == 6;
+		for( size_t i = 0; result && i < 6; ++i )
+		{
+			result = strcmp( *test_strings_at( &vec, i ), inserted[ i ] ) == 0;
+		}
+		test_check( "strings insert_range from the vector", result, "the elements differ" );
+	}
+	if( result )
+	{
+		result = test_strings_copy( &vec, &copy ) && test_strings_size( &copy ) == 6 && *test_strings_at( &copy, 0 ) != *test_strings_at( &vec, 0 );
+		test_check( "strings copy", result, "the copy is not deep" );
+	}
+	if( result )
+	{
+		result = test_strings_erase_range( &vec, 1, 5 ) && test_strings_erase_range( &vec, 2, 2 ) && test_strings_size( &vec ) == 2;
+		for( size_t i = 0; result && i < 2; ++i )
+		{
+			result = strcmp( *test_strings_at( &vec, i ), erased[ i ] ) == 0;
+		}
+		test_check( "strings erase_range", result, "the elements differ" );
+	}
+	if( result )
+	{
+		result = test_strings_erase_range( &vec, 0, 2 ) && test_strings_empty( &vec ) && test_strings_erase_range( &vec, 0, 0 );
+		test_check( "strings erase everything", result, "the vector is not empty" );
+	}
+
+	test_strings_destroy( &vec );
+	test_strings_destroy( &copy );
+}
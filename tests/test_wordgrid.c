@@ -0,0 +1,431 @@
+#include "cstring.h"
+#include "customerror.h"
+#include "defines.h"
+#include "fastpath.h"
+#include "threadpool.h"
+#include "tokenizer.h"
+#include "wordgrid.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Round trips of the word grid cipher.  Every message is checked in both directions: the grid against
+// wg_decode_grid and the encoding against wg_decode.  wg_encode_batch is checked against wg_encode run on
+// one message at a time and wg_transpose against a plain loop.  Exits with 1 when any check fails.
+
+// Messages in the batch case, many times the grain so chunks get stolen
+#define TEST_BATCH_MESSAGES 3000
+
+// A message split into words at whitespace, the way the encrypter splits its input
+typedef struct test_message
+{
+	const char* text;
+	size_t length;
+	token_span* words;
+	size_t numWords, numRows;
+	// The words separated by single spaces, what decoding gives back when the words keep their order
+	char* joined;
+	size_t joinedLength;
+}test_message;
+
+static size_t g_failures = 0;
+
+// Private forward declarations
+bool test_split( test_message* message, const char* text, const size_t length );
+void test_free( test_message* message );
+bool test_same( const cstring* str, const char* data, const size_t length );
+void test_check( const char* name, const bool passed, const char* what );
+void test_roundtrip( const char* name, const char* text, const size_t length );
+void test_reject( const char* name, const char* encoded );
+char* test_generate( const size_t numWords, const bool increasing, size_t* length );
+void test_batch( const char* name, const size_t threads, const size_t grain );
+void test_transpose( const size_t rows, const size_t columns, const size_t srcPadding, const size_t dstPadding );
+
+int main( int argc, char* argv[] )
+{
+	( void )argc;
+	( void )argv;
+
+	test_roundtrip( "empty", "", 0 );
+	test_roundtrip( "whitespace only", " \t\n \t", 5 );
+	test_roundtrip( "one word", "cipher", 6 );
+	test_roundtrip( "leading and trailing whitespace", " \t seven five\tone \t\t", 20 );
+	test_roundtrip( "leading and trailing whitespace, increasing", "\t\ta bb\t ccc   dddd\t", 19 );
+	test_roundtrip( "one word over a tile", "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789", 62 );
+
+	// Several 64 column panels and several 16 row tiles
+	const size_t counts[] = { 65, 200, 1000 };
+	for( size_t i = 0; i < sizeof( counts ) / sizeof( counts[ 0 ] ); ++i )
+	{
+		for( int increasing = 0; increasing < 2; ++increasing )
+		{
+			char name[ 64 ];
+			size_t length = 0;
+			char* text = test_generate( counts[ i ], increasing != 0, &length );
+			snprintf( name, sizeof( name ), "%zu words%s", counts[ i ], increasing ? ", increasing" : "" );
+			test_check( name, text != nullptr, "could not allocate the message" );
+			if( text != nullptr )
+			{
+				test_roundtrip( name, text, length );
+				free( text );
+			}
+		}
+	}
+
+	test_reject( "second row longer", "ab abc " );
+	test_reject( "later row longer", "abcd ab abc " );
+	test_reject( "last row without a space longer", "abc a ab" );
+
+	test_batch( "batch, 4 threads, grain 3", 4, 3 );
+	test_batch( "batch, 4 threads, default grain", 4, 0 );
+	test_batch( "batch, 1 thread", 1, 7 );
+
+	// Partial tiles and panels on both sides, with and without strides wider than the block
+	const size_t sides[] = { 0, 1, 5, 16, 17, 31, 64, 65, 100 };
+	for( size_t i = 0; i < sizeof( sides ) / sizeof( sides[ 0 ] ); ++i )
+	{
+		for( size_t j = 0; j < sizeof( sides ) / sizeof( sides[ 0 ] ); ++j )
+		{
+			test_transpose( sides[ i ], sides[ j ], 0, 0 );
+			test_transpose( sides[ i ], sides[ j ], 3, 19 );
+		}
+	}
+
+	if( g_failures > 0 )
+	{
+		printf( "%zu checks failed\n", g_failures );
+		return 1;
+	}
+
+	printf( "All word grid checks passed\n" );
+	return 0;
+}
+
+// Private definitions
+bool test_split( test_message* message, const char* text, const size_t length )
+{
+	delimiter_class delims;
+	dc_whitespace( &delims );
+	memset( message, 0, sizeof( test_message ) );
+
+	message->text = text;
+	message->length = length;
+	message->words = ( token_span* )malloc( ( length / 2 + 1 ) * sizeof( token_span ) );
+	message->joined = ( char* )malloc( length + 1 );
+	if( message->words == nullptr || message->joined == nullptr )
+	{
+		test_free( message );
+		return false;
+	}
+
+	size_t pos = 0;
+	token_span span = { 0 };
+	while( tok_next( &delims, text, length, &pos, &span ) )
+	{
+		if( message->numWords > 0 )
+		{
+			message->joined[ message->joinedLength++ ] = ' ';
+		}
+		memcpy( &message->joined[ message->joinedLength ], &text[ span.offset ], span.length );
+		message->joinedLength += span.length;
+
+		message->numRows = span.length > message->numRows ? span.length : message->numRows;
+		message->words[ message->numWords++ ] = span;
+	}
+
+	return true;
+}
+void test_free( test_message* message )
+{
+	free( message->words );
+	free( message->joined );
+	message->words = nullptr;
+	message->joined = nullptr;
+}
+bool test_same( const cstring* str, const char* data, const size_t length )
+{
+	return cs_len_fast( str ) == length && memcmp( cs_data_fast( str ), data, length ) == 0;
+}
+void test_check( const char* name, const bool passed, const char* what )
+{
+	if( passed == false )
+	{
+		printf( "FAIL %s: %s\n", name, what );
+		++g_failures;
+	}
+}
+void test_roundtrip( const char* name, const char* text, const size_t length )
+{
+	test_message message = { 0 }, decodedMessage = { 0 };
+	cstring encoded = { 0 }, fromGrid = { 0 }, decoded = { 0 }, reencoded = { 0 };
+	char* grid = nullptr;
+	char* regrid = nullptr;
+
+	bool result = test_split( &message, text, length );
+	test_check( name, result, "could not split the message" );
+	if( result )
+	{
+		result = cs_default_construct( &encoded ) && cs_default_construct( &fromGrid ) &&
+			cs_default_construct( &decoded ) && cs_default_construct( &reencoded );
+		grid = ( char* )malloc( message.numWords * message.numRows + 1 );
+		regrid = ( char* )malloc( message.numWords * message.numRows + 1 );
+		result = result && grid != nullptr && regrid != nullptr;
+		test_check( name, result, "could not allocate the buffers" );
+	}
+
+	// wg_decode_grid and wg_transform are inverses: the grid reads back as the words, and those words
+	// fill the same grid again
+	if( result )
+	{
+		wg_transform( text, length, message.words, message.numWords, message.numRows, grid );
+		result = wg_decode_grid( grid, message.numWords, message.numRows, &fromGrid );
+		test_check( name, result, "wg_decode_grid failed" );
+	}
+	if( result )
+	{
+		test_check( name, test_same( &fromGrid, message.joined, message.joinedLength ), "the grid does not decode to the words" );
+
+		result = test_split( &decodedMessage, cs_data_fast( &fromGrid ), cs_len_fast( &fromGrid ) );
+		test_check( name, result, "could not split the decoded grid" );
+	}
+	if( result )
+	{
+		const bool sameShape = decodedMessage.numWords == message.numWords && decodedMessage.numRows == message.numRows;
+		test_check( name, sameShape, "the decoded grid has a different shape" );
+		if( sameShape )
+		{
+			wg_transform( decodedMessage.text, decodedMessage.length, decodedMessage.words, decodedMessage.numWords, decodedMessage.numRows, regrid );
+			test_check( name, memcmp( grid, regrid, message.numWords * message.numRows ) == 0, "the decoded grid does not transform to the same grid" );
+		}
+		test_free( &decodedMessage );
+	}
+
+	// The fused encoder has to match encoding the grid
+	if( result )
+	{
+		result = wg_encode( text, length, message.words, message.numWords, message.numRows, &encoded ) &&
+			wg_encode_grid( grid, message.numWords, message.numRows, &reencoded );
+		test_check( name, result, "encoding failed" );
+	}
+	if( result )
+	{
+		test_check( name, test_same( &encoded, cs_data_fast( &reencoded ), cs_len_fast( &reencoded ) ), "wg_encode and wg_encode_grid differ" );
+		reencoded.resize( &reencoded, 0 );
+
+		result = wg_decode( cs_data_fast( &encoded ), cs_len_fast( &encoded ), &decoded );
+		test_check( name, result, "wg_decode failed" );
+	}
+
+	// Without a word longer than the one before it decoding gives back the message.  Otherwise the words
+	// may come back in another order, but they still encode to the same rows.
+	if( result )
+	{
+		bool increasing = false;
+		for( size_t i = 1; i < message.numWords; ++i )
+		{
+			increasing = increasing || message.words[ i ].length > message.words[ i - 1 ].length;
+		}
+		if( increasing == false )
+		{
+			test_check( name, test_same( &decoded, message.joined, message.joinedLength ), "decoding does not give back the message" );
+		}
+
+		result = test_split( &decodedMessage, cs_data_fast( &decoded ), cs_len_fast( &decoded ) );
+		test_check( name, result, "could not split the decoded message" );
+	}
+	if( result )
+	{
+		result = wg_encode( decodedMessage.text, decodedMessage.length, decodedMessage.words, decodedMessage.numWords, decodedMessage.numRows, &reencoded );
+		test_check( name, result, "re-encoding failed" );
+		if( result )
+		{
+			test_check( name, test_same( &reencoded, cs_data_fast( &encoded ), cs_len_fast( &encoded ) ), "the decoded message encodes to different rows" );
+		}
+		test_free( &decodedMessage );
+	}
+
+	free( grid );
+	free( regrid );
+	test_free( &message );
+	if( encoded._string != nullptr )
+	{
+		cs_destroy_cstring( &encoded );
+	}
+	if( fromGrid._string != nullptr )
+	{
+		cs_destroy_cstring( &fromGrid );
+	}
+	if( decoded._string != nullptr )
+	{
+		cs_destroy_cstring( &decoded );
+	}
+	if( reencoded._string != nullptr )
+	{
+		cs_destroy_cstring( &reencoded );
+	}
+}
+void test_reject( const char* name, const char* encoded )
+{
+	cstring output = { 0 };
+	if( cs_default_construct( &output ) == false )
+	{
+		test_check( name, false, "could not allocate the output" );
+		return;
+	}
+
+	err_set_result( Result_Ok );
+	const bool decoded = wg_decode( encoded, strlen( encoded ), &output );
+	test_check( name, decoded == false, "a row longer than the one before it was accepted" );
+	test_check( name, err_get_result() == Result_Invalid_Parameter, "the result code is not Result_Invalid_Parameter" );
+	test_check( name, cs_len_fast( &output ) == 0, "the rejected rows were written to the output" );
+
+	cs_destroy_cstring( &output );
+}
+// numWords words of 1 to 40 letters separated by a mix of spaces and tabs, with whitespace at both ends.
+// The lengths never grow unless increasing is set, then they follow a fixed pseudo random sequence.
+char* test_generate( const size_t numWords, const bool increasing, size_t* length )
+{
+	char* text = ( char* )malloc( numWords * 43 + 4 );
+	if( text == nullptr )
+	{
+		return nullptr;
+	}
+
+	uint32_t state = 12345;
+	size_t pos = 0;
+	text[ pos++ ] = '\t';
+	text[ pos++ ] = ' ';
+	for( size_t i = 0; i < numWords; ++i )
+	{
+		state = state * 1103515245 + 12345;
+		const size_t wordLength = increasing ? 1 + ( state >> 16 ) % 40 : 40 - i * 39 / numWords;
+		for( size_t j = 0; j < wordLength; ++j )
+		{
+			text[ pos++ ] = ( char )( 'a' + ( i + j ) % 26 );
+		}
+		text[ pos++ ] = i % 3 == 0 ? '\t' : ' ';
+		if( i % 7 == 0 )
+		{
+			text[ pos++ ] = ' ';
+		}
+	}
+	text[ pos++ ] = '\t';
+
+	*length = pos;
+	return text;
+}
+void test_batch( const char* name, const size_t threads, const size_t grain )
+{
+	threadpool pool = { 0 };
+	cstring expected = { 0 }, output = { 0 };
+	string_slice* messages = ( string_slice* )malloc( TEST_BATCH_MESSAGES * sizeof( string_slice ) );
+	size_t length = 0;
+	char* text = test_generate( 400, true, &length );
+
+	bool result = messages != nullptr && text != nullptr && tp_construct( &pool, threads );
+	result = result && cs_default_construct( &expected ) && cs_string_construct( &output, "replaced by the batch" );
+	test_check( name, result, "could not set up the batch" );
+
+	// Pieces of the generated text, cut anywhere, with empty and whitespace only lines mixed in and the
+	// whole text as one message that spans several panels and tiles
+	for( size_t i = 0; result && i < TEST_BATCH_MESSAGES; ++i )
+	{
+		if( i % 11 == 0 )
+		{
+			messages[ i ].data = text;
+			messages[ i ].length = 0;
+		}
+		else if( i % 17 == 0 )
+		{
+			messages[ i ].data = " \t  ";
+			messages[ i ].length = 4;
+		}
+		else if( i % 1000 == 999 )
+		{
+			messages[ i ].data = text;
+			messages[ i ].length = length;
+		}
+		else
+		{
+			const size_t offset = i * 37 % length;
+			const size_t wanted = i * 13 % 90;
+			messages[ i ].data = &text[ offset ];
+			messages[ i ].length = wanted < length - offset ? wanted : length - offset;
+		}
+	}
+
+	for( size_t i = 0; result && i < TEST_BATCH_MESSAGES; ++i )
+	{
+		test_message message = { 0 };
+		result = test_split( &message, messages[ i ].data, messages[ i ].length ) &&
+			wg_encode( message.text, message.length, message.words, message.numWords, message.numRows, &expected ) &&
+			expected.push_back( &expected, '\n' );
+		test_free( &message );
+		test_check( name, result, "could not encode the messages one at a time" );
+	}
+
+	// Stealing changes which worker encodes which chunk from run to run, the output order must not change
+	for( size_t run = 0; result && run < 20; ++run )
+	{
+		result = wg_encode_batch( &pool, messages, TEST_BATCH_MESSAGES, grain, &output );
+		test_check( name, result, "wg_encode_batch failed" );
+		if( result )
+		{
+			result = test_same( &output, cs_data_fast( &expected ), cs_len_fast( &expected ) );
+			test_check( name, result, "the batch differs from encoding the messages in order" );
+		}
+	}
+
+	if( pool.pdata != nullptr )
+	{
+		tp_destroy( &pool );
+	}
+	if( expected._string != nullptr )
+	{
+		cs_destroy_cstring( &expected );
+	}
+	if( output._string != nullptr )
+	{
+		cs_destroy_cstring( &output );
+	}
+	free( messages );
+	free( text );
+}
+void test_transpose( const size_t rows, const size_t columns, const size_t srcPadding, const size_t dstPadding )
+{
+	char name[ 64 ];
+	snprintf( name, sizeof( name ), "transpose %zu by %zu, padding %zu and %zu", rows, columns, srcPadding, dstPadding );
+
+	// The destination starts out as '#' so bytes written past the block show up
+	const size_t srcStride = columns + srcPadding;
+	const size_t dstStride = rows + dstPadding;
+	char* src = ( char* )malloc( rows * srcStride + 1 );
+	char* dst = ( char* )malloc( columns * dstStride + 1 );
+	char* expected = ( char* )malloc( columns * dstStride + 1 );
+	const bool allocated = src != nullptr && dst != nullptr && expected != nullptr;
+	test_check( name, allocated, "could not allocate the blocks" );
+	if( allocated )
+	{
+		for( size_t i = 0; i < rows * srcStride; ++i )
+		{
+			src[ i ] = ( char )( i * 7 + 3 );
+		}
+		memset( dst, '#', columns * dstStride );
+		memset( expected, '#', columns * dstStride );
+		for( size_t r = 0; r < rows; ++r )
+		{
+			for( size_t c = 0; c < columns; ++c )
+			{
+				expected[ c * dstStride + r ] = src[ r * srcStride + c ];
+			}
+		}
+
+		wg_transpose( src, srcStride, dst, dstStride, rows, columns );
+		test_check( name, memcmp( dst, expected, columns * dstStride ) == 0, "differs from the plain transpose" );
+	}
+
+	free( src );
+	free( dst );
+	free( expected );
+}